@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""
+load generator for gocr --serve=socket (v0.53)
+
+ usage: gocr_load.py [-c clients] [-n requests] [-o "options"] socket images..
+
+ example:
+   gocr -m 2 -p ./db/ --serve=/tmp/gocr.sock &
+   bin/gocr_load.py -c 4 -n 50 /tmp/gocr.sock examples/*.pgm
+
+ every client opens one connection and sends n requests (images in turn),
+ output: latency (min, median, 90%, 99%, max) and throughput
+"""
+
+import socket
+import sys
+import threading
+import time
+import getopt
+
+
+def recv_answer(f):
+    hdr = f.readline()
+    if not hdr:
+        raise IOError("connection closed")
+    tag, n = hdr.split()
+    text = f.read(int(n))
+    return tag.decode(), text
+
+
+def client(path, images, nreq, opts, times, errors):
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect(path)
+    f = s.makefile("rwb")
+    for i in range(nreq):
+        img = images[i % len(images)]
+        t0 = time.time()
+        f.write(("pnm %d %s\n" % (len(img), opts)).encode())
+        f.write(img)
+        f.flush()
+        tag, text = recv_answer(f)
+        times.append(time.time() - t0)
+        if tag != "ok":
+            errors.append(text)
+    f.write(b"quit\n")
+    f.flush()
+    s.close()
+
+
+def percentile(v, p):
+    return v[min(len(v) - 1, int(p * len(v)))]
+
+
+def main():
+    nclients, nreq, opts = 1, 10, ""
+    o, args = getopt.getopt(sys.argv[1:], "c:n:o:h")
+    for k, v in o:
+        if k == "-c": nclients = int(v)
+        if k == "-n": nreq = int(v)
+        if k == "-o": opts = v
+        if k == "-h": args = []
+    if len(args) < 2:
+        print(__doc__)
+        sys.exit(1)
+    images = [open(name, "rb").read() for name in args[1:]]
+    times, errors = [], []
+    threads = [threading.Thread(target=client,
+                                args=(args[0], images, nreq, opts,
+                                      times, errors))
+               for i in range(nclients)]
+    t0 = time.time()
+    for t in threads: t.start()
+    for t in threads: t.join()
+    total = time.time() - t0
+    times.sort()
+    if not times:
+        print("no answers")
+        sys.exit(1)
+    print("# clients=%d requests=%d errors=%d time=%.3fs"
+          % (nclients, len(times), len(errors), total))
+    print("# latency/ms min=%.1f 50%%=%.1f 90%%=%.1f 99%%=%.1f max=%.1f"
+          % tuple(1000 * x for x in (times[0], percentile(times, 0.5),
+                  percentile(times, 0.9), percentile(times, 0.99),
+                  times[-1])))
+    print("# throughput=%.2f requests/s" % (len(times) / total))
+    for e in errors[:3]:
+        print("# error: %s" % e.decode(errors="replace"))
+
+
+if __name__ == "__main__":
+    main()
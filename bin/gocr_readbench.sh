@@ -0,0 +1,35 @@
+#!/bin/bash
+# benchmark of the image input (v0.53), time per file of small images
+#  for the in-process decoders (png, jpeg, gz) against the external
+#  converters (pngtopnm, djpeg, gzip -cd), the difference to the
+#  uncompressed pnm file is the cost of the input path
+#
+# example:
+#  ./configure --without-png --without-jpeg --without-zlib; make
+#  cp src/gocr /tmp/gocr_popen
+#  ./configure; make
+#  bin/gocr_readbench.sh -n 50 src/gocr /tmp/gocr_popen -- \
+#    examples/x.pgm examples/x.pgm.gz examples/x.png
+#
+# output: ms per call for every program and file
+#
+N=20            # calls per file
+if test "$1" = "-n"; then N=$2; shift; shift; fi
+progs=""
+while test $# -gt 0 -a "$1" != "--"; do progs="$progs $1"; shift; done
+if test "$1" = "--"; then shift; fi
+if test -z "$progs" -o $# -eq 0; then
+  echo "$0 [-n calls] gocr [gocr2 ...] -- files..."; exit 1
+fi
+for f in "$@"; do
+  for g in $progs; do
+    $g -i "$f" >/dev/null 2>&1 || echo "# $g -i $f failed"
+    t0=$(date +%s%N)
+    i=0; while test $i -lt $N; do
+      $g -i "$f" >/dev/null 2>&1; i=$((i+1))
+    done
+    t1=$(date +%s%N)
+    us=$(( (t1 - t0) / 1000 / N ))
+    printf "%-24s %-32s %5d.%02d ms\n" "$g" "$f" $((us/1000)) $((us%1000/10))
+  done
+done
@@ -18,20 +18,41 @@
 /* Define if you have the popen function.  */
 #define HAVE_POPEN 1
 
+/* Define if you have the fork function.  */
+#define HAVE_FORK 1
+
 /* Define if you have the wcschr function.  */
 #define HAVE_WCSCHR 1
 
 /* Define if you have the wcsdup function.  */
 #define HAVE_WCSDUP 1
 
+/* Define if you have the <jpeglib.h> header file.  */
+/* #undef HAVE_JPEGLIB_H */
+
 /* Define if you have the <pam.h> header file.  */
 /* #undef HAVE_PAM_H */
 
+/* Define if you have the <png.h> header file.  */
+/* #undef HAVE_PNG_H */
+
 /* Define if you have the <pnm.h> header file.  */
 /* #undef HAVE_PNM_H */
 
+/* Define if you have the <pthread.h> header file.  */
+/* #undef HAVE_PTHREAD_H */
+
+/* Define if you have the <sys/socket.h> header file.  */
+#define HAVE_SYS_SOCKET_H 1
+
+/* Define if you have the <sys/un.h> header file.  */
+#define HAVE_SYS_UN_H 1
+
 /* Define if you have the <unistd.h> header file.  */
 #define HAVE_UNISTD_H 1
 
 /* Define if you have the <wchar.h> header file.  */
 #define HAVE_WCHAR_H 1
+
+/* Define if you have the <zlib.h> header file.  */
+/* #undef HAVE_ZLIB_H */
@@ -48,8 +48,16 @@ gcc %OPT% -o ah.o -c src\unicode.c
 gcc %OPT% -o ai.o -c src\barcode.c
 gcc %OPT% -o aj.o -c src\job.c
 gcc %OPT% -o ak.o -c src\progress.c
+gcc %OPT% -o al.o -c src\boxgrid.c
+gcc %OPT% -o am.o -c src\serve.c
+gcc %OPT% -o an.o -c src\readimg.c
+gcc %OPT% -o ao.o -c src\band.c
+gcc %OPT% -o ap.o -c src\pipeline.c
+gcc %OPT% -o aq.o -c src\batch.c
+gcc %OPT% -o ar.o -c src\tpool.c
+gcc %OPT% -o as.o -c src\norm.c
 REM having only 128 byte for command line is terrible (concatenate?)
-gcc -o gocr.exe a1.o a2.o a3.o a4.o a5.o a6.o a7.o a8.o a9.o aa.o ab.o ac.o ad.o ae.o af.o ag.o ah.o ai.o aj.o ak.o
+gcc -o gocr.exe a1.o a2.o a3.o a4.o a5.o a6.o a7.o a8.o a9.o aa.o ab.o ac.o ad.o ae.o af.o ag.o ah.o ai.o aj.o ak.o al.o am.o an.o ao.o ap.o aq.o ar.o as.o
 @if exist gocr.exe del *.o
 @if exist gocr.exe strip gocr.exe
 rem pkzip gocrexe gocr.exe gocr.tcl README 
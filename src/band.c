@@ -0,0 +1,186 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2019  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ band mode (gocr --band[=rows]), v0.53
+   the page is recognized in horizontal bands of about rows pixel rows,
+   every band is cut at white rows between text lines and goes through
+   pgm2asc() as an image of its own, the text is printed and the band
+   is freed before the next one is read
+   raw pnm (P4 P5 P6, also from stdin) is read band by band, so the
+   memory depends on width*rows and not on the height of the page,
+   other formats are read at once and only the engine memory is bounded
+   boxes and lines are moved to the rows of the page before the output
+   (norm_restore), -f XML prints one page for all bands
+
+   pdftoppm -r 600 -gray x.pdf | gocr --band -
+
+ ToDo: a text line without white row above or below is cut
+       (rows of the window), the first image of a file only
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pnm.h"
+#include "pgm2asc.h"
+#include "gocr.h"
+#include "otsu.h"
+
+#define BAND_MIN 64  /* rows, smaller bands cut text lines too often */
+
+/* source of image rows, raw pnm file or a page read at once */
+typedef struct band_src_s {
+  pnm_rows_t rows;  /* rows.f1 != NULL: read from the file */
+  pix page;         /* else the page */
+  int y;            /* next row of page */
+} band_src_t;
+
+static int src_read(band_src_t *s, unsigned char *dst, int n) {
+  if (s->rows.f1) return pnm_rows_read(&s->rows, dst, n);
+  if (n > s->page.y - s->y) n = s->page.y - s->y;
+  if (n <= 0) return 0;
+  memcpy(dst, s->page.p + (size_t)s->y * s->page.x, (size_t)n * s->page.x);
+  s->y += n;
+  return n;
+}
+
+/* a row is white, if it has less than 1 dark pixel of 512 (dust) */
+static int white_row(unsigned char *row, int x, int cs, int inv) {
+  int i, n = 0, nmax = x / 512;
+  if (inv) { for (i = 0; i < x; i++) if (255 - row[i] < cs) n++; }
+  else     { for (i = 0; i < x; i++) if (row[i] < cs) n++; }
+  return (n <= nmax);
+}
+
+/* middle of the widest white gap of rows y0..y1-1 (the lowest of equal
+ *  gaps), or y1 if there is none, gaps within a text line (i-dots,
+ *  umlauts) are smaller than the gaps between lines */
+static int find_cut(unsigned char *buf, int x, int y0, int y1,
+                    int cs, int inv) {
+  int y, y2 = -1, best = 0, cut = y1;
+  for (y = y0; y <= y1; y++) {
+    if (y < y1 && white_row(buf + (size_t)y * x, x, cs, inv)) {
+      if (y2 < 0) y2 = y;  /* start of a gap */
+      continue;
+    }
+    if (y2 >= 0 && y - y2 >= best) { best = y - y2; cut = (y2 + y) / 2; }
+    y2 = -1;
+  }
+  return cut;
+}
+
+/* recognize the rows of band as image of its own and print the text */
+static void band_ocr1(job_t *job, unsigned char *band, int x, int y,
+                      int y0, int *line0) {
+  job_init_image(job);
+  job->src.p.p = band; /* freed by job_free_image */
+  job->src.p.x = x;
+  job->src.p.y = y;
+  job->src.p.bpp = 1;
+  job->src.num_image = 0; /* use -l for every band */
+  job->src.band = 1;      /* one XML page for all bands */
+  job->src.y0 = y0;       /* rows of the page in the output */
+  job->src.line0 = *line0;
+  if (job->cfg.verbose)
+    fprintf(stderr, "# band y=%d..%d\n", y0, y0 + y - 1);
+  pgm2asc(job);
+  if (job->res.lines.num > 1) *line0 += job->res.lines.num - 1; /* 0=dummy */
+  print_output(job);
+  job_free_image(job);
+}
+
+/* main loop of gocr --band, returns 0 or -1 on error */
+int band_ocr(job_t *job, int rows) {
+  band_src_t src;
+  job_t job0;  /* only job0.cfg is used, it is restored for every band */
+  unsigned char *buf = NULL, *band, *tmp;
+  int x, cap, filled = 0, n, cut, eof = 0, y0 = 0, cs, inv = 0, rc,
+      line0 = 0;
+
+  if (rows < BAND_MIN) rows = BAND_MIN;
+  memset(&src, 0, sizeof(src));
+  rc = pnm_rows_open(&src.rows, &job->src.stream, job->src.fname,
+                     job->cfg.verbose);
+  if (rc < 0) return -1;
+  if (rc > 0) { /* not a raw pnm, read it at once */
+    if (readpgm_stream(&job->src.stream, job->src.fname, &src.page,
+                       job->cfg.verbose) < 0) return -1;
+    pnm_stream_close(&job->src.stream); /* first image only */
+    x = src.page.x;
+  } else x = src.rows.x;
+
+  cap = 2 * rows; /* window, bands end at row rows/2..3*rows/2 or eof */
+  buf = (unsigned char *)malloc((size_t)x * cap);
+  if (!buf) {
+    fprintf(stderr, "ERROR band: no memory for %d rows\n", cap);
+    pnm_rows_close(&src.rows); free(src.page.p); return -1;
+  }
+  job0.cfg = job->cfg;
+  cs = job->cfg.cs;
+  if (job->cfg.out_format == XML) /* see store_boxtree_lines() */
+    printf("<page x=\"%d\" y=\"%d\" dx=\"%d\" dy=\"%d\">\n"
+           "<block x=\"%d\" y=\"%d\" dx=\"%d\" dy=\"%d\">\n",
+           0, 0, 0, 0, 0, 0, 0, 0);
+  for (;;) {
+    if (!eof) {
+      n = src_read(&src, buf + (size_t)filled * x, cap - filled);
+      if (n < cap - filled) eof = 1;
+      filled += n;
+    }
+    if (filled == 0) break;
+    if (cs == 0) { /* like pgm2asc: otsu of the 1st window, may invert */
+      tmp = (unsigned char *)malloc((size_t)x * filled);
+      if (tmp) {
+        memcpy(tmp, buf, (size_t)x * filled);
+        cs = otsu(tmp, x, filled, 0, 0, x, filled, 0);
+        inv = (memcmp(tmp, buf, (size_t)x * filled) != 0);
+        free(tmp);
+      } else cs = 128;
+    }
+    /* keep rows/2 rows behind the cut, the page may end after them and
+     *  a short last band alone gives garbage (eof is not known before) */
+    cut = (eof) ? filled
+                : find_cut(buf, x, rows / 2, filled - rows / 2, cs, inv);
+    if (cut == filled - rows / 2 && !eof && job->cfg.verbose)
+      fprintf(stderr, "# band: no white row at y=%d..%d, cut\n",
+        y0 + rows / 2, y0 + cut - 1);
+    for (n = 0; n < cut; n++) /* skip white bands, no boxes */
+      if (!white_row(buf + (size_t)n * x, x, cs, inv)) break;
+    if (n < cut) {
+      band = (unsigned char *)malloc((size_t)x * cut);
+      if (!band) {
+        fprintf(stderr, "ERROR band: no memory for %d rows\n", cut); break; }
+      memcpy(band, buf, (size_t)x * cut);
+      job->cfg = job0.cfg;
+      band_ocr1(job, band, x, cut, y0, &line0);
+    }
+    filled -= cut;
+    memmove(buf, buf + (size_t)x * cut, (size_t)x * filled);
+    y0 += cut;
+  }
+  job->cfg = job0.cfg;
+  if (job->cfg.out_format == XML) printf("</block>\n</page>\n");
+  free(buf);
+  pnm_rows_close(&src.rows);
+  free(src.page.p);
+  return (filled == 0) ? 0 : -1;
+}
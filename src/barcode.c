@@ -38,7 +38,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #undef g_debug
 #if DO_DEBUG
-# define g_debug(a)  if (OCR_JOB->cfg.verbose&1) { a }
+# define g_debug(a)  if (job->cfg.verbose&1) { a }  /* needs job_t *job */
 #else
 # define g_debug(a)
 #endif
@@ -54,7 +54,7 @@ static double sqr(double x) { return(x*x); }  /* static inline ? MACRO ? */
 /* ----------------------------- code128 ---------------------------- *
  *    "BSBSBS", B=Bar, S=Space, better using 2*6=12bit-integer?       */
 #define Num128 107
-const char *code128[Num128+1]={ /* can be generated by an algorithm? */
+const char *const code128[Num128+1]={ /* can be generated by an algorithm? */
 /* 00 */"212222","222122","222221","121223","121322","131222","122213","122312",
 /* 08 */"132212","221213","221312","231212","112232","122132","122231","113222",
 /* 16 */"123122","123221","223211","221132","221231","213212","223112","312131",
@@ -97,7 +97,7 @@ const char *code128[Num128+1]={ /* can be generated by an algorithm? */
   /* example: barcode -E -e 128b -b 14Test41         >a.eps */
   /* example: barcode -E -e 128raw -b 105 17 14 30   >a.eps */
 
-char *decode_code128(int *wb, int num_bars){
+char *decode_code128(job_t *job, int *wb, int num_bars){
   int i, w, i1, i2, i3=0, i4, i5=0, crc, mode=1;
   int minB, maxB, minS, maxS; /* min/max bars/spaces sample: 3-10 1-8 */
   int wb6[6], addS, addB; /* normalized bars, normalization summand */
@@ -214,14 +214,14 @@ char *decode_code128(int *wb, int num_bars){
   /* example: barcode -E -e upc -b 12345678901   >a.eps # ok */
   /* example: barcode -E -e ean -b 123456789012  >a.eps # ok */
 #define NumUPC 20
-const char *codeUPC[NumUPC+1]={ /* 0..9, first n = SBSB, last n = BSBS */
+const char *const codeUPC[NumUPC+1]={ /* 0..9, first n = SBSB, last n = BSBS */
   "3211","2221","2122","1411","1132", /* 0,1,2,3,4 normal   (+0bit) */
   "1231","1114","1312","1213","3112", /* 5,6,7,8,9 */
   "1123","1222","2212","1141","2311", /* 0,1,2,3,4 mirrored (+1bit) */
   "1321","4111","2131","3121","2113", /* 5,6,7,8,9 */
   "????"}; /* not found */
 
-char *decode_UPC(int *wb, int num_bars){ /* ToDo: char *dest, int len */
+char *decode_UPC(job_t *job, int *wb, int num_bars){ /* ToDo: char *dest, int len */
   int i, w, i1, i2, i3, i5, crc, mirrored, ean;
   double err, min_err, dw, dww=0.0;  char digit;
   char *result=NULL, *buf=NULL; /* malloc and store the result */
@@ -291,7 +291,7 @@ char *decode_UPC(int *wb, int num_bars){ /* ToDo: char *dest, int len */
      * guard bar BSB, followed by ([digit + SB] * (N-1)) + digit. Digit is
      * SBSB.  Two digit add-on's have 7 bars, and 5 digit add ons have 16.
      */
-char *decode_UPC_addon(int *wb, int num_bars){ /* ToDo: char *dest, int len */
+char *decode_UPC_addon(job_t *job, int *wb, int num_bars){ /* ToDo: char *dest, int len */
   int i, w, i1, i2, i3, i5, digits=num_bars/3;
   double err, min_err, dw, dww=0.0;  char digit;
   char *result=NULL, *buf=NULL; /* malloc and store the result */
@@ -360,7 +360,7 @@ char *decode_UPC_addon(int *wb, int num_bars){ /* ToDo: char *dest, int len */
  *  sample 090916: width of wide space may be smaller than narrow bar
  */
 #define Num39 (40+4) /* (3of9)=(2of5)(1of4)+(0of5)(3of4), (2of5)(.-..)=0..9 */
-const char *code39= /* rearranged to BBBBBSSSS<S> (bars,spaces) */
+const char *const code39= /* rearranged to BBBBBSSSS<S> (bars,spaces) */
                                                 "0..--..-.."
 "1-...-.-..""2.-..-.-..""3--....-..""4..-.-.-..""5-.-...-.."
 "6.--...-..""7...--.-..""8-..-..-..""9.-.-..-.."
@@ -387,7 +387,7 @@ void sort(int *value, int *idx, int len){
   } 
 }
 
-char *decode_39(int *wb, int num_bars){ /* ToDo: char *dest, int len */
+char *decode_39(job_t *job, int *wb, int num_bars){ /* ToDo: char *dest, int len */
   int i, w, i1, i3, i5, crc,
       idx[9], /* indices sorted by length of wb9[idx] */
       wb9[9], /* next 9 normalized bars and spaces BWBWBWBWB (JS1002) */
@@ -487,7 +487,7 @@ char *decode_39(int *wb, int num_bars){ /* ToDo: char *dest, int len */
     Len = (numChars*(2*(sizeW/sizeN)+3) + 6 + (sizeW/sizeN)) * sizeN
  */
 #define Num25 10
-const char *code25= /* is the code sorted randomly? */
+const char *const code25= /* is the code sorted randomly? */
 "1-...-2.-..-3--...4..-.-5-.-..6.--..7...--8-..-.9.-.-.0..--.";
 
 /* example: barcode -E -e i25 -b 123456 >a.eps */
@@ -496,7 +496,7 @@ const char *code25= /* is the code sorted randomly? */
    add i25, patch by: Chris Lee, 13 Jul 2009
    ToDo: check correctness
  */
-char *decode_i25(int *wb, int num_bars){ /* ToDo: char *dest, int len */
+char *decode_i25(job_t *job, int *wb, int num_bars){ /* ToDo: char *dest, int len */
   int i, w, i1, i3, i5, crc, idx[7], pos;
   double dw, dww, err;  char *buf;
   char *result=NULL; /* malloc and store the result */
@@ -612,7 +612,7 @@ char *decode_i25(int *wb, int num_bars){ /* ToDo: char *dest, int len */
    wiki-sample: a31117013206375b (wide spaces between chars) schraeg!
    barcode:     t1234567t  n=N=1 w=W=3 c=12,14 (not const.)
  */
-const char *code27= /* 4bars+3spaces, 12+12 chars */
+const char *const code27= /* 4bars+3spaces, 12+12 chars */
 //  0..11: 3 nbar + 1 wbar + 2 nspace + 1 wspace
 "0.....--1....--.2...-..-3--.....4..-..-."                  
 "5-....-.6.-....-7.-..-..8.--....9-..-...-...--..$..--..."
@@ -625,7 +625,7 @@ const char *code27= /* 4bars+3spaces, 12+12 chars */
 
 /* example: barcode -E -e cbr -b 123456 >a.eps */
 
-char *decode_27(int *wb, int num_bars){ /* ToDo: char *dest, int len */
+char *decode_27(job_t *job, int *wb, int num_bars){ /* ToDo: char *dest, int len */
   int i, i1, i2, i3, i4, i5, b_idx[4], s_idx[3], b_w[4], s_w[3],
       max_wdiff; 
 #if DO_DEBUG
@@ -723,8 +723,7 @@ char *decode_27(int *wb, int num_bars){ /* ToDo: char *dest, int len */
     ToDo: - like storing sequence of widths for 1D code
             store array of bits for 2D matrix code and decode later
  */
-char *decode_barcode(struct box *bb){ /* ToDo: char *dest, int len */
-  job_t *job=OCR_JOB; /* fixme */
+char *decode_barcode(job_t *job, struct box *bb){ /* ToDo: char *dest, int len */
   int i, num_bars, yy, w, ww, dx, xx, cs=job->cfg.cs, *wb;
   char *result=NULL; /* store the result */
   yy=(bb->y0+bb->y1)/2;
@@ -751,29 +750,29 @@ char *decode_barcode(struct box *bb){ /* ToDo: char *dest, int len */
    */
   /* test code128 characteristics, ToDo: look for correct start/stop 211 seq. */
   if ((num_bars-1)%3==0 && num_bars>=10 && ww>=11*(num_bars-1)/3+2){
-    if (!result) result=decode_code128(wb,num_bars);
+    if (!result) result=decode_code128(job,wb,num_bars);
   }
   /* test UPC/EAN characteristics */
   if ((num_bars)%2==0 && num_bars>=8 && ww>=7*(num_bars-6)/2+11
   && ((num_bars-6)/2)%2==0){  /* should be balanced */
-    if (!result) result=decode_UPC(wb,num_bars);
+    if (!result) result=decode_UPC(job,wb,num_bars);
   }
   /* test UPC_addon by Michael van Rooyen, often on books */
   if (num_bars==7 || num_bars==16)
-    if (!result) result=decode_UPC_addon(wb,num_bars);
+    if (!result) result=decode_UPC_addon(job,wb,num_bars);
 
   /* test code39 characteristics */
   if ((num_bars)%5==0 && num_bars>14){
-    if (!result) result=decode_39(wb,num_bars);
+    if (!result) result=decode_39(job,wb,num_bars);
   }
   /* test i2of5 chartacteristics */
   if ((num_bars)%5==4 && num_bars>3) {
-    if (!result) result=decode_i25(wb,num_bars);
+    if (!result) result=decode_i25(job,wb,num_bars);
   }
 
   /* test codabar chartacteristics */
   if ((num_bars)%4==0 && num_bars>3) {
-    if (!result) result=decode_27(wb,num_bars);
+    if (!result) result=decode_27(job,wb,num_bars);
   }
 
   free(wb);
@@ -813,8 +812,6 @@ struct _RS {
   int gfpoly;
 };
 
-static struct _RS rs;
-
 #if 0  
 static int GF256_mult(int a, int b) {  // a*b
   int i, r=0, t=b; // result + temp var
@@ -853,24 +850,24 @@ static int modnn(struct _RS *rs, int x){
   }
   return x;
 }
-static void init_rs(int symsize, int gfpoly, int fcr,
-                    int prim, int nroots, int pad) {
+static void init_rs(job_t *job, struct _RS *rs, int symsize, int gfpoly,
+                    int fcr, int prim, int nroots, int pad) {
   int i,j,x,root,iprim;
-  rs.mm= symsize;
-  rs.nn= (1<<symsize)-1;
-  rs.pad= pad;
-  rs.nroots= nroots;
+  rs->mm= symsize;
+  rs->nn= (1<<symsize)-1;
+  rs->pad= pad;
+  rs->nroots= nroots;
 
   g_debug(fprintf(stderr,"\n# init_rs symsize= %d gfpoly=0x%04x necc= %4d\n# ",
      symsize, gfpoly, nroots);)
   /* Generate Galois field lookup tables using
    *  primitive field generator polynomial gfpoly */
-  rs.alpha_log[0]= rs.nn; // nn=255, log(0) = -inf
-  rs.alpha_exp[rs.nn]= 0; // alha^(-inf) = 0
+  rs->alpha_log[0]= rs->nn; // nn=255, log(0) = -inf
+  rs->alpha_exp[rs->nn]= 0; // alha^(-inf) = 0
   x=1;
   for (i=0; i<255; i++) {
-    rs.alpha_log[x] = i;
-    rs.alpha_exp[i] = x;
+    rs->alpha_log[x] = i;
+    rs->alpha_exp[i] = x;
     x <<= 1; if (x >= 0x100) { x ^= gfpoly; }
     // g_debug(fprintf(stderr," %3d",x);)
   }
@@ -878,47 +875,48 @@ static void init_rs(int symsize, int gfpoly, int fcr,
   // for (i=0; i<256; i++)
   //   printf(" i a^i loga(i) %3d %3d %3d\n", i, alpha_exp[i], alpha_log[i]);
   /* Form RS code generator polynomial from its roots */
-  /* Find prim-th root of 1, used in decoding, prim=1, rs.nn=255, iprim=1 */
-  for(iprim=1; (iprim % prim) != 0; iprim += rs.nn);
-  rs.iprim = iprim / prim;
-  rs.genpoly[0]=1; // alpha0*x^nroot + ...
+  /* Find prim-th root of 1, used in decoding, prim=1, rs->nn=255, iprim=1 */
+  for(iprim=1; (iprim % prim) != 0; iprim += rs->nn);
+  rs->iprim = iprim / prim;
+  rs->genpoly[0]=1; // alpha0*x^nroot + ...
   for (i = 0, root=fcr*prim; i < nroots; i++, root += prim) {
-    rs.genpoly[i+1] = 1;
-    /* Multiply rs.genpoly[] by  alpha^(root + x) */
+    rs->genpoly[i+1] = 1;
+    /* Multiply rs->genpoly[] by  alpha^(root + x) */
     for (j = i; j > 0; j--){
-      if (rs.genpoly[j] != 0)
-        rs.genpoly[j] = rs.genpoly[j-1] ^ rs.alpha_exp[
-                                modnn(&rs,rs.alpha_log[rs.genpoly[j]] + root)];
+      if (rs->genpoly[j] != 0)
+        rs->genpoly[j] = rs->genpoly[j-1] ^ rs->alpha_exp[
+                                modnn(rs,rs->alpha_log[rs->genpoly[j]] + root)];
       else
-        rs.genpoly[j] = rs.genpoly[j-1];
+        rs->genpoly[j] = rs->genpoly[j-1];
     }
-    /* rs.genpoly[0] can never be zero */   
-    rs.genpoly[0] = rs.alpha_exp[modnn(&rs,rs.alpha_log[rs.genpoly[0]] + root)];
+    /* rs->genpoly[0] can never be zero */   
+    rs->genpoly[0] = rs->alpha_exp[modnn(rs,rs->alpha_log[rs->genpoly[0]] + root)];
   }
 #if DO_DEBUG
-  if (OCR_JOB->cfg.verbose&1) {
+  if (job->cfg.verbose&1) {
     int i;
     for (i=0; i <= nroots; i++)
       fprintf(stderr,"%3d ", i);
     fprintf(stderr,"\n# ");
     for (i=0; i <= nroots; i++)
-      fprintf(stderr,"%3d ", rs.genpoly[i]);  // coefficient * x^i
+      fprintf(stderr,"%3d ", rs->genpoly[i]);  // coefficient * x^i
     fprintf(stderr,"\n# ");
    }
 #endif
-  /* convert rs.genpoly[] to index form for quicker encoding */
+  /* convert rs->genpoly[] to index form for quicker encoding */
   for (i = 0; i <= nroots; i++)
-    rs.genpoly[i] = rs.alpha_log[rs.genpoly[i]];
+    rs->genpoly[i] = rs->alpha_log[rs->genpoly[i]];
 #if DO_DEBUG
-  if (OCR_JOB->cfg.verbose&1) {
+  if (job->cfg.verbose&1) {
     int i;
     for (i=0; i <= nroots; i++)
-      fprintf(stderr,"%3d ", rs.genpoly[i]); // exponent i of alpha^i
+      fprintf(stderr,"%3d ", rs->genpoly[i]); // exponent i of alpha^i
     fprintf(stderr,"\n# ");
    }
 #endif
 }
-void encode_rs_char(struct _RS *rs, const uchar *data, uchar *parity) {
+void encode_rs_char(job_t *job, struct _RS *rs,
+                    const uchar *data, uchar *parity) {
   int i, j; uchar feedback;
   memset(parity,0,rs->nroots*sizeof(uchar));
 
@@ -940,7 +938,7 @@ void encode_rs_char(struct _RS *rs, const uchar *data, uchar *parity) {
       parity[rs->nroots-1] = 0;
   }
 #if DO_DEBUG
-  if (OCR_JOB->cfg.verbose&1) {
+  if (job->cfg.verbose&1) {
     int i;
     fprintf(stderr,"\n# ecc\n# ");
     for (i=0; i <= rs->nroots; i++)
@@ -962,11 +960,14 @@ int detect_barcode(job_t *job)
      nbars, x0, y0, dx, dy, cs, x, y, yl0, yl1, yr0, yr1,
      regx, regy; // regions for 2D barcode
   struct box *box2, *box3;
+  struct box **nb=NULL; /* near boxes, from job->tmp.boxgrid */
+  int i, n, nnb=0, seq;
 
   if(job->cfg.verbose) 
     fprintf(stderr,"# barcode.c detect_barcode ");
   x0=y0=0; rm=0; dx=job->src.p.x;  dy=job->src.p.y; cs=job->cfg.cs;
   bdx=0; bdy=0;
+  box_grid_build(&job->tmp.boxgrid, job);
   for_each_data(&(job->res.boxlist)) {
     box2 = (struct box *)list_get_current(&(job->res.boxlist));
     /* detect width (bdx) and height (bdy) of possible bar */
@@ -992,9 +993,12 @@ int detect_barcode(job_t *job)
         * this is important, because bar-boxes are not in right order */
        for (j2=1;j2;) {
          j2=0;
-         /* expand a frame around the potential barcode (bx0,by0,bx1,by1) */
-         for_each_data(&(job->res.boxlist)) {
-           box3 = (struct box *)list_get_current(&(job->res.boxlist));
+         /* expand a frame around the potential barcode (bx0,by0,bx1,by1)
+          *  only boxes within 12 bar widths are taken into account */
+         n = box_grid_query(&job->tmp.boxgrid, bx0-12*bbx, y0,
+                            bx1+12*bbx, y0+dy, &nb, &nnb);
+         for (i=0; i<n; i++) {
+           box3 = nb[i];
            /* bdy=box3->y1-box3->y0+1; */
            if (box2!=box3)
            if (box3->c == PICTURE || box3->c == UNKNOWN)
@@ -1027,8 +1031,15 @@ int detect_barcode(job_t *job)
               }
               j++;  /* found a near bar and count to num bars */
               j2=1; /* continue searching (endless loop?) */
+              /* frame is extended, get the boxes of the new frame
+               *  and continue behind box3 (list order) */
+              n = box_grid_query(&job->tmp.boxgrid, bx0-12*bbx, y0,
+                                 bx1+12*bbx, y0+dy, &nb, &nnb);
+              for (seq=box3->grid_seq, i=0; i<n; i++)
+                if (nb[i]->grid_seq > seq) break;
+              i--; /* i++ of the loop */
            }
-         } end_for_each(&(job->res.boxlist));
+         }
        }
        /* j is the num of bars found above, some inner bars are not counted */
        /* ToDo: better iterative add next nearest bars from sorted list near bars? */
@@ -1037,6 +1048,7 @@ int detect_barcode(job_t *job)
          box2->c=PICTURE; /* BARCODE */
          box2->x0=bx0;       box2->y0=by0;
          box2->x1=bx1;       box2->y1=by1;
+         box_grid_update(box2);
          /* ToDo: add pointer to decoded text */
 
          y=(box2->y0+box2->y1)/2;
@@ -1051,7 +1063,7 @@ int detect_barcode(job_t *job)
          }
          /* transport the info to the gocr-output (development) */
          /* ToDo: decode and print/store barcode bars=j */
-         code=decode_barcode(box2); /* ToDo: char *dest, int len */
+         code=decode_barcode(job,box2); /* ToDo: char *dest, int len */
          if (!code) { /* failed */
            code=(char *)malloc(128);
            /* ToDo: analyze and output num_bars, width of bars etc. */
@@ -1063,8 +1075,10 @@ int detect_barcode(job_t *job)
          free(code);
 
          /* remove inner boxes, only if sure!? (ToDo: use cfg.certainty) */
-         for_each_data(&(job->res.boxlist)) {
-           box3 = (struct box *)list_get_current(&(job->res.boxlist));
+         n = box_grid_query(&job->tmp.boxgrid, bx0, by0-bdy/16-4,
+                            bx1, by0+bdy/16+4, &nb, &nnb);
+         for (i=0; i<n; i++) {
+           box3 = nb[i];
            /* bdy=box3->y1-box3->y0+1; */
            if (box2!=box3)
            if (box3->c == PICTURE || box3->c == UNKNOWN)
@@ -1074,16 +1088,18 @@ int detect_barcode(job_t *job)
                 && box3->x0 >= bx0
            ) {
               rm++; /* count removed boxes */
-              list_del(&(job->res.boxlist),box3);
+              list_del(&(job->res.boxlist), box3);
               free_box(box3);
            }
-         } end_for_each(&(job->res.boxlist));
+         }
          if (job->cfg.verbose)  
            fprintf(stderr,"\n# ... removed boxes: %d", rm);
          rm=0;
        }
    }
   } end_for_each(&(job->res.boxlist));
+  box_grid_free(&job->tmp.boxgrid);
+  if (nb) free(nb);
 
   /* recalculate averages without bars */
   job->res.numC=job->res.sumX=job->res.sumY=j2=0;
@@ -1351,7 +1367,8 @@ int detect_barcode(job_t *job)
                 && box3->x0 >= box2->x0
            ) {
               rm++; /* count removed boxes */
-              list_del(&(job->res.boxlist),box3);
+              list_del_element(&(job->res.boxlist),
+                list_get_cur_element(&(job->res.boxlist)));
               free_box(box3);
            }
          } end_for_each(&(job->res.boxlist));
@@ -1406,7 +1423,7 @@ int detect_barcode(job_t *job)
   // ToDo: rawbytes and bits can be computed, but what about ecc0..3 ???
   //  rawbytes mod (b1+b2) == b2
   //  ecc mod (b1+b2) == 0
-  static int qrConst[40][6+8]= {
+  static const int qrConst[40][6+8]= {
   // raw_bytes+bitrest, ecc_bytes, byte_interleaving
   //           L    M     Q     H     L       M       Q       H
   //  rawB  R  ecc0 ecc1  ecc2  ecc3  b1  b2  b1  b2  b1  b2  b1  b2 
@@ -1454,12 +1471,12 @@ int detect_barcode(job_t *job)
   //  rawbytes/blocks = 3706 / (20+61) = 45 Bytes per Block (30 ecc bytes)
   // 4 bits (mode) + 10,9,8,8 | 12,11,16,10 | 14,13,16,12 bits (size_of_len)
   //                           012 AB  byte     kanji
-  static int head_bits09[16]={0,14,13,0,12,0,0,0,12,0,0,0,0,0,0,0};
-  static int head_bits26[16]={0,16,15,0,20,0,0,0,14,0,0,0,0,0,0,0};
-  static int head_bits40[16]={0,18,17,0,20,0,0,0,16,0,0,0,0,0,0,0};
-  static int word_bits[16]=  {0,10,11,0, 8,0,0,0,13,0,0,0,0,0,0,0};
-  static int word_nchr[16]=  {0, 3, 2,0, 1,0,0,0, 2,0,0,0,0,0,0,0};
-  int *head_bits=NULL;
+  static const int head_bits09[16]={0,14,13,0,12,0,0,0,12,0,0,0,0,0,0,0};
+  static const int head_bits26[16]={0,16,15,0,20,0,0,0,14,0,0,0,0,0,0,0};
+  static const int head_bits40[16]={0,18,17,0,20,0,0,0,16,0,0,0,0,0,0,0};
+  static const int word_bits[16]=  {0,10,11,0, 8,0,0,0,13,0,0,0,0,0,0,0};
+  static const int word_nchr[16]=  {0, 3, 2,0, 1,0,0,0, 2,0,0,0,0,0,0,0};
+  const int *head_bits=NULL;
   int x02,y02,dx2,dy2, x03,y03,dx3,dy3,
       interleave=1, // = qrConst[qr_version-1][6+2*qr_ecclevel+0];
       num_marker=0, /* number of detected big marker squares */
@@ -1867,6 +1884,7 @@ int detect_barcode(job_t *job)
         int b1, b2;
         int dl=0, el=0, i_ecc=num_data_bytes, i_data=0; // data and ecc length
         unsigned char qr_ecc[256]; // buffer for generated ecc data
+        struct _RS rs;  // codec of the current block, was static v0.53
         b1 = qrConst[qr_version-1][6+2*qr_ecclevel+0];
         b2 = qrConst[qr_version-1][6+2*qr_ecclevel+1];
         // for b1 and b2 we have different datasize ???
@@ -1875,11 +1893,11 @@ int detect_barcode(job_t *job)
             dl = num_data_bytes/(b1+b2); // divided in blocks to reduce RS size
             if (i==b1) dl++;
             el =  num_ecc_bytes/(b1+b2);
-            init_rs(8,0x11D,0,1,el,255-dl-el);
+            init_rs(job,&rs,8,0x11D,0,1,el,255-dl-el);
           }
           // gfpoly = 0x11D is the primitive polynom for QR-Code
           // max. data+ecc=255
-          encode_rs_char(&rs, qrbytes + i_data, qr_ecc);
+          encode_rs_char(job, &rs, qrbytes + i_data, qr_ecc);
           g_debug(for(j=0;j<el;j++)fprintf(stderr," %02x ",qr_ecc[j]);fprintf(stderr,"\n# ");)
           g_debug(for(j=0;j<el;j++)fprintf(stderr," %02x ",qrbytes[i_ecc+j]);fprintf(stderr,"\n# ");)
           for (j=0;j<el;j++) if (qr_ecc[j]!=qrbytes[i_ecc+j])
@@ -2090,7 +2108,8 @@ int detect_barcode(job_t *job)
         } else {
           // ToDo: list_del except one
           rm++; /* count removed boxes */
-          list_del(&(job->res.boxlist),box2);
+          list_del_element(&(job->res.boxlist),
+            list_get_cur_element(&(job->res.boxlist)));
           free_box(box2);
         }
       }
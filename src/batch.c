@@ -0,0 +1,333 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2019  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ batch mode, v0.53
+   many input files in one call, the database (-m 2) is loaded once
+   per thread and not once per file
+
+   gocr [options] file1 file2 ...       text to stdout, "==> file <=="
+                                        before the text of every file
+   gocr [options] --list=name           file names from name, one per
+   ls *.pgm | gocr [options] --list=-   line, - for stdin
+   gocr [options] --suffix=.txt ...     text of file x to x.txt
+
+   with --threads=n the files are recognized on n threads, every thread
+   takes the next file, the text to stdout keeps the order of the files,
+   a file is recognized as by gocr [options] file (all images), its
+   preprocessing gets n/busy threads (files in recognition)
+   -v prints the time of every file and a summary to stderr
+   a file which can not be read gives no text and the exit code 255,
+   the other files are recognized
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "pnm.h"
+#include "pgm2asc.h"
+#include "gocr.h"
+#include "pcx.h"
+
+#ifdef HAVE_GETTIMEOFDAY
+typedef struct timeval btime_t;
+#define BTIME(t) gettimeofday(&(t), NULL)
+#else
+typedef int btime_t;  /* no times */
+#define BTIME(t) ((t) = 0)
+#endif
+
+typedef struct bfile_s {
+  char *name;
+  FILE *out;   /* text for stdout (tmpfile), NULL with suffix */
+  int pages;   /* recognized images */
+  int err;     /* read or write error */
+  int ms;      /* time in ms */
+  int done;
+} bfile_t;
+
+typedef struct batch_s {
+  bfile_t *f;
+  int nf;
+  char *suffix;
+  job_t cfg;   /* only cfg.cfg is used, the options of the command line */
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int next;    /* next file for a worker */
+  int nout;    /* next file for stdout */
+  int ahead;   /* max. files taken but not printed, 2*threads */
+  int busy;    /* files in recognition */
+#endif
+} batch_t;
+
+static int ms_since(btime_t *t0) {
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval t1;
+  gettimeofday(&t1, NULL);
+  return (t1.tv_sec - t0->tv_sec) * 1000 + (t1.tv_usec - t0->tv_usec) / 1000;
+#else
+  return 0;
+#endif
+}
+
+/* append the file names of list (- for stdin), one per line,
+ *  files has place for max names */
+static int read_list(char *list, char ***files, int *nf, int max) {
+  FILE *f1;
+  char buf[4096], **p;
+  int n, rc = 0;
+
+  f1 = (strcmp(list, "-") == 0) ? stdin : fopen(list, "r");
+  if (!f1) { fprintf(stderr, "ERROR batch: opening %s\n", list); return -1; }
+  while (fgets(buf, sizeof(buf), f1)) {
+    n = strlen(buf);
+    while (n > 0 && (buf[n-1] == '\n' || buf[n-1] == '\r')) buf[--n] = 0;
+    if (n == 0) continue;
+    if (strcmp(buf, "-") == 0) {
+      fprintf(stderr, "# batch: - (stdin) in %s ignored\n", list); continue; }
+    if (*nf >= max) {
+      max = 2 * max + 16;
+      p = (char **)realloc(*files, max * sizeof(char *));
+      if (!p) { rc = -1; break; }
+      *files = p;
+    }
+    (*files)[*nf] = (char *)malloc(n + 1);
+    if (!(*files)[*nf]) { rc = -1; break; }
+    strcpy((*files)[(*nf)++], buf);
+  }
+  if (rc) fprintf(stderr, "ERROR batch: no memory for the list\n");
+  if (f1 != stdin) fclose(f1);
+  return rc;
+}
+
+/* output of file f, name + suffix or a tmpfile for stdout */
+static FILE *batch_open(batch_t *b, bfile_t *f) {
+  char *oname;
+  FILE *out = NULL;
+  if (!b->suffix) return tmpfile();
+  oname = (char *)malloc(strlen(f->name) + strlen(b->suffix) + 1);
+  if (oname) {
+    strcpy(oname, f->name); strcat(oname, b->suffix);
+    out = fopen(oname, "w");
+    if (!out) fprintf(stderr, "ERROR batch: opening %s\n", oname);
+    free(oname);
+  }
+  return out;
+}
+
+/* recognize all images of file f, like the page loop of main(),
+ *  threads for the preprocessing of the images */
+static void batch_file(batch_t *b, job_t *job, bfile_t *f, int threads) {
+  int rc = 1;
+  FILE *out = NULL; /* opened after the first image is read */
+  btime_t t0;
+
+  if (f->err) return; /* bad name */
+  BTIME(t0);
+  job->cfg = b->cfg.cfg;
+  job->cfg.threads = threads;
+  job->src.fname = f->name;
+  job->src.num_image = 0;
+  pnm_stream_init(&job->src.stream);
+  job->src.stream.threads = threads;
+  while (rc == 1) {
+    job_init_image(job);
+    if (strstr(f->name, ".pcx")) {
+      rc = readpcx(f->name, &job->src.p, job->cfg.verbose); /* 0 or -1 */
+    } else
+      rc = readpgm_stream(&job->src.stream, f->name, &job->src.p,
+                          job->cfg.verbose);
+    if (rc < 0) { f->err = 1; job_free_image(job); break; }
+    if (!out) out = batch_open(b, f);
+    if (!out) { f->err = 1; job_free_image(job); break; }
+    pgm2asc(job);
+    fprint_output(out, job);
+    job_free_image(job);
+    f->pages++;
+  }
+  pnm_stream_close(&job->src.stream);
+  if (out && ferror(out)) f->err = 1;
+  if (out && b->suffix) { if (fclose(out)) f->err = 1; }
+  else if (out) { rewind(out); f->out = out; }
+  f->ms = ms_since(&t0);
+  if (job->cfg.verbose)
+    fprintf(stderr, "# batch: %s images= %d time= %d ms%s\n",
+      f->name, f->pages, f->ms, (f->err) ? " ERROR" : "");
+}
+
+/* copy the text of f to stdout */
+static void batch_out(batch_t *b, bfile_t *f) {
+  char buf[4096];
+  int n;
+  if (!f->out) return;
+  if (b->nf > 1) printf("==> %s <==\n", f->name);
+  while ((n = fread(buf, 1, sizeof(buf), f->out)) > 0)
+    fwrite(buf, 1, n, stdout);
+  fclose(f->out);
+  f->out = NULL;
+}
+
+#ifdef HAVE_PTHREAD_H
+typedef struct bworker_s {
+  pthread_t tid;
+  batch_t *b;
+  job_t job1, *job;  /* job is the job of main() or job1 */
+} bworker_t;
+
+static void *bworker(void *arg) {
+  bworker_t *w = (bworker_t *)arg;
+  batch_t *b = w->b;
+  int i, threads;
+
+  for (;;) {
+    pthread_mutex_lock(&b->mutex);
+    while (b->next < b->nf && b->next >= b->nout + b->ahead)
+      pthread_cond_wait(&b->cond, &b->mutex);
+    i = b->next++;
+    if (i < b->nf) b->busy++;
+    threads = b->cfg.cfg.threads / ((b->busy > 0) ? b->busy : 1);
+    pthread_mutex_unlock(&b->mutex);
+    if (i >= b->nf) break;
+    batch_file(b, w->job, &b->f[i], (threads > 1) ? threads : 1);
+    pthread_mutex_lock(&b->mutex);
+    b->busy--;
+    b->f[i].done = 1;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+  }
+  return NULL;
+}
+
+/* n worker threads, worker 0 uses job (and its database) */
+static int batch_threads(batch_t *b, job_t *job, int n) {
+  bworker_t *w;
+  int i, nw;
+
+  w = (bworker_t *)calloc(n, sizeof(bworker_t));
+  if (!w) { fprintf(stderr, "ERROR batch: no memory\n"); return -1; }
+  pthread_mutex_init(&b->mutex, NULL);
+  pthread_cond_init(&b->cond, NULL);
+  b->ahead = 2 * n;
+  for (nw = 0; nw < n; nw++) {
+    w[nw].b = b;
+    w[nw].job = job;
+    if (nw) {
+      w[nw].job = &w[nw].job1;
+      job_init(w[nw].job);
+      w[nw].job->cfg = b->cfg.cfg;
+      if ((b->cfg.cfg.mode & 2) && load_db(w[nw].job) < 0) {
+        free_db(w[nw].job); break; }
+    }
+    if (pthread_create(&w[nw].tid, NULL, bworker, &w[nw])) {
+      fprintf(stderr, "ERROR batch: pthread_create failed\n");
+      if (nw) free_db(w[nw].job);
+      break;
+    }
+  }
+  for (i = 0; i < b->nf && nw > 0; i++) { /* output in file order */
+    pthread_mutex_lock(&b->mutex);
+    while (!b->f[i].done) pthread_cond_wait(&b->cond, &b->mutex);
+    pthread_mutex_unlock(&b->mutex);
+    batch_out(b, &b->f[i]);
+    pthread_mutex_lock(&b->mutex);
+    b->nout = i + 1;
+    pthread_cond_broadcast(&b->cond);
+    pthread_mutex_unlock(&b->mutex);
+  }
+  for (i = 0; i < nw; i++) {
+    pthread_join(w[i].tid, NULL);
+    if (i) free_db(w[i].job);
+  }
+  pthread_cond_destroy(&b->cond);
+  pthread_mutex_destroy(&b->mutex);
+  free(w);
+  return ((nw < n) ? -1 : 0);
+}
+#endif
+
+/* main loop of the batch mode, returns 0 or -1 if a file failed */
+int batch_ocr(job_t *job, char **files, int nfiles, char *list,
+              char *suffix) {
+  batch_t b;
+  char **names = files;
+  int i, n, rc = 0, nerr = 0, npages = 0, ms = 0, nl = nfiles;
+  btime_t t0;
+
+  BTIME(t0);
+  if (list) { /* the names of the list follow the names of the command line */
+    names = (char **)malloc((nfiles + 1) * sizeof(char *));
+    if (!names) { fprintf(stderr, "ERROR batch: no memory\n"); return -1; }
+    memcpy(names, files, nfiles * sizeof(char *));
+    if (read_list(list, &names, &nl, nfiles + 1) < 0) rc = -1;
+  }
+  if (nl == 0 && rc == 0) {
+    fprintf(stderr, "ERROR batch: no input files (-i, file names, --list)\n");
+    rc = -1;
+  }
+  memset(&b, 0, sizeof(b));
+  b.nf = nl;
+  b.suffix = suffix;
+  b.cfg.cfg = job->cfg;
+  b.f = (bfile_t *)calloc(nl + 1, sizeof(bfile_t));
+  if (!b.f) { fprintf(stderr, "ERROR batch: no memory\n"); rc = -1; b.nf = 0; }
+  for (i = 0; i < b.nf; i++) {
+    b.f[i].name = names[i];
+    if (suffix && strcmp(names[i], "-") == 0) {
+      fprintf(stderr, "ERROR batch: --suffix needs file names, not -\n");
+      b.f[i].err = 1;
+    }
+  }
+
+  n = job->cfg.threads;
+  if (n > b.nf) n = b.nf;
+  if (job->cfg.mode & 128) n = 1; /* interactive mode reads stdin */
+#ifdef HAVE_PTHREAD_H
+  if (n > 1) {
+    if (batch_threads(&b, job, n) < 0) rc = -1;
+  } else
+#endif
+  for (i = 0; i < b.nf; i++) {
+    batch_file(&b, job, &b.f[i], job->cfg.threads);
+    batch_out(&b, &b.f[i]);
+  }
+
+  for (i = 0; i < b.nf; i++) {
+    if (b.f[i].err) nerr++;
+    npages += b.f[i].pages;
+    ms += b.f[i].ms;
+  }
+  if (job->cfg.verbose)
+    fprintf(stderr, "# batch: files= %d errors= %d images= %d"
+      " time= %d ms (sum of files %d ms, %d ms per file)\n", b.nf, nerr,
+      npages, ms_since(&t0), ms, (b.nf) ? ms / b.nf : 0);
+  job->cfg = b.cfg.cfg;
+  for (i = nfiles; i < nl; i++) free(names[i]);
+  if (names != files) free(names);
+  free(b.f);
+  return ((rc < 0 || nerr) ? -1 : 0);
+}
@@ -62,6 +62,11 @@ int copybox (pix * p, int x0, int y0, int dx, int dy, pix * b, int len) {
   b->x = dx;
   b->y = dy;
   b->bpp = 1;
+  b->job = p->job; /* same cfg and n_run as the source, v0.53 */
+  b->bits = NULL;  /* no packed plane for copies */
+  b->fbits = NULL;
+  b->sat = NULL;
+  b->marks = NULL; /* no marks, see pix_marks_init() */
 #ifdef FASTER_INCOMPLETE
   for (y = 0; y < dy; y++)
     memcpy(&pixel_atp(b, 0, y), &pixel_atp(p, x0, y + y0 ), dx);
@@ -88,12 +93,82 @@ int reset_box_ac(struct box *box){
   return 0;
 }
 
-/* ini or copy a box: get memory for box and initialize the memory */
-struct box *malloc_box (struct box *inibox) {
+/* frame vectors are stored out of the box (v0.53), most boxes are
+ *  small and need only a few vectors, big ones may have more than
+ *  MaxFrameVectors (not simplified yet), so the size is dynamic
+ * enlarge frame_vector[] to hold num vectors (or shrink it exactly to num)
+ * returns 0 on success, 1 on error (old vectors are kept) */
+int box_alloc_vectors (struct box *box1, int num) {
+  frame_vector_t *fv;
+
+  if (num == box1->max_frame_vectors) return 0;
+  if (num <= 0) { box_free_vectors(box1); return 0; }
+  fv = (frame_vector_t *)realloc(box1->frame_vector,
+                                 num * sizeof(frame_vector_t));
+  if (!fv) {
+    fprintf(stderr, "realloc error in box_alloc_vectors %d\n", num);
+    return 1;
+  }
+  box1->frame_vector = fv;
+  box1->max_frame_vectors = num;
+  return 0;
+}
+
+void box_free_vectors (struct box *box1) {
+  if (box1->frame_vector) free(box1->frame_vector);
+  box1->frame_vector = NULL;
+  box1->max_frame_vectors = 0;
+}
+
+/* copy the vectors of box1 into a buffer, which is enlarged if needed,
+ *  used for temporary boxes (struct copies) which are modified by cut_box
+ *  buf must be freed by the caller */
+frame_vector_t *box_copy_vectors (struct box *box1,
+                    frame_vector_t **buf, int *bufsize) {
+  int num = (box1->num_frames) ? box1->num_frame_vectors[box1->num_frames-1]
+                               : 0;
+  if (num > *bufsize) {
+    frame_vector_t *fv =
+      (frame_vector_t *)realloc(*buf, num * sizeof(frame_vector_t));
+    if (!fv) {
+      fprintf(stderr, "realloc error in box_copy_vectors %d\n", num);
+      return NULL;
+    }
+    *buf = fv;
+    *bufsize = num;
+  }
+  if (num) memcpy(*buf, box1->frame_vector, num * sizeof(frame_vector_t));
+  return *buf;
+}
+
+/* ini or copy a box: get memory for box and initialize the memory
+ *  pool==NULL: use malloc, box must be freed by free_box()
+ *  pool!=NULL: take it from the free list or the newest slab,
+ *              free_box() gives it back, box_pool_free() releases all */
+struct box *box_pool_get (box_pool_t *pool, struct box *inibox) {
   struct box *buf;
+  struct box_slab_s *slab;
   int i;
 
-  buf = (struct box *) malloc(sizeof(struct box));
+  if (!pool) {
+    buf = (struct box *) malloc(sizeof(struct box));
+  } else if (pool->free) {
+    buf = pool->free;
+    pool->free = buf->next_free;
+    pool->num_reused++;
+  } else {
+    slab = pool->slabs;
+    if (!slab || slab->num_used >= BoxSlabSize) {
+      slab = (struct box_slab_s *) malloc(sizeof(struct box_slab_s));
+      if (!slab)
+        return NULL;
+      slab->next = pool->slabs;
+      slab->num_used = 0;
+      pool->slabs = slab;
+      pool->num_slabs++;
+    }
+    buf = &slab->box[slab->num_used++];
+  }
   if (!buf)
     return NULL;
   if (inibox) {
@@ -105,24 +180,77 @@ struct box *malloc_box (struct box *inibox) {
         memcpy(buf->tas[i], inibox->tas[i], strlen(inibox->tas[i])+1);
       }
     }
+    buf->frame_vector=NULL;
+    buf->max_frame_vectors=0;
+    i = (inibox->num_frames)
+      ? inibox->num_frame_vectors[inibox->num_frames-1] : 0;
+    if (i && box_alloc_vectors(buf, i)==0)
+      memcpy(buf->frame_vector, inibox->frame_vector,
+             i * sizeof(frame_vector_t));
   }
   else { /* ToDo: init it */
     buf->num_ac=0;
     buf->num_frames=0;
+    buf->frame_vector=NULL;
+    buf->max_frame_vectors=0;
+  }
+  buf->pool = pool;
+  buf->next_free = NULL;
+  buf->grid = NULL;   /* a copy is not indexed */
+  if (pool) {
+    pool->num_boxes++;
+    if (pool->num_boxes > pool->max_boxes) pool->max_boxes = pool->num_boxes;
   }
   /* fprintf(stderr,"\nDBG ini_box %p",buf); */
   return buf;
 }
 
+/* ini or copy a box, not owned by a pool (database boxes) */
+struct box *malloc_box (struct box *inibox) {
+  return box_pool_get(NULL, inibox);
+}
+
 /* free memory of box */
 int free_box (struct box *box) {
   if (!box) return 0;
   /* fprintf(stderr,"DBG free_box %p\n",box); out_x(box); */
+  box_grid_del(box); /* remove from spatial index */
   reset_box_ac(box); /* free alternative char table */
+  box_free_vectors(box);
+  if (box->pool) {   /* give it back for reuse */
+    box->next_free = box->pool->free;
+    box->pool->free = box;
+    box->pool->num_boxes--;
+    return 0;
+  }
   free(box);         /* free the box memory */
   return 0;
 }
 
+void box_pool_init (box_pool_t *pool) {
+  pool->slabs = NULL;
+  pool->free = NULL;
+  pool->num_slabs = 0;
+  pool->num_boxes = pool->max_boxes = pool->num_reused = 0;
+}
+
+/* release all boxes of the pool, boxes must not be used anymore
+ *  only the char tables (tas[]) and vectors must be freed box by box */
+void box_pool_free (box_pool_t *pool) {
+  struct box_slab_s *slab;
+  int i;
+
+  while ((slab = pool->slabs)) {
+    for (i = 0; i < slab->num_used; i++) {
+      reset_box_ac(&slab->box[i]);
+      box_free_vectors(&slab->box[i]);
+    }
+    pool->slabs = slab->next;
+    free(slab);
+  }
+  box_pool_init(pool);
+}
+
 /* simplify the vectorgraph, 
  *  but what is the best way?
  *   a) melting two neighbouring vectors with nearly same direction?
@@ -217,6 +345,7 @@ int merge_boxes( struct box *box1, struct box *box2 ) {
   if ( box2->x1 > box1->x1 ) box1->x1 = box2->x1;
   if ( box2->y0 < box1->y0 ) box1->y0 = box2->y0;
   if ( box2->y1 > box1->y1 ) box1->y1 = box2->y1;
+  box_grid_update(box1);   /* frame may be changed */
   i1 = i2 = 0;
   if (bbigger->num_frames) 
     i1 =  bbigger->num_frame_vectors[  bbigger->num_frames - 1 ];
@@ -228,9 +357,17 @@ int merge_boxes( struct box *box1, struct box *box2 ) {
   }
   /* if i1+i2>MaxFrameVectors  simplify the vectorgraph */
   /* if sum num_frames>MaxNumFrames  through shortest graph away and warn */
-  /* first copy the bigger box */
-  memcpy(&tmpbox, bbigger, sizeof(struct box));
-  /* attach the smaller box */
+  /* first copy the bigger box, then attach the smaller box */
+  tmpbox.num_frames = bbigger->num_frames;
+  memcpy(tmpbox.num_frame_vectors,
+         bbigger->num_frame_vectors,sizeof(int)*MaxNumFrames);
+  memcpy(tmpbox.frame_vol, bbigger->frame_vol,sizeof(int)*MaxNumFrames);
+  memcpy(tmpbox.frame_per, bbigger->frame_per,sizeof(int)*MaxNumFrames);
+  tmpbox.frame_vector = NULL;
+  tmpbox.max_frame_vectors = 0;
+  if (box_alloc_vectors(&tmpbox, i1+i2)) return 1;
+  if (i1) memcpy(tmpbox.frame_vector,
+                 bbigger->frame_vector, i1*sizeof(frame_vector_t));
   for (i4=i3=0; i3<bsmaller->num_frames; i3++) {
     if (tmpbox.num_frames>=MaxNumFrames) break;
     
@@ -244,7 +381,7 @@ int merge_boxes( struct box *box1, struct box *box2 ) {
     tmpbox.frame_per[ tmpbox.num_frames ] = bsmaller->frame_per[ i3 ];
     tmpbox.num_frames++;
     if (tmpbox.num_frames>=MaxNumFrames) {
-      if (OCR_JOB->cfg.verbose)
+      if (box1->p->job->cfg.verbose)
         fprintf(stderr,"\nDBG merge_boxes MaxNumFrames reached");
       break;
     }
@@ -257,10 +394,12 @@ int merge_boxes( struct box *box1, struct box *box2 ) {
          tmpbox.frame_vol,sizeof(int)*MaxNumFrames);
   memcpy(box1->frame_per,
          tmpbox.frame_per,sizeof(int)*MaxNumFrames);
-  memcpy(box1->frame_vector,
-         tmpbox.frame_vector,sizeof(int)*2*MaxFrameVectors);
+  box_free_vectors(box1); /* replace by the merged vectors */
+  box1->frame_vector = tmpbox.frame_vector;
+  box1->max_frame_vectors = tmpbox.max_frame_vectors;
+  box_alloc_vectors(box1, i1); /* shrink to used size */
 #if 0
-  if ((OCR_JOB->cfg.verbose&48)==48) {
+  if ((box1->p->job->cfg.verbose&48)==48) {
     fprintf(stderr,"\nDBG merge_boxes_result:"); out_x(box1); }
 #endif
   return 0;
@@ -330,7 +469,7 @@ int cut_box( struct box *box1) {
                            //                     outside_inside=2
   struct box tmpbox; // = (*box1); temp. buffer, after some corrections
 #ifdef DO_DEBUG
-  if (OCR_JOB->cfg.verbose) dbg=1+2;  // debug level, enlarge to get more output
+  if (box1->p->job->cfg.verbose) dbg=1+2;  // debug level, enlarge to get more output
 #endif  
   if (dbg) fprintf(stderr,"\n cut box x= %3d %3d", box1->x0, box1->y0);
   /* check if complete frames are outside the box */
@@ -393,7 +532,7 @@ int cut_box( struct box *box1) {
 int cut_box( struct box *box1) {
   int i1, i2, i3, i4, x, y, lx, ly, dbg=0;
 #ifdef DO_DEBUG
-  if (OCR_JOB->cfg.verbose) dbg=1+2;  // debug level, enlarge to get more output
+  if (box1->p->job->cfg.verbose) dbg=1+2;  // debug level, enlarge to get more output
 #endif  
   if (dbg) fprintf(stderr,"\n cut box x= %3d %3d", box1->x0, box1->y0);
   /* check if complete frames are outside the box */
@@ -0,0 +1,393 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2026  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for EMAIL address
+
+ spatial index of the boxes (v0.53)
+ before, every search for boxes around a box was a full scan of the
+ boxlist, which is O(n^2) per pass; the grid restricts the search to
+ the cells around the box. Results are sorted in list order, so the
+ passes find the same box as the scan of the list (first fitting box).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gocr.h"
+#include "pgm2asc.h"
+
+#define GridMaxCells 256  /* maximum number of cells per dimension */
+#define GridSeqStep  64   /* gap between grid_seq of neighbours */
+
+void box_grid_init (box_grid_t *grid) {
+  grid->list = NULL;
+  grid->cw = grid->ch = 1;
+  grid->nx = grid->ny = 0;
+  grid->cell = NULL;
+  grid->node = NULL;
+  grid->num_nodes = grid->max_nodes = 0;
+  grid->free_node = -1;
+  grid->num_boxes = 0;
+}
+
+/* unlink all boxes and free the memory */
+void box_grid_free (box_grid_t *grid) {
+  int i;
+  for (i = 0; i < grid->max_nodes; i++)
+    if (grid->node[i].box) grid->node[i].box->grid = NULL;
+  if (grid->cell) free(grid->cell);
+  if (grid->node) free(grid->node);
+  box_grid_init(grid);
+}
+
+/* cell column or row of coordinate x, clipped to the grid */
+static int grid_cx (box_grid_t *grid, int x) {
+  if (x < 0) return 0;
+  x /= grid->cw;
+  return (x < grid->nx) ? x : grid->nx - 1;
+}
+static int grid_cy (box_grid_t *grid, int y) {
+  if (y < 0) return 0;
+  y /= grid->ch;
+  return (y < grid->ny) ? y : grid->ny - 1;
+}
+
+/* link box1 into all covered cells, returns 1 on memory error */
+static int grid_link (box_grid_t *grid, struct box *box1) {
+  int cx, cy, i;
+  box1->gx0 = grid_cx(grid, box1->x0);  box1->gx1 = grid_cx(grid, box1->x1);
+  box1->gy0 = grid_cy(grid, box1->y0);  box1->gy1 = grid_cy(grid, box1->y1);
+  for (cy = box1->gy0; cy <= box1->gy1; cy++)
+  for (cx = box1->gx0; cx <= box1->gx1; cx++) {
+    if (grid->free_node < 0) { /* enlarge node table */
+      int n = 2 * grid->max_nodes + 1024;
+      struct box_grid_node_s *nd = (struct box_grid_node_s *)
+        realloc(grid->node, n * sizeof(struct box_grid_node_s));
+      if (!nd) {
+        fprintf(stderr, "realloc error in grid_link %d\n", n);
+        return 1;
+      }
+      for (i = n - 1; i >= grid->max_nodes; i--) {
+        nd[i].box = NULL;  nd[i].next = grid->free_node;
+        grid->free_node = i;
+      }
+      grid->node = nd;
+      grid->max_nodes = n;
+    }
+    i = grid->free_node;
+    grid->free_node = grid->node[i].next;
+    grid->node[i].box  = box1;
+    grid->node[i].next = grid->cell[cy * grid->nx + cx];
+    grid->cell[cy * grid->nx + cx] = i;
+    grid->num_nodes++;
+  }
+  box1->grid = grid;
+  return 0;
+}
+
+/* remove box1 from all its cells, returns 1 if box1 is not linked
+ *  (a struct copy of an indexed box has a grid pointer too) */
+static int grid_unlink (box_grid_t *grid, struct box *box1) {
+  int cx, cy, i, *pi;
+  for (cy = box1->gy0; cy <= box1->gy1; cy++)
+  for (cx = box1->gx0; cx <= box1->gx1; cx++) {
+    for (pi = &grid->cell[cy * grid->nx + cx]; (i = *pi) >= 0;
+         pi = &grid->node[i].next)
+      if (grid->node[i].box == box1) break;
+    if (i < 0) return 1;
+    *pi = grid->node[i].next;
+    grid->node[i].box  = NULL;
+    grid->node[i].next = grid->free_node;
+    grid->free_node = i;
+    grid->num_nodes--;
+  }
+  return 0;
+}
+
+/* build the index for job->res.boxlist, cell size is 2x2 average chars
+ * returns 0 on success, 1 on error (grid has no cells then, the
+ * queries scan the list) */
+int box_grid_build (box_grid_t *grid, job_t *job) {
+  int dx = job->src.p.x, dy = job->src.p.y, i, seq = 0;
+  struct box *box2;
+
+  box_grid_free(grid);
+  if (job->res.numC > 0) {
+    grid->cw = 2 * ((job->res.sumX + job->res.numC/2) / job->res.numC);
+    grid->ch = 2 * ((job->res.sumY + job->res.numC/2) / job->res.numC);
+  } else {
+    grid->cw = 2 * job->res.avX;
+    grid->ch = 2 * job->res.avY;
+  }
+  if (dx < 1) dx = 1;
+  if (dy < 1) dy = 1;
+  if (grid->cw < 4) grid->cw = 4;
+  if (grid->ch < 4) grid->ch = 4;
+  if (grid->cw * GridMaxCells < dx) grid->cw = (dx + GridMaxCells-1) / GridMaxCells;
+  if (grid->ch * GridMaxCells < dy) grid->ch = (dy + GridMaxCells-1) / GridMaxCells;
+  grid->nx = (dx + grid->cw - 1) / grid->cw;
+  grid->ny = (dy + grid->ch - 1) / grid->ch;
+  grid->cell = (int *)malloc(grid->nx * grid->ny * sizeof(int));
+  if (!grid->cell) {
+    fprintf(stderr, "malloc error in box_grid_build %d\n", grid->nx*grid->ny);
+    box_grid_init(grid);
+    grid->list = &(job->res.boxlist); /* linear scan */
+    return 1;
+  }
+  for (i = 0; i < grid->nx * grid->ny; i++) grid->cell[i] = -1;
+  grid->list = &(job->res.boxlist);
+  for_each_data(&(job->res.boxlist)) {
+    box2 = (struct box *)list_get_current(&(job->res.boxlist));
+    box2->grid_seq = (seq += GridSeqStep);
+    if (grid_link(grid, box2)) break;
+    grid->num_boxes++;
+  } end_for_each(&(job->res.boxlist));
+  if (grid->num_boxes < job->res.boxlist.n) { /* out of memory */
+    box_grid_free(grid);
+    grid->list = &(job->res.boxlist); /* linear scan */
+    return 1;
+  }
+  return 0;
+}
+
+/* add box of element e (already in the list) to the index */
+int box_grid_add (box_grid_t *grid, Element *e) {
+  struct box *box1 = (struct box *)e->data, *box2;
+  Element *e2;
+  int lo, hi, seq;
+
+  if (!grid->cell) return 1;
+  for (;;) { /* grid_seq between the indexed neighbours */
+    lo = 0;
+    for (e2 = e->previous; (box2 = (struct box *)e2->data); e2 = e2->previous)
+      if (box2->grid == grid) { lo = box2->grid_seq; break; }
+    hi = lo + 2 * GridSeqStep;
+    for (e2 = e->next; (box2 = (struct box *)e2->data); e2 = e2->next)
+      if (box2->grid == grid) { hi = box2->grid_seq; break; }
+    if (hi - lo > 1) break;
+    /* no gap left, renumber the list */
+    seq = 0;
+    for (e2 = grid->list->start.next; (box2 = (struct box *)e2->data);
+         e2 = e2->next)
+      if (box2->grid == grid) box2->grid_seq = (seq += GridSeqStep);
+  }
+  box1->grid_seq = lo + (hi - lo) / 2;
+  if (grid_link(grid, box1)) { grid_unlink(grid, box1); box1->grid = NULL;
+    return 1; }
+  grid->num_boxes++;
+  return 0;
+}
+
+/* remove a box from its index (called by free_box) */
+void box_grid_del (struct box *box1) {
+  box_grid_t *grid = box1->grid;
+  if (!grid) return;
+  if (grid_unlink(grid, box1) == 0) grid->num_boxes--;
+  box1->grid = NULL;
+}
+
+/* call it after the frame of an indexed box is changed */
+void box_grid_update (struct box *box1) {
+  box_grid_t *grid = box1->grid;
+  if (!grid) return;
+  if (grid_unlink(grid, box1)) { box1->grid = NULL; return; }
+  if (grid_link(grid, box1)) {
+    grid_unlink(grid, box1); box1->grid = NULL; grid->num_boxes--; }
+}
+
+static int grid_seq_compare (const void *a, const void *b) {
+  return (*(struct box **)a)->grid_seq - (*(struct box **)b)->grid_seq;
+}
+
+/* store box1 to buf[n], buf is enlarged if needed */
+static int grid_buf_put (struct box ***buf, int *bufsize, int n,
+                         struct box *box1) {
+  if (n >= *bufsize) {
+    int nsize = 2 * (*bufsize) + 64;
+    struct box **nbuf =
+      (struct box **)realloc(*buf, nsize * sizeof(struct box *));
+    if (!nbuf) {
+      fprintf(stderr, "realloc error in box_grid_query %d\n", nsize);
+      return 1;
+    }
+    *buf = nbuf;  *bufsize = nsize;
+  }
+  (*buf)[n] = box1;
+  return 0;
+}
+
+/* get all boxes overlapping the frame x0..x1,y0..y1 (inclusive)
+ *  into buf[] sorted in list order, buf must be freed by the caller
+ *  returns the number of boxes */
+int box_grid_query (box_grid_t *grid, int x0, int y0, int x1, int y1,
+                    struct box ***buf, int *bufsize) {
+  int cx, cy, cx0, cx1, cy0, cy1, i, n = 0;
+  struct box *box1;
+  Element *e;
+
+  if (x1 < x0 || y1 < y0) return 0;
+  if (!grid->cell) { /* no memory for the grid, scan the list */
+    if (!grid->list) return 0;
+    for (e = grid->list->start.next; (box1 = (struct box *)e->data);
+         e = e->next) {
+      if (box1->x1 < x0 || box1->x0 > x1
+       || box1->y1 < y0 || box1->y0 > y1) continue;
+      if (grid_buf_put(buf, bufsize, n, box1)) break;
+      n++;
+    }
+    return n; /* in list order */
+  }
+  cx0 = grid_cx(grid, x0);  cx1 = grid_cx(grid, x1);
+  cy0 = grid_cy(grid, y0);  cy1 = grid_cy(grid, y1);
+  for (cy = cy0; cy <= cy1; cy++)
+  for (cx = cx0; cx <= cx1; cx++)
+    for (i = grid->cell[cy * grid->nx + cx]; i >= 0; i = grid->node[i].next) {
+      box1 = grid->node[i].box;
+      if (box1->x1 < x0 || box1->x0 > x1
+       || box1->y1 < y0 || box1->y0 > y1) continue;
+      /* report the box only in the first cell it shares with the query */
+      if (cx != ((box1->gx0 > cx0) ? box1->gx0 : cx0)
+       || cy != ((box1->gy0 > cy0) ? box1->gy0 : cy0)) continue;
+      if (grid_buf_put(buf, bufsize, n, box1)) break;
+      n++;
+    }
+  if (n > 1) qsort(*buf, n, sizeof(struct box *), grid_seq_compare);
+  return n;
+}
+
+/* grid_knn() without cells, all boxes of the list in list order */
+static int list_knn (box_grid_t *grid, int x, int y, int k, int maxdist2,
+              int xmin, struct box *skip,
+              int (*accept)(struct box *box1, void *data), void *data,
+              struct box **res, int *dist) {
+  int n = 0, j, d, xb, yb;
+  struct box *box1;
+  Element *e;
+
+  if (!grid->list) return 0;
+  for (e = grid->list->start.next; (box1 = (struct box *)e->data);
+       e = e->next) {
+    if (box1 == skip) continue;
+    xb = (box1->x0 + box1->x1) / 2;
+    yb = (box1->y0 + box1->y1) / 2;
+    if (xb < xmin) continue;
+    d = (xb - x) * (xb - x) + (yb - y) * (yb - y);
+    if (d > maxdist2 || (n == k && d >= dist[n-1])) continue;
+    if (accept && !accept(box1, data)) continue;
+    /* insert sorted by distance, the first box of the list wins ties */
+    for (j = (n < k) ? n++ : n - 1; j > 0 && dist[j-1] > d; j--) {
+      dist[j] = dist[j-1];  res[j] = res[j-1];
+    }
+    dist[j] = d;  res[j] = box1;
+  }
+  return n;
+}
+
+/* k nearest boxes to x,y (distance of the box middle) with middle x >= xmin
+ *  ring search around the cell of x,y, every box is checked only in the
+ *  cell of its middle point, ties are resolved by list order
+ *  res[k] and dist[k] are sorted, returns number of found boxes */
+static int grid_knn (box_grid_t *grid, int x, int y, int k, int maxdist2,
+              int xmin, struct box *skip,
+              int (*accept)(struct box *box1, void *data), void *data,
+              struct box **res, int *dist) {
+  int cx, cy, cx0, cy0, r, rmax, n = 0, i, j, d, xb, yb, bound,
+      m = (grid->cw < grid->ch) ? grid->cw : grid->ch;
+  struct box *box1;
+
+  if (k < 1) return 0;
+  if (!grid->cell)
+    return list_knn(grid, x, y, k, maxdist2, xmin, skip, accept, data,
+                    res, dist);
+  cx0 = grid_cx(grid, x);  cy0 = grid_cy(grid, y);
+  rmax = (grid->nx > grid->ny) ? grid->nx : grid->ny;
+  for (r = 0; r <= rmax; r++) {
+    for (cy = cy0 - r; cy <= cy0 + r; cy++) {
+      if (cy < 0 || cy >= grid->ny) continue;
+      for (cx = cx0 - r; cx <= cx0 + r; cx++) {
+        if (cx < 0 || cx >= grid->nx) continue;
+        if (cx != cx0 - r && cx != cx0 + r
+         && cy != cy0 - r && cy != cy0 + r) continue; /* inside the ring */
+        if (grid->cw * (cx + 1) <= xmin) continue; /* left of xmin */
+        for (i = grid->cell[cy * grid->nx + cx]; i >= 0;
+             i = grid->node[i].next) {
+          box1 = grid->node[i].box;
+          if (box1 == skip) continue;
+          xb = (box1->x0 + box1->x1) / 2;
+          yb = (box1->y0 + box1->y1) / 2;
+          if (grid_cx(grid, xb) != cx || grid_cy(grid, yb) != cy) continue;
+          if (xb < xmin) continue;
+          d = (xb - x) * (xb - x) + (yb - y) * (yb - y);
+          if (d > maxdist2) continue;
+          if (n == k && (d > dist[n-1]
+           || (d == dist[n-1] && box1->grid_seq > res[n-1]->grid_seq)))
+            continue;
+          if (accept && !accept(box1, data)) continue;
+          /* insert sorted by distance and list order */
+          for (j = (n < k) ? n++ : n - 1; j > 0; j--) {
+            if (dist[j-1] < d
+             || (dist[j-1] == d && res[j-1]->grid_seq < box1->grid_seq))
+              break;
+            dist[j] = dist[j-1];  res[j] = res[j-1];
+          }
+          dist[j] = d;  res[j] = box1;
+        }
+      }
+    }
+    /* boxes outside the ring have a distance of at least r*m+1 */
+    bound = (r * m + 1);
+    if ((double)bound * bound > maxdist2) break;
+    if (n == k && dist[n-1] < bound * bound) break;
+  }
+  return n;
+}
+
+/* get the k nearest boxes to the point x,y (measured to the middle of
+ *  the boxes, squared distance <= maxdist2) for which accept() returns 1
+ *  (accept may be NULL), nearest first into buf[], returns number */
+int box_grid_nearest (box_grid_t *grid, int x, int y, int k, int maxdist2,
+              int (*accept)(struct box *box1, void *data), void *data,
+              struct box ***buf, int *bufsize) {
+  int n, *dist;
+  if (k < 1) return 0;
+  if (k > *bufsize) {
+    struct box **nbuf =
+      (struct box **)realloc(*buf, k * sizeof(struct box *));
+    if (!nbuf) {
+      fprintf(stderr, "realloc error in box_grid_nearest %d\n", k);
+      return 0;
+    }
+    *buf = nbuf;  *bufsize = k;
+  }
+  dist = (int *)malloc(k * sizeof(int));
+  if (!dist) return 0;
+  n = grid_knn(grid, x, y, k, maxdist2, -1, NULL, accept, data, *buf, dist);
+  free(dist);
+  return n;
+}
+
+/* nearest box right of box1 (middle of box is not left of the middle
+ *  of box1) for which accept() returns 1, NULL if there is none */
+struct box *box_grid_right_neighbour (box_grid_t *grid, struct box *box1,
+              int maxdist2,
+              int (*accept)(struct box *box1, void *data), void *data) {
+  struct box *res = NULL;
+  int dist, x = (box1->x0 + box1->x1) / 2, y = (box1->y0 + box1->y1) / 2;
+  if (grid_knn(grid, x, y, 1, maxdist2, x, box1, accept, data, &res, &dist))
+    return res;
+  return NULL;
+}
@@ -75,10 +75,13 @@ int load_db(job_t *job) {  // called by gocr.c main()
     if( !pp ) fprintf(stderr,"malloc error in load_db pix\n");
 
     // if (job->cfg.verbose) fprintf(stderr,"\n# readpgm %s ",s2);
-    if (readpgm(s2, pp, 0 * job->cfg.verbose)!=0) {
+    if (!pp || readpgm(s2, pp, 0 * job->cfg.verbose)!=0) {
       fprintf(stderr,"\ndatabase error: readpgm %s\n", s2);
-      exit(-1);
+      if (pp) free(pp);
+      fclose(f1);
+      return -1; /* was exit(-1), v0.53 */
     }
+    pp->job = job;
 
     box1 = (struct box *)malloc_box(NULL);
     if(!box1) fprintf(stderr,"malloc error in load_db box1\n");
@@ -134,6 +137,20 @@ int load_db(job_t *job) {  // called by gocr.c main()
   return 0;
 }
 
+/* free the boxes and images loaded by load_db(), v0.53
+ *  boxes appended by the interactive mode belong to the image pool */
+void free_db(job_t *job) {
+  struct box *box2;
+  for_each_data(&job->tmp.dblist) {
+    box2 = (struct box *)list_get_current(&job->tmp.dblist);
+    if (!box2->pool) {
+      if (box2->p) { free(box2->p->p); free(box2->p); }
+      free_box(box2);
+    }
+  } end_for_each(&job->tmp.dblist);
+  list_free(&job->tmp.dblist);
+}
+
 // expand database from box/boxlist name=db_$utime.pbm
 // this is added in version v0.3.3
 int store_db(struct box *box1, job_t *job) {
@@ -216,7 +233,7 @@ int store_db(struct box *box1, job_t *job) {
  */
 void out_env(struct box *px, job_t *job){
   int x0,y0,x1,y1,dx,dy,x,y,x2,y2,yy0,tx,ty,i,cs;
-  char c1, c2; pix *b;
+  char c1, c2, dbuf[DECODE_BUFLEN]; pix *b;
   cs=job->cfg.cs;
   yy0=px->y0;
   { /* overwrite rest of arguments */
@@ -245,7 +262,7 @@ void out_env(struct box *px, job_t *job){
         if (px->tas[i])
          fprintf(stderr," %s(%d)",       px->tas[i]       ,px->wac[i]);
         else
-         fprintf(stderr," %s(%d)",decode(px->tac[i],ASCII),px->wac[i]);
+         fprintf(stderr," %s(%d)",decode_r(px->tac[i],ASCII,dbuf),px->wac[i]);
     }
     fprintf(stderr,"\n");
     if (px->dots && px->m2 && px->m1<y0) { yy0=px->m1; dy=px->y1-yy0+1; }
@@ -64,9 +64,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
   - for each box look at it neighbours and set box-m1..m4
   - m[1..4].max .min if m4.min-m3.max<1 probability lower
  */
-int detect_lines1(pix * p, int x0, int y0, int dx, int dy)
+int detect_lines1(job_t *job, pix * p, int x0, int y0, int dx, int dy)
 {
-  job_t *job=OCR_JOB; /* fixme global var */
   int i, jj, /*j2,*/ y, yy, my, mi, /* mc,*/ i1, i2, i3, i4,
       m1, m2, m3, m4, ma1, ma2, ma3, ma4, m3pre, m4pre,
       mt1, mt2, mt4, mtc; /* 2017 from global triple-pxH */
@@ -193,6 +192,7 @@ int detect_lines1(pix * p, int x0, int y0, int dx, int dy)
   // ToDo: better function for scanning line around a letter ???
   //       or define lines around known chars "eaTmM"
   for (/*j2 =*/ y = y0; y < y0 + dy; y++) { /* line by line loop */
+    if (tlines_grow(lines, i + 1)) break; /* room for line i, v0.53 */
     // look for max. of upper and lower bound of next line
     m1 = y0 + dy;
     jj = 0;
@@ -513,12 +513,8 @@ int detect_lines1(pix * p, int x0, int y0, int dx, int dy)
 	fprintf(stderr, "  L%02d final  y= %3d m= %4d %+3d %+3d %+3d x= %3d %+3d w= %d\n#",
 		i, y, m1, m2 - m1, m3 - m1, m4 - m1, lines->x0[i],
 		lines->x1[i] - lines->x0[i], lines->wt[i]);
-      if (i < MAXlines && m4 - m1 > 4)
+      if (m4 - m1 > 4)
 	i++;
-      if (i >= MAXlines) {
-	fprintf(stderr, "Warning: lines>MAXlines\n");
-	break;
-      }
     }
     if (m3+m4>2*y) y = (m3+m4)/2;  /* lower end may overlap the next line */
     if (m3>m3pre) m3pre = m3; else m3=y0; /* set for next-line scan */
@@ -534,10 +530,9 @@ int detect_lines1(pix * p, int x0, int y0, int dx, int dy)
 // ----- detect lines via recursive division (new version) ---------------
 //   what about text in frames???
 //  ToDo: change to bottom-top analyse or/and take rotation into account
-int detect_lines2(pix *p,int x0,int y0,int dx,int dy,int r){
+int detect_lines2(job_t *job, pix *p,int x0,int y0,int dx,int dy,int r){
     int i,x2,y2,x3,y3,x4,y4,x5,y5,y6,mx,my,x30,x31,y30,y31;
     struct box *box2,*box3;
-    job_t *job=OCR_JOB; /* fixme */
     // shrink box
     if(dx<=0 || dy<=0) return 0;
     if(y0+dy<  p->y/128 && y0==0) return 0;       /* looks like dust */
@@ -545,6 +540,9 @@ int detect_lines2(pix *p,int x0,int y0,int dx,int dy,int r){
     
     if(r>1000){ return -1;} // something is wrong
     if(job->cfg.verbose)fprintf(stderr,"\n# r=%2d ",r);
+    /* no black 8x8 block = no box inside, skip the box loops, v0.53 */
+    if (PIX_BITS_OK(p, job->cfg.cs)
+     && pix_pyr_empty(p, PIX_PYR, x0, x0+dx-1, y0, y0+dy-1)) return 0;
 
     mx=my=i=0; // mean thickness
     // remove border, shrink size
@@ -648,11 +646,11 @@ int detect_lines2(pix *p,int x0,int y0,int dx,int dy,int r){
         ((i)?( (i==1)?"x":"y" ):"?"),x2,y2,x3,y3);
       // divide horizontally if v-gap is thicker than h-gap
       // and length is larger 5*width
-      if(i==1){        detect_lines2(p,x0,y0,x2-x0+1,dy,r+1);
-                return detect_lines2(p,x2,y0,x0+dx-x2+1,dy,r+1); }
+      if(i==1){        detect_lines2(job,p,x0,y0,x2-x0+1,dy,r+1);
+                return detect_lines2(job,p,x2,y0,x0+dx-x2+1,dy,r+1); }
       // divide vertically
-      if(i==2){        detect_lines2(p,x0,y0,dx,y2-y0+1,r+1);
-                return detect_lines2(p,x0,y2,dx,y0+dy-y2+1,r+1);  
+      if(i==2){        detect_lines2(job,p,x0,y0,dx,y2-y0+1,r+1);
+                return detect_lines2(job,p,x0,y2,dx,y0+dy-y2+1,r+1);  
       }
     }
 
@@ -667,7 +665,7 @@ int detect_lines2(pix *p,int x0,int y0,int dx,int dy,int r){
         for(i=0;i<dy;i++)put(&job->tmp.ppo,x0+dx-1,y0+i   ,255,16);
         // writebmp("out10.bmp",p2,job->cfg.verbose); // colored should be better
     }
-    return detect_lines1(p,x0-0*1,y0-0*2,dx+0*2,dy+0*3);
+    return detect_lines1(job,p,x0-0*1,y0-0*2,dx+0*2,dy+0*3);
 
 /*
     struct tlines *lines = &job->res.lines;
@@ -694,6 +692,54 @@ int my_sqrt(int x){
   return y0;
 }
 
+#define INorm 1024   /* integer unit 1.0 */
+/* data of rotation_nb_accept() */
+struct rotation_nb_s {
+  struct box *box2;  /* box, which neighbour is searched */
+  int x2, y2, pass;  /* middle point of box2 */
+  int *dx, *dy, *er; /* results of the passes */
+};
+
+/* try to select only potential neighbouring chars (right of box2)
+ *  for detect_rotation_angle(), used by box_grid_right_neighbour() */
+static int rotation_nb_accept(struct box *box3, void *data) {
+  struct rotation_nb_s *d = (struct rotation_nb_s *)data;
+  struct box *box2 = d->box2;
+  int x2 = d->x2, y2 = d->y2, x3, y3, re, dist, pass = d->pass;
+
+  /* select out all senseless combinations */ 
+  if (box3->c==PICTURE) return 0;
+  x3 = (box3->x0 + box3->x1)/2;
+  y3 = (box3->y0 + box3->y1)/2; /* get middle point of the box */
+  // through-away deviation of angles if > pass-1?
+  // scalprod max in direction, cross prod min in direction
+  //  a,b (vectors): <a,b>^2/(|a|*|b|)^2 = 0(90deg)..0.5(45deg).. 1(0deg)
+  //   * 1024 ??
+  if (pass>0) {  // new variant = scalar product
+    // danger of int overflow, ToDo: use int fraction
+    re =(int) ((1.*(x3-x2)*d->dx[pass-1]+(y3-y2)*d->dy[pass-1])
+        *(1.*(x3-x2)*d->dx[pass-1]+(y3-y2)*d->dy[pass-1])*INorm
+        /(1.*((x3-x2)*(x3-x2)+(y3-y2)*(y3-y2))
+         *(1.*d->dx[pass-1]*d->dx[pass-1]+d->dy[pass-1]*d->dy[pass-1])));
+    if (INorm-re>d->er[pass-1]) return 0; // hits mean deviation
+  }
+  /* neighbours should have same order of size (?) */
+  if (3*(box3->y1-box3->y0+4) < 2*(box2->y1-box2->y0+1)) return 0;
+  if (2*(box3->y1-box3->y0+1) > 3*(box2->y1-box2->y0+4)) return 0;
+  if (2*(box3->x1-box3->x0+1) > 5*(box2->x1-box2->x0+4)) return 0;
+  if (5*(box3->x1-box3->x0+4) < 2*(box2->x1-box2->x0+1)) return 0;
+  /* should be in right range, Idea: center3 outside box2? noholes */
+  if ((x3<box2->x1-1) && (x3>box2->x0+1)
+   && (y3<box2->y1-1) && (y3>box2->y0+1)) return 0;
+  // if chars are of different size, connect careful 
+  if (  abs(x3-x2) > 2*(box2->x1 - box2->x0 + box3->x1 - box3 ->x0 + 2)) return 0;
+  if (  abs(y3-y2) >   (box2->x1 - box2->x0 + box3->x1 - box3 ->x0 + 2)) return 0;
+  dist = (y3-y2)*(y3-y2) + (x3-x2)*(x3-x2);
+  // make distances in pass-1 directions shorter or continue if not in pass-1 range?
+  if (dist<9) return 0; /* minimum distance^2 is 3^2 */
+  return 1;
+}
+
 /*
 ** Detect rotation angle (one for whole image)
 ** old: longest text-line and determining the angle of this line.
@@ -708,11 +754,10 @@ int my_sqrt(int x){
  * ToDo: estimate an error, boxes only work fine for zero-rotation
  *       for 45 degree use vectors, not boxes to get base line
  */
-#define INorm 1024   /* integer unit 1.0 */
 int detect_rotation_angle(job_t *job){
   struct box *box2, *box3,
         *box_nn;  /* nearest neighbour box */
-  int x2, y2, x3, y3, dist, mindist, pass,
+  int x2, y2, x3, y3, mindist, pass, dm,
       rx=0, ry=0, re=0,  // final result
       /* to avoid 2nd run, wie store pairs in 2 different categories */
       nn[4]={0,0,0,0}, /* num_pairs used for estimation [(pass-1)%2,pass%2] */ 
@@ -722,7 +767,10 @@ int detect_rotation_angle(job_t *job){
       // de;         /* ToDo: absolute maximum error (dx^2+dy^2) */ 
       // ToDo: next pass: go to bigger distances and reduce max error
       // error is diff between passes? or diff of bottoms and top borders (?)
+  struct rotation_nb_s nb;
 
+  nb.dx = dx;  nb.dy = dy;  nb.er = er;
+  box_grid_build(&job->tmp.boxgrid, job);
   rx=1024; ry=0;  // default
   for (pass=0;pass<4;pass++) {
     for_each_data(&(job->res.boxlist)) {
@@ -744,48 +792,22 @@ int detect_rotation_angle(job_t *job){
       y2 = (box2->y0 + box2->y1)/2;
       re=0;
       /* search for nearest neighbour box_nn[pass+1] of box_nn[pass] */
-      for_each_data(&(job->res.boxlist)) {
-        box3 = (struct box *)list_get_current(&(job->res.boxlist));
-        /* try to select only potential neighbouring chars */
-        /* select out all senseless combinations */ 
-        if (box3->c==PICTURE || box3==box2) continue;
+      /* neighbours are less than 2.5 times wider (see accept), so
+       *  they are within 2*dm horizontally and within dm vertically */
+      dm = box2->x1 - box2->x0 + 5*(box2->x1 - box2->x0 + 4)/2 + 1;
+      nb.box2 = box2;  nb.x2 = x2;  nb.y2 = y2;  nb.pass = pass;
+      box3 = box_grid_right_neighbour(&job->tmp.boxgrid, box2,
+        (5.*dm*dm < mindist) ? 5*dm*dm : mindist - 1, rotation_nb_accept, &nb);
+      if (box3) {
         x3 = (box3->x0 + box3->x1)/2;
-        y3 = (box3->y0 + box3->y1)/2; /* get middle point of the box */
-        if (x3<x2) continue; /* simplify by going right only */
-        // through-away deviation of angles if > pass-1?
-        // scalprod max in direction, cross prod min in direction
-        //  a,b (vectors): <a,b>^2/(|a|*|b|)^2 = 0(90deg)..0.5(45deg).. 1(0deg)
-        //   * 1024 ??
-        if (pass>0) {  // new variant = scalar product
-          // danger of int overflow, ToDo: use int fraction
-          re =(int) ((1.*(x3-x2)*dx[pass-1]+(y3-y2)*dy[pass-1])
-              *(1.*(x3-x2)*dx[pass-1]+(y3-y2)*dy[pass-1])*INorm
-              /(1.*((x3-x2)*(x3-x2)+(y3-y2)*(y3-y2))
-               *(1.*dx[pass-1]*dx[pass-1]+dy[pass-1]*dy[pass-1])));
-          if (INorm-re>er[pass-1]) continue; // hits mean deviation
-        }
-        /* neighbours should have same order of size (?) */
-        if (3*(box3->y1-box3->y0+4) < 2*(box2->y1-box2->y0+1)) continue;
-        if (2*(box3->y1-box3->y0+1) > 3*(box2->y1-box2->y0+4)) continue;
-        if (2*(box3->x1-box3->x0+1) > 5*(box2->x1-box2->x0+4)) continue;
-        if (5*(box3->x1-box3->x0+4) < 2*(box2->x1-box2->x0+1)) continue;
-        /* should be in right range, Idea: center3 outside box2? noholes */
-        if ((x3<box2->x1-1) && (x3>box2->x0+1)
-         && (y3<box2->y1-1) && (y3>box2->y0+1)) continue;
-        // if chars are of different size, connect careful 
-        if (  abs(x3-x2) > 2*(box2->x1 - box2->x0 + box3->x1 - box3 ->x0 + 2)) continue;
-        if (  abs(y3-y2) >   (box2->x1 - box2->x0 + box3->x1 - box3 ->x0 + 2)) continue;
-        dist = (y3-y2)*(y3-y2) + (x3-x2)*(x3-x2);
-        // make distances in pass-1 directions shorter or continue if not in pass-1 range?
-        if (dist<9) continue; /* minimum distance^2 is 3^2 */
-        if (dist<mindist) { mindist=dist; box_nn=box3;}
-        // fprintf(stderr,"x y %d %d  %d %d dist %d min %d\n",
-        //         x2,y2,x3,y3,dist,mindist);
-      } end_for_each(&(job->res.boxlist));
+        y3 = (box3->y0 + box3->y1)/2;
+        mindist = (y3-y2)*(y3-y2) + (x3-x2)*(x3-x2);
+        box_nn = box3;
+      }
       
       if (box_nn==box2) continue; /* has no neighbour, next box */
       
-      box3=box_nn; dist=mindist;
+      box3=box_nn;
       x3 = (box3->x0 + box3->x1)/2;
       y3 = (box3->y0 + box3->y1)/2; /* get middle point of the box */
       // dist = my_sqrt(1024*((x3-x2)*(x3-x2)+(y3-y2)*(y3-y2)));
@@ -830,6 +852,7 @@ int detect_rotation_angle(job_t *job){
                      " %6d %6d %6d %4d pass %d\n",
               rx, ry, er[pass], nn[pass], pass+1);
   }
+  box_grid_free(&job->tmp.boxgrid);
   if (abs(ry*100)>abs(rx*50))
     fprintf(stderr,"<!-- gocr will fail, strong rotation angle detected -->\n");
   /* ToDo: normalize to 2^10 bit (square fits to 32 it) */
@@ -839,27 +862,26 @@ int detect_rotation_angle(job_t *job){
 }
 
 /* ----- detect lines --------------- */
-int detect_text_lines(pix * pp, int mo) {
-  int vvv=OCR_JOB->cfg.verbose; /* fixme (global var) */
+int detect_text_lines(job_t *job, pix * pp, int mo) {
+  int vvv=job->cfg.verbose;
 
   if (vvv)
     fprintf(stderr, "# detect.c detect_text_lines (vvv=16 for more info)\n");
   if (mo & 4){
     if (vvv) fprintf(stderr, "# zoning\n# ... ");
-    detect_lines2(pp, 0, 0, pp->x, pp->y, 0);	// later replaced by better algo
+    detect_lines2(job, pp, 0, 0, pp->x, pp->y, 0);	// later replaced by better algo
     if (vvv) fprintf(stderr,"\n");
   } else 
-    detect_lines1(pp, 0, 0, pp->x, pp->y);	// old algo
+    detect_lines1(job, pp, 0, 0, pp->x, pp->y);	// old algo
   return 0;
 }
 
 
 /* ----- adjust lines --------------- */
-// rotation angle? OCR_JOB->res.lines.dy, .x0  removed later
+// rotation angle? job->res.lines.dy, .x0  removed later
 // this is for cases, where m1..m4 is not very sure detected before 
 //  chars are recognized
-int adjust_text_lines(pix * pp, int mo) {
-  job_t *job=OCR_JOB; /* fixme */
+int adjust_text_lines(job_t *job, pix * pp, int mo) {
   struct box *box2;
   int *m, /* summ m1..m4, num_chars for m1..m4, min m1..m4, max. m1..m4 */
       l, i, dy, dx, diff=0, y0, y1;
@@ -999,10 +1021,9 @@ int adjust_text_lines(pix * pp, int mo) {
  * recalculate mean width and high after changes in boxlist
  * ToDo: only within a Range?
  */
-int calc_average() {
+int calc_average(job_t *job) {
   int i = 0, x0, y0, x1, y1;
   struct box *box4;
-  job_t *job=OCR_JOB; /* fixme */
 
   job->res.numC = 0;
   job->res.sumY = 0;
@@ -1041,8 +1062,9 @@ int calc_average() {
 /* ---- analyse boxes, find pictures and mark (do this first!!!)
  */
 int detect_pictures(job_t *job) {
-  int i = 0, x0, y0, x1, y1, num_h;
-  struct box *box2, *box4;
+  int i = 0, x0, y0, x1, y1, y2, y3, num_h, n, nnb = 0, fast;
+  struct box *box2, *box4, **nb = NULL; /* nb = boxes near box2 */
+  pix *p = &job->src.p;
 
   if ( job->res.numC == 0 ) {
     if (job->cfg.verbose) fprintf(stderr,
@@ -1056,6 +1078,8 @@ int detect_pictures(job_t *job) {
   if (job->cfg.verbose)
     fprintf(stderr, "# detect.c L%d pictures, frames, mXmY= %d %d ... ",
   	    __LINE__, job->res.avX, job->res.avY);
+  box_grid_build(&job->tmp.boxgrid, job);
+  fast = PIX_BITS_OK(p, job->cfg.cs);
   for_each_data(&(job->res.boxlist)) {
     box2 = (struct box *)list_get_current(&(job->res.boxlist));
     if (box2->c == PICTURE) continue;
@@ -1067,8 +1091,21 @@ int detect_pictures(job_t *job) {
       /* count objects on same baseline which could be chars */
       /* else: big headlines could be misinterpreted as pictures */
       num_h=0;
-      for_each_data(&(job->res.boxlist)) {
-        box4 = (struct box *)list_get_current(&(job->res.boxlist));
+      /* boxes on the same baseline are inside the rows y2..y3, if the
+         rows are white left and right of box2 by the 8x8 blocks, only
+         the boxes over x0..x1 are candidates, v0.53 */
+      y2 = y0 - (y1-y0+1)/2; if (y2 < 0) y2 = 0;
+      y3 = y1 + (y1-y0+1)/2;
+      if (fast && (x0 < 8 || pix_pyr_empty(p, PIX_PYR, 0, x0-8, y2, y3))
+               && (x1 + 8 >= p->x
+                || pix_pyr_empty(p, PIX_PYR, x1+8, p->x-1, y2, y3)))
+        n = box_grid_query(&job->tmp.boxgrid, x0 & ~7, y2,
+                           x1 | 7, y3, &nb, &nnb);
+      else
+        n = box_grid_query(&job->tmp.boxgrid, 0, y0 - (y1-y0+1)/2,
+                           job->src.p.x - 1, y1 + (y1-y0+1)/2, &nb, &nnb);
+      while (n--) {
+        box4 = nb[n];
         if (box4->c == PICTURE) continue;
         if (box4->y1-box4->y0 > 2*(y1-y0)) continue;
         if (2*(box4->y1-box4->y0) < y1-y0) continue;
@@ -1078,17 +1115,19 @@ int detect_pictures(job_t *job) {
          || box4->y1 < y1 - (y1-y0+1)/2)  continue;
         // ToDo: continue if numcross() only 1, example: |||IIIll|||
         num_h++;
-      } end_for_each(&(job->res.boxlist));
+      }
       if (num_h>4) continue;
       box2->c = PICTURE;
       i++;
     }
     /* ToDo: pictures could have low contrast=Sum((pixel(p,x,y)-160)^2) */
   } end_for_each(&(job->res.boxlist));
+  box_grid_free(&job->tmp.boxgrid);
+  if (nb) free(nb);
   // start second iteration
   if (job->cfg.verbose) {
     fprintf(stderr, " %d - boxes %d\n", i, job->res.numC-i);
   }
-  calc_average();
+  calc_average(job);
   return 0;
 }
@@ -73,6 +73,9 @@ static void help(void) {
   fprintf(stderr, /* string length less than 509 bytes for ISO C89 */
 	  " -f fmt    - output format (ISO8859_1 TeX HTML XML UTF8 ASCII)\n"
 	  " -l num    - threshold grey level 0<160<=255 (0 = autodetect)\n"
+	  " --local[=sauvola|wolf[,w[,k]]] - local threshold (uneven light),\n"
+	  "             w=3..255 pixels (31), k in percent (34, wolf 50)\n");
+  fprintf(stderr, /* string length less than 509 bytes for ISO C89 */
 	  " -d num    - dust_size (remove small clusters, -1 = autodetect)\n"
 	  " -s num    - spacewidth/dots (0 = autodetect)\n"
 	  " -v num    - verbose (see manual page)\n"
@@ -81,7 +84,14 @@ static void help(void) {
 	  " -m num    - operation modes (bitpattern, see manual)\n");
   fprintf(stderr, /* string length less than 509 bytes for ISO C89 */
 	  " -a num    - value of certainty (in percent, 0..100, default=95)\n"
-	  " -u string - output this string for every unrecognized character\n");
+	  " -u string - output this string for every unrecognized character\n"
+	  " --serve[=socket] - server mode, requests on stdin or unix socket\n"
+	  " --band[=rows] - read and recognize large pages in bands of rows\n"
+	  " --threads=n - n threads for pages, files and the preprocessing\n");
+  fprintf(stderr, /* string length less than 509 bytes for ISO C89 */
+	  " --norm[=h] - reduce high-dpi pages to glyphs of h pixels (24), off\n"
+	  " --list=name - batch mode, read input file names from name (- stdin)\n"
+	  " --suffix=.txt - batch mode, text of file x to x.txt, not stdout\n");
   fprintf(stderr, /* string length less than 509 bytes for ISO C89 */
 	  " examples:\n"
 	  "\tgocr -m 4 text1.pbm                   # do layout analyzis\n"
@@ -120,7 +130,19 @@ static int timeval_subtract (struct timeval *result, struct timeval *x,
 }
 #endif
 
-static void process_arguments(job_t *job, int argn, char *argv[])
+/* options of main() which are not part of job->cfg, v0.53 */
+typedef struct main_opt_s {
+  int serve;         /* --serve[=path] */
+  char *serve_path;  /* NULL for stdin */
+  int band;          /* --band[=rows] */
+  char **files;      /* input files of the command line (argn entries) */
+  int nfiles;
+  char *list;        /* --list=name, file with names of input files */
+  char *suffix;      /* --suffix=.txt, output to file name + suffix */
+} main_opt_t;
+
+static void process_arguments(job_t *job, int argn, char *argv[],
+                              main_opt_t *o)
 {
   int i;
   char *s1;
@@ -143,6 +165,70 @@ static void process_arguments(job_t *job, int argn, char *argv[])
     if (strcmp(argv[i], "--version") == 0
      || strcmp(argv[i], "-V")        == 0) { /* and quits  2018-09 */
        printf(version_string "-" release_string "\n"); exit(0);}
+    if (strncmp(argv[i], "--serve", 7) == 0
+     && (argv[i][7] == '\0' || argv[i][7] == '=')) {
+      o->serve = 1;
+      o->serve_path = (argv[i][7] == '=') ? argv[i] + 8 : NULL;
+      continue;
+    }
+    if (strncmp(argv[i], "--band", 6) == 0
+     && (argv[i][6] == '\0' || argv[i][6] == '=')) {
+      o->band = (argv[i][6] == '=') ? atoi(argv[i] + 7) : 1024;
+      if (o->band <= 0) o->band = 1024;
+      continue;
+    }
+    if (strncmp(argv[i], "--list=", 7) == 0) {
+      o->list = argv[i] + 7;
+      continue;
+    }
+    if (strncmp(argv[i], "--suffix=", 9) == 0) {
+      o->suffix = argv[i] + 9;
+      continue;
+    }
+    if (strncmp(argv[i], "--local", 7) == 0
+     && (argv[i][7] == '\0' || argv[i][7] == '=')) {
+      char *s2;
+      long w = 0, k = 0; /* 0 = auto */
+      s1 = (argv[i][7] == '=') ? argv[i] + 8 : "sauvola";
+      if (strncmp(s1, "sauvola", 7) == 0 && (s1[7] == '\0' || s1[7] == ','))
+        { job->cfg.local = 1; s1 += 7; }
+      else if (strncmp(s1, "wolf", 4) == 0 && (s1[4] == '\0' || s1[4] == ','))
+        { job->cfg.local = 2; s1 += 4; }
+      else s1 = NULL;
+      if (s1 && *s1 == ',') { /* w = 0 or 3..255 pixels */
+        w = strtol(s1 + 1, &s2, 10);
+        s1 = (s2 == s1 + 1 || (w && (w < 3 || w > 255))) ? NULL : s2;
+      }
+      if (s1 && *s1 == ',') { /* k = 0..100 percent, no 0.34 */
+        k = strtol(s1 + 1, &s2, 10);
+        s1 = (s2 == s1 + 1 || k < 0 || k > 100) ? NULL : s2;
+      }
+      if (!s1 || *s1) {
+        fprintf(stderr, "ERROR: --local=sauvola|wolf[,w[,k]], try --help\n");
+        exit(1);
+      }
+      job->cfg.local_w = (int)w;
+      job->cfg.local_k = (int)k;
+      continue;
+    }
+    if (strcmp(argv[i], "--norm") == 0) {
+      job->cfg.norm = 24;
+      continue;
+    }
+    if (strncmp(argv[i], "--norm=", 7) == 0) {
+      job->cfg.norm = atoi(argv[i] + 7);
+      if (job->cfg.norm < 0) job->cfg.norm = 0;
+      continue;
+    }
+    if (strncmp(argv[i], "--threads=", 10) == 0) {
+      job->cfg.threads = atoi(argv[i] + 10);
+      if (job->cfg.threads < 1) job->cfg.threads = 1;
+#ifndef HAVE_PTHREAD_H
+      fprintf(stderr, "# compiled without pthread, --threads ignored\n");
+      job->cfg.threads = 1;
+#endif
+      continue;
+    }
     if (argv[i][0] == '-' && argv[i][1] != 0) {
       if (i + 1 < argn && argv[i][2]=='\0') { s1 = argv[i + 1]; iskip=1; }
       else if (argv[i][2]!='\0')              s1 = argv[i]+2;
@@ -152,7 +238,9 @@ static void process_arguments(job_t *job, int argn, char *argv[])
            }
       switch (argv[i][1]) {
       case 'i': /* input image file */
-	job->src.fname = s1; break;
+	job->src.fname = s1;
+	o->files[o->nfiles++] = s1; /* for the batch mode too */
+	break;
       case 'e': /* logging file */
 	if (s1[0] == '-' && s1[1] == '\0') {
 #ifdef HAVE_UNISTD_H
@@ -218,6 +306,7 @@ static void process_arguments(job_t *job, int argn, char *argv[])
     else /* argument can be filename v0.2.5 */ if (argv[i][0] != '-'
 						   || argv[i][1] == '\0' ) {
       job->src.fname = argv[i];
+      o->files[o->nfiles++] = argv[i]; /* more than one: batch mode */
     }
   }
 }
@@ -282,15 +371,20 @@ static int read_picture(job_t *job) {
   assert(job);
 
   if (strstr(job->src.fname, ".pcx"))
-    /* readpcx will exit on error (security) */
-    readpcx(job->src.fname, &job->src.p, job->cfg.verbose);
+    rc=readpcx(job->src.fname, &job->src.p, job->cfg.verbose);
   else
-    rc=readpgm(job->src.fname, &job->src.p, job->cfg.verbose);
+    rc=readpgm_stream(&job->src.stream, job->src.fname, &job->src.p,
+                      job->cfg.verbose);
   return rc; /* 1 for multiple images, -1 on error, 0 else */
 }
 
 /* subject of change, we need more output for XML (ToDo) */
 void print_output(job_t *job) {
+  fprint_output(stdout, job);
+}
+
+/* print the text to f, used for the output files of batch mode */
+void fprint_output(FILE *f, job_t *job) {
   int linecounter = 0;
   const char *line;
 
@@ -303,36 +397,71 @@ void print_output(job_t *job) {
   line = getTextLine(&(job->res.linelist), linecounter++);
   while (line) {
     /* notice: decode() is shiftet to getTextLine since 0.38 */
-    fputs(line, stdout);
-    if (job->cfg.out_format==HTML) fputs("<br />",stdout);
-    if (job->cfg.out_format!=XML)  fputc('\n', stdout);
+    fputs(line, f);
+    if (job->cfg.out_format==HTML) fputs("<br />",f);
+    if (job->cfg.out_format!=XML)  fputc('\n', f);
     line = getTextLine(&(job->res.linelist), linecounter++);
   }
   free_textlines(&(job->res.linelist));
 }
 
-/* FIXME jb: remove JOB; renamed to OCR_JOB 2010-09-26 */
-job_t *OCR_JOB;
-
 
 /* -------------------------------------------------------------
 // ------   MAIN - replace this by your own aplication! 
 // ------------------------------------------------------------- */
 int main(int argn, char *argv[]) {
   int multipnm=1;
-  job_t job1, *job; /* fixme, dont want global variables for lib */
-  job=OCR_JOB=&job1;
+  main_opt_t opt;
+  job_t job1, *job; /* no global job since v0.53, several jobs possible */
+  job=&job1;
 
   setvbuf(stdout, (char *) NULL, _IONBF, 0);	/* not buffered */
 
   job_init(job); /* init fname, db, cfg */
 
-  process_arguments(job, argn, argv);
+  memset(&opt, 0, sizeof(opt));
+  opt.files = (char **)malloc(argn * sizeof(char *));
+  if (!opt.files) { fprintf(stderr, "ERROR: no memory\n"); return -1; }
+  process_arguments(job, argn, argv, &opt);
   
   /* load character data base (JS1002: now outside pgm2asc) */
   if ( job->cfg.mode & 2 ) /* check for db-option flag */
-    load_db(job);
+    if (load_db(job)<0) { /* broken database, 255 as before */
+      free(opt.files); return -1; }
     /* load_db uses readpnm() and would conflict with multi images */
+
+  if (opt.serve) { /* db and filter tables stay loaded for all requests */
+    free(opt.files); /* files come by the socket */
+    return ((serve(job, opt.serve_path)<0)?-1:0);
+  }
+
+  if (opt.nfiles > 1 || opt.list || opt.suffix) { /* batch mode */
+    mark_start(job);
+    multipnm = batch_ocr(job, opt.files, opt.nfiles, opt.list, opt.suffix);
+    mark_end(job);
+    free(opt.files);
+    return ((multipnm<0)?-1:0);
+  }
+  free(opt.files); /* one file, job->src.fname */
+  job->src.stream.threads = job->cfg.threads; /* conversion to gray */
+
+  if (opt.band) { /* memory bounded by the band, not the page */
+    mark_start(job);
+    multipnm = band_ocr(job, opt.band);
+    mark_end(job);
+    return ((multipnm<0)?-1:0);
+  }
+
+#ifdef HAVE_PTHREAD_H
+  /* pages on worker threads, not for the interactive mode (stdin) */
+  if (job->cfg.threads > 1 && !(job->cfg.mode & 128)
+   && !strstr(job->src.fname, ".pcx")) {
+    mark_start(job);
+    multipnm = pipe_ocr(job);
+    mark_end(job);
+    return ((multipnm<0)?-1:0);
+  }
+#endif
         
   while (multipnm==1) { /* multi-image loop */
 
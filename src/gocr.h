@@ -64,31 +64,48 @@ typedef enum direction DIRECTION;
 #define RIS 3    /* rising=steigend */
 #define FAL 4    /* falling=fallend */
 
-#define MAXlines 1024
+/* per line data, arrays are growing with the number of lines (v0.53),
+ *  see tlines_init(), tlines_grow(), tlines_free() in lines.c */
+#define TLinesStep 64
+
+/* boxes of one text line, ordered like the boxlist, see tlines_set_boxes() */
+struct tline_boxes {
+    struct box **box;
+    int num, max;
+};
 
 /* ToDo: if we have a tree instead of a list, a line could be a node object */
 struct tlines {
     int num;
+    int max;            /* allocated entries of the per line arrays */
     int dx, dy;		/* direction of text lines (straight/skew) */
-    int m1[MAXlines],   /* start of line = upper bound of 'A' */
-        m2[MAXlines],   /* upper bound of 'e' */
-        m3[MAXlines],	/* lower bound of 'e' = baseline */
-        m4[MAXlines];	/* stop of line = lower bound of 'q' */
+    int *m1,            /* start of line = upper bound of 'A' */
+        *m2,            /* upper bound of 'e' */
+        *m3,		/* lower bound of 'e' = baseline */
+        *m4;		/* stop of line = lower bound of 'q' */
     /* ToDo: add sureness per m1,m2 etc? */
-    int x0[MAXlines],
-        x1[MAXlines];	/* left and right border */
-    int wt[MAXlines];   /* weight, how sure thats correct in percent, v0.41 */
-    int pitch[MAXlines]; /* word pitch (later per box?), v0.41 */
-    int mono[MAXlines];  /* spacing type, 0=proportional, 1=monospaced */
+    int *x0,
+        *x1;		/* left and right border */
+    int *wt;            /* weight, how sure thats correct in percent, v0.41 */
+    int *pitch;         /* word pitch (later per box?), v0.41 */
+    int *mono;          /* spacing type, 0=proportional, 1=monospaced */
+    struct tline_boxes *boxes; /* boxes per line, box->line==i, v0.53 */
 };
 
 #define NumAlt 10 /* maximal number of alternative chars (table length) */
 #define MaxNumFrames 8       /* maximum number of frames per char/box */
-#define MaxFrameVectors 128  /* maximum vectors per frame (*8=1KB/box) */
+#define MaxFrameVectors 128  /* vectors per box are simplified to this number */
+                             /* (storage is not limited since v0.53) */
+typedef int frame_vector_t[2]; /* x,y of a frame vector */
 /* ToDo: use only malloc_box(),free_box(),copybox() for creation, destroy etc.
  *       adding reference_counter to avoid pointer pointing to freed box
  */
 struct box { /* this structure should contain all pixel infos of a letter */
+    /* v0.53: first part (x0..p, 80 bytes) is used by most of the passes,
+     *        keep it together, rarely used and big data at the end,
+     *        the alternative and frame tables (272 bytes) stay inline,
+     *        boxes are copied by value and restored (whatletter(),
+     *        glued chars), a shared out-of-box part would break that */
     int x0,x1,y0,y1,x,y,dots; /* xmin,xmax,ymin,ymax,reference-pixel,i-dots */
     int num_boxes, /* 1 "abc", 2 "!i?", 3 "&auml;" (composed objects) 0.41 */
         num_subboxes;   /* 1 for "abdegopqADOPQR", 2 for "B"  (holes) 0.41 */
@@ -125,11 +142,51 @@ struct box { /* this structure should contain all pixel infos of a letter */
                 /* biggest frame should be stored first (outer frame) */
                 /* biggest has the maximum pair distance */
                 /* num vector loops */
-    int frame_vector[MaxFrameVectors][2]; /* may be 16*int=fixpoint_number */
-    
+    frame_vector_t *frame_vector; /* may be 16*int=fixpoint_number */
+                /* out of the box, allocated for the stored vectors only */
+    int max_frame_vectors; /* allocated size of frame_vector[] */
+    struct box_pool_s *pool; /* owner pool or NULL for malloc, v0.53 */
+    struct box *next_free;   /* free list of the pool */
+    struct box_grid_s *grid; /* spatial index holding the box or NULL */
+    int grid_seq;            /* list order, for sorting query results */
+    int gx0,gx1,gy0,gy1;     /* grid cells covered by the box */
 };
 typedef struct box Box;
 
+/* pool of boxes per image, allocated in slabs of BoxSlabSize boxes
+ *  freed boxes are reused, all boxes are released together (v0.53) */
+#define BoxSlabSize 256
+struct box_slab_s {
+    struct box_slab_s *next;
+    int num_used;            /* used boxes of this slab (never shrinks) */
+    struct box box[BoxSlabSize];
+};
+typedef struct box_pool_s {
+    struct box_slab_s *slabs; /* newest slab first */
+    struct box *free;         /* freed boxes for reuse */
+    int num_slabs;            /* statistics for -v */
+    int num_boxes, max_boxes; /* boxes in use, peak */
+    int num_reused;           /* number of boxes taken from free list */
+} box_pool_t;
+
+/* spatial index of the boxes of an image (uniform grid, v0.53)
+ *  cells are about 2x2 average chars, a box is linked into every
+ *  cell it covers, query results are returned in list order,
+ *  build it before a pass and free it after, merge_boxes() and
+ *  free_box() keep it up to date */
+typedef struct box_grid_s {
+    List *list;              /* indexed list (job->res.boxlist) */
+    int cw, ch;              /* cell size in pixels */
+    int nx, ny;              /* number of cells */
+    int *cell;               /* first node of each cell or -1, [nx*ny] */
+    struct box_grid_node_s {
+      struct box *box;
+      int next;              /* next node of the cell or free list, -1=end */
+    } *node;
+    int num_nodes, max_nodes, free_node;
+    int num_boxes;           /* indexed boxes */
+} box_grid_t;
+
 /* true if the coordination pair (a,b) is outside the image p */
 #define outbounds(p, a, b)  (a < 0 || b < 0 || a >= (p)->x || b >= (p)->y)
 
@@ -148,6 +205,12 @@ typedef struct job_s {
   struct {       /* source data */
     char *fname; /* input filename; default value: "-" */
     pix p;       /* source pixel data, pixelmap 8bit gray */
+    pnm_stream_t stream; /* open input file between multi-images, v0.53 */
+    int num_image;       /* number of images of this job, was static */
+    int band;            /* p is a band of a page (--band), the XML page */
+                         /*  tags are printed by band_ocr(), v0.53 */
+    int y0;              /* first row of the band in the page */
+    int line0;           /* text lines of the page before the band */
   } src;
   struct { /* temporary stuff, e.g. buffers */
 #ifdef HAVE_GETTIMEOFDAY
@@ -160,6 +223,16 @@ typedef struct job_s {
     int n_run;   /* num of run, if run_2 critical pattern get other results */
                  /* used for 2nd try, pixel uses slower filter function etc. */
     List dblist; /* list of boxes loaded from the character database */
+    box_pool_t boxpool; /* boxes of the current image (not dblist) */
+    box_grid_t boxgrid; /* spatial index of boxlist, valid during a pass */
+    char filter_tree[1024]; /* 3x3 filter tables of getpixel(), built at */
+    char filter_num[512];   /*  1st use, were static before v0.53 */
+    int  filter_init;       /* bit0: filter_tree, bit1: filter_num built */
+    int  warned;   /* bit0: frame_nn overflow, warnings printed once per job */
+    struct tpool_s *pool; /* threads of the preprocessing (--threads), */
+                          /*  NULL = 1 thread, v0.53 */
+    pix norm;   /* original image while src.p is reduced (--norm), v0.53 */
+    int norm_f; /* src.p = norm reduced by norm_f x norm_f, 1 = not */
   } tmp;
   struct {         /* results */
     List boxlist;  /* store every object in a box, which contains */
@@ -190,6 +263,14 @@ typedef struct job_s {
         /* limit of certainty where chars are accepted as identified */
     int  certainty; /* in units of 100 (percent); 0..100; default 95 */
     char *unrec_marker; /* output this string for every unrecognized char */
+    int  threads; /* worker threads (--threads=n); default 1, v0.53 */
+    int  local;   /* local thresholding (--local=...); 0 = otsu (global), */
+                  /*  1 = sauvola, 2 = wolf; default 0, v0.53 */
+    int  local_w; /* window size of local thresholding, 0 = auto (31) */
+    int  local_k; /* k in percent, 0 = auto (sauvola 34, wolf 50) */
+    int  norm;    /* reduce pages with glyphs higher 2*norm pixels to */
+                  /*  glyphs of >=norm pixels (--norm=h), 0 = off, */
+                  /*  default 24, v0.53 */
   } cfg;
 } job_t;
 
@@ -200,10 +281,6 @@ void job_init_image(job_t *job);  /* for each of a multiimage */
 /* free job structure */
 void job_free_image(job_t *job); /* for each of a multiimage */
 
-/* FIXME jb: remove JOB; 2010-09-25 renamed to OCR_JOB */
-/*  as a first step OCR_JOB will be remain in DO_DEBUG mode only */
-extern job_t *OCR_JOB;
-
 /* calculate the overlapp of the line (0-1) with black points 
  * by rekursiv bisection 
  * (evl. Fehlertoleranz mit pixel in Umgebung dx,dy suchen) (umschaltbar) ???
@@ -219,6 +296,9 @@ int get_line2(int x0, int y0, int x1, int y1, pix *p, int cs, int ret);
 /* look for white 0x02 or black 0x01 dots (0x03 = white+black) */
 char get_bw(int x0, int x1, int y0, int y1,
              pix *p, int cs,int mask);
+/* number of black pixels, clipped to the image, 0 if there is none (v0.53) */
+int count_black(int x0, int x1, int y0, int y1, pix *p, int cs);
+int empty_rect(int x0, int x1, int y0, int y1, pix *p, int cs);
 
 /* look for black crossing a line x0,y0,x1,y1
  * follow line and count crossings ([white]-black-transitions)
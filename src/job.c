@@ -20,14 +20,19 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "pgm2asc.h"
 #include "gocr.h"
+#include "tpool.h"
 
 /* initialize job structure cfg and db (for all images of a multiimage) */
 void job_init(job_t *job) {
   /* init source */
   job->src.fname = "-";
+  pnm_stream_init( &job->src.stream );
+  job->src.num_image = 0;
 
   /* init temporaries */
   list_init( &job->tmp.dblist ); 
+  job->tmp.filter_init = 0; /* getpixel() filter tables */
+  job->tmp.warned = 0;
 
   /* init cfg */
   job->cfg.cs = 0;
@@ -42,6 +47,11 @@ void job_init(job_t *job) {
   job->cfg.cfilter = (char*)NULL;
   job->cfg.certainty = 95;
   job->cfg.unrec_marker = "_";
+  job->cfg.threads = 1;
+  job->cfg.local = 0;
+  job->cfg.local_w = 0;
+  job->cfg.local_k = 0;
+  job->cfg.norm = 0;  /* off, --norm=24 for 300..600 dpi pages */
 }
 
 /* initialize job structure for every image (multi-images) */
@@ -49,6 +59,14 @@ void job_init_image(job_t *job) {
 
   /* FIXME jb: init pix */  
   job->src.p.p = NULL;
+  job->src.p.bits = NULL;
+  job->src.p.fbits = NULL;
+  job->src.p.sat = NULL;
+  job->src.p.marks = NULL;
+  job->src.p.job = job; /* getpixel() and boxes find their job by it */
+  job->src.band = 0;    /* set by band_ocr1() */
+  job->src.y0 = 0;
+  job->src.line0 = 0;
 
   /* init results */
   list_init( &job->res.boxlist );
@@ -58,17 +76,25 @@ void job_init_image(job_t *job) {
   job->res.sumX = 0;
   job->res.sumY = 0;
   job->res.numC = 0;
-  job->res.lines.dx=0; /* JS1904 */ 
-  job->res.lines.dy=0; 
-  job->res.lines.num=0;
+  tlines_init( &job->res.lines ); /* num=dx=dy=0, line 0 is set to 0 */
   job->cfg.spc = 0;  /* JS1904 set by pgm2asc.c, which is bad, ToDo  */
   
   /* init temporaries */
   job->tmp.n_run = 0;
+  box_pool_init( &job->tmp.boxpool );
+  box_grid_init( &job->tmp.boxgrid );
   /* FIXME jb: init ppo */
   job->tmp.ppo.p = NULL; 
   job->tmp.ppo.x = 0;
   job->tmp.ppo.y = 0;
+  job->tmp.ppo.job = job;
+  job->tmp.ppo.bits = NULL;
+  job->tmp.ppo.fbits = NULL;
+  job->tmp.ppo.sat = NULL;
+  job->tmp.ppo.marks = NULL;
+  job->tmp.pool = NULL; /* created by pgm2asc() if cfg.threads>1 */
+  job->tmp.norm.p = NULL; /* set by norm_reduce() */
+  job->tmp.norm_f = 1;
 
 }
 
@@ -84,12 +110,23 @@ void job_free_image(job_t *job) {
    */
   list_free( &job->res.linelist ); /* JS-2019-04 needed for multiimage */
  
-  list_and_data_free(&(job->res.boxlist), (void (*)(void *))free_box);
+  /* boxes from the pool are released together, v0.53 */
+  for_each_data(&(job->res.boxlist)) {
+    struct box *box2 = (struct box *)list_get_current(&(job->res.boxlist));
+    if (!box2->pool) free_box(box2);
+  } end_for_each(&(job->res.boxlist));
+  box_grid_free(&job->tmp.boxgrid);
+  list_free(&(job->res.boxlist));
+  box_pool_free(&job->tmp.boxpool);
+  tlines_free(&job->res.lines);
 
   /* FIXME jb: free pix */
   if (job->src.p.p) { free(job->src.p.p); job->src.p.p=NULL; }
+  pix_bits_free(&job->src.p);
+  pix_marks_free(&job->src.p);
 
   /* FIXME jb: free pix */
   if (job->tmp.ppo.p) { free(job->tmp.ppo.p); job->tmp.ppo.p=NULL; }
+  tpool_free(job->tmp.pool); job->tmp.pool=NULL;
 
 }
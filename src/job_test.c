@@ -0,0 +1,180 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2026  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ test for the reentrant engine, n jobs at once on n threads, each
+ thread has its own job_t and recognizes the images one after the
+ other (starting at a different image), the text of each job must be
+ the same as the text of a serial run of the same image
+ (not build by default)
+
+ usage: make job_test
+        ./job_test [-t threads] [-r repeat] img1.pnm [img2.png ...]
+
+ returns 0 if all texts are the same, 1 on errors or differences
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#include "pnm.h"
+#include "pgm2asc.h"
+#include "gocr.h"
+
+typedef struct img_s {
+  char *name;
+  pix p;       /* gray image, read once, copied for each job */
+  char *text;  /* text of the serial run */
+} img_t;
+
+typedef struct test_s {
+  img_t *img;
+  int ni, rep;
+} test_t;
+
+typedef struct worker_s {
+  test_t *t;
+  int id, runs, err;
+} worker_t;
+
+/* recognize a copy of img with a new job, returns the text (malloc)
+ *  or NULL on errors, the lines are separated by \n as by gocr */
+static char *recognize(img_t *img) {
+  job_t job1, *job = &job1; /* one job per call, as libgocr */
+  const char *line;
+  char *text, *t;
+  size_t n = 0, len;
+  int i;
+
+  job_init(job);
+  job_init_image(job);
+  job->src.fname = img->name;
+  /* the engine changes the image (thresholding), we need a private copy */
+  job->src.p.p = (unsigned char *)malloc((size_t)img->p.x * img->p.y);
+  if (!job->src.p.p) { job_free_image(job); return NULL; }
+  memcpy(job->src.p.p, img->p.p, (size_t)img->p.x * img->p.y);
+  job->src.p.x = img->p.x;
+  job->src.p.y = img->p.y;
+  job->src.p.bpp = 1;
+  pgm2asc(job);
+
+  for (i = 0; (line = getTextLine(&(job->res.linelist), i)); i++)
+    n += strlen(line) + 1;
+  text = (char *)malloc(n + 1);
+  if (text) {
+    for (t = text, i = 0; (line = getTextLine(&(job->res.linelist), i)); i++) {
+      len = strlen(line);
+      memcpy(t, line, len); t += len; *t++ = '\n';
+    }
+    *t = 0;
+  }
+  free_textlines(&(job->res.linelist));
+  job_free_image(job);
+  free_db(job);
+  return text;
+}
+
+/* worker id starts at image id, so different images run at once */
+static void *worker(void *arg) {
+  worker_t *w = (worker_t *)arg;
+  test_t *t = w->t;
+  char *text;
+  int i, r;
+
+  for (r = 0; r < t->rep; r++)
+    for (i = 0; i < t->ni; i++) {
+      img_t *img = t->img + (w->id + i) % t->ni;
+      text = recognize(img);
+      w->runs++;
+      if (!text || strcmp(text, img->text)) {
+        w->err++;
+        fprintf(stderr, "# job %d %s: %s\n", w->id, img->name,
+                (text) ? "text DIFFERS" : "ERROR");
+      }
+      free(text);
+    }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  test_t t;
+  worker_t *w;
+  int nt = 4, i, err = 0, runs = 0;
+#ifdef HAVE_PTHREAD_H
+  pthread_t *th;
+#endif
+
+  memset(&t, 0, sizeof(t));
+  t.rep = 2;
+  for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+    if (!strcmp(argv[i], "-t")) nt = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-r")) t.rep = atoi(argv[i + 1]);
+    else break;
+  }
+  if (i >= argc || argv[i][0] == '-') {
+    fprintf(stderr, "usage: %s [-t threads] [-r repeat] img1.pnm [img2 ...]\n",
+            argv[0]);
+    return 1;
+  }
+  if (nt < 1) nt = 1;
+  if (t.rep < 1) t.rep = 1;
+  t.ni = argc - i;
+  t.img = (img_t *)calloc(t.ni, sizeof(img_t));
+  w = (worker_t *)calloc(nt, sizeof(worker_t));
+  if (!t.img || !w) { fprintf(stderr, "ERROR no memory\n"); return 1; }
+
+  /* serial runs, the reference texts */
+  for (i = 0; i < t.ni; i++) {
+    t.img[i].name = argv[argc - t.ni + i];
+    if (readpgm(t.img[i].name, &t.img[i].p, 0) < 0 || !t.img[i].p.p) {
+      fprintf(stderr, "ERROR %s\n", t.img[i].name); return 1;
+    }
+    t.img[i].text = recognize(t.img + i);
+    if (!t.img[i].text) { fprintf(stderr, "ERROR %s\n", t.img[i].name); return 1; }
+    printf("# %s %dx%d, %d bytes of text\n", t.img[i].name,
+           t.img[i].p.x, t.img[i].p.y, (int)strlen(t.img[i].text));
+  }
+
+  for (i = 0; i < nt; i++) { w[i].t = &t; w[i].id = i; }
+#ifdef HAVE_PTHREAD_H
+  th = (pthread_t *)calloc(nt, sizeof(pthread_t));
+  if (!th) { fprintf(stderr, "ERROR no memory\n"); return 1; }
+  for (i = 0; i < nt; i++)
+    if (pthread_create(th + i, NULL, worker, w + i)) {
+      fprintf(stderr, "ERROR pthread_create\n"); return 1;
+    }
+  for (i = 0; i < nt; i++) pthread_join(th[i], NULL);
+  free(th);
+#else
+  fprintf(stderr, "# no pthread.h, jobs one after the other\n");
+  for (i = 0; i < nt; i++) worker(w + i);
+#endif
+
+  for (i = 0; i < nt; i++) { runs += w[i].runs; err += w[i].err; }
+  printf("# %d jobs on %d threads, %d images: %s\n", runs, nt, t.ni,
+         (err) ? "DIFFERS" : "same");
+  for (i = 0; i < t.ni; i++) { free(t.img[i].p.p); free(t.img[i].text); }
+  free(t.img);
+  free(w);
+  return (err) ? 1 : 0;
+}
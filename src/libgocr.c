@@ -0,0 +1,148 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2010  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ in-memory interface, see libgocr.h, v0.53
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pgm2asc.h"
+#include "gocr.h"
+#include "libgocr.h"
+
+void gocr_opts_init(gocr_opts *opts) {
+  job_t job;
+  job_init(&job);  /* take the defaults from one place */
+  opts->cs           = job.cfg.cs;
+  opts->spc          = job.cfg.spc;
+  opts->mode         = job.cfg.mode;
+  opts->dust_size    = job.cfg.dust_size;
+  opts->only_numbers = job.cfg.only_numbers;
+  opts->certainty    = job.cfg.certainty;
+  opts->verbose      = job.cfg.verbose;
+  opts->out_format   = job.cfg.out_format;
+  opts->db_path      = job.cfg.db_path;
+  opts->cfilter      = job.cfg.cfilter;
+  opts->unrec_marker = job.cfg.unrec_marker;
+}
+
+void gocr_result_free(gocr_result *res) {
+  int i;
+  if (!res) return;
+  for (i = 0; i < res->num_lines; i++) free(res->lines[i]);
+  for (i = 0; i < res->num_boxes; i++) free((char *)res->boxes[i].s);
+  free(res->lines);
+  free(res->boxes);
+  memset(res, 0, sizeof(*res));
+}
+
+/* copy the text lines and boxes of job to res, return 0 or GOCR_ENOMEM */
+static int copy_result(job_t *job, gocr_result *res) {
+  const char *line;
+  struct box *box2;
+  gocr_box *b;
+  int n, rc = GOCR_OK;
+
+  for (n = 0; getTextLine(&job->res.linelist, n); n++);
+  if (n) {
+    res->lines = (char **)calloc(n, sizeof(char *));
+    if (!res->lines) return GOCR_ENOMEM;
+  }
+  for (n = 0; (line = getTextLine(&job->res.linelist, n)) != NULL; n++) {
+    res->lines[n] = (char *)malloc(strlen(line) + 1);
+    if (!res->lines[n]) return GOCR_ENOMEM;
+    strcpy(res->lines[n], line);
+    res->num_lines = n + 1;
+  }
+
+  n = job->res.boxlist.n;
+  if (n) {
+    res->boxes = (gocr_box *)calloc(n, sizeof(gocr_box));
+    if (!res->boxes) return GOCR_ENOMEM;
+  }
+  for_each_data(&job->res.boxlist) {
+    box2 = (struct box *)list_get_current(&job->res.boxlist);
+    b = &res->boxes[res->num_boxes];
+    b->x0 = box2->x0;  b->x1 = box2->x1;
+    b->y0 = box2->y0;  b->y1 = box2->y1;
+    b->line = box2->line;
+    b->c = box2->c;
+    b->certainty = (box2->num_ac) ? box2->wac[0] : 0;
+    b->s = NULL;
+    if (box2->num_ac && box2->tas[0]) {
+      char *s = (char *)malloc(strlen(box2->tas[0]) + 1);
+      if (!s) { rc = GOCR_ENOMEM; break; } /* no return in for_each */
+      strcpy(s, box2->tas[0]);
+      b->s = s;
+    }
+    res->num_boxes++;
+  } end_for_each(&job->res.boxlist);
+  return rc;
+}
+
+int gocr_recognize(const unsigned char *gray, int w, int h, int stride,
+                   const gocr_opts *opts, gocr_result *res) {
+  job_t job1, *job = &job1; /* one job per call, no shared state */
+  int y, rc = GOCR_OK;
+
+  if (res) memset(res, 0, sizeof(*res));
+  if (!gray || !res || w <= 0 || h <= 0 || stride < w
+      || (size_t)w * (size_t)h / (size_t)h != (size_t)w)
+    return GOCR_EINVAL;
+
+  job_init(job);
+  job->src.fname = "(memory)";
+  if (opts) {
+    job->cfg.cs           = opts->cs;
+    job->cfg.spc          = opts->spc;
+    job->cfg.mode         = opts->mode & ~128; /* no stdin/stdout dialog */
+    job->cfg.dust_size    = opts->dust_size;
+    job->cfg.only_numbers = opts->only_numbers;
+    job->cfg.certainty    = opts->certainty;
+    job->cfg.verbose      = opts->verbose & ~32; /* no debug image files */
+    job->cfg.out_format   = (FORMAT)opts->out_format;
+    job->cfg.db_path      = (char *)opts->db_path;
+    job->cfg.cfilter      = (char *)opts->cfilter;
+    job->cfg.unrec_marker = (opts->unrec_marker) ?
+                            (char *)opts->unrec_marker : "_";
+  }
+  if (job->cfg.mode & 2)
+    if (load_db(job) < 0) { free_db(job); return GOCR_EDB; }
+
+  job_init_image(job);
+  /* the engine changes the image (thresholding), we need a private copy */
+  job->src.p.p = (unsigned char *)malloc((size_t)w * h);
+  if (!job->src.p.p) rc = GOCR_ENOMEM;
+  else {
+    for (y = 0; y < h; y++)
+      memcpy(job->src.p.p + (size_t)w * y, gray + (size_t)stride * y, w);
+    job->src.p.x = w;
+    job->src.p.y = h;
+    job->src.p.bpp = 1;
+    pgm2asc(job);
+    rc = copy_result(job, res);
+  }
+
+  free_textlines(&job->res.linelist);
+  job_free_image(job);
+  free_db(job);
+  if (rc != GOCR_OK) gocr_result_free(res);
+  return rc;
+}
@@ -0,0 +1,89 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2010  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for EMAIL-address
+
+ in-memory interface to the engine (make libs), v0.53
+   no file i/o (except the optional database), no stdout, no exit(),
+   every call uses its own job, so calls from several threads are ok
+
+   gocr_opts opts;  gocr_result res;
+   gocr_opts_init(&opts);
+   if (gocr_recognize(gray, w, h, stride, &opts, &res)==GOCR_OK) {
+     for (i=0; i<res.num_lines; i++) puts(res.lines[i]);
+     gocr_result_free(&res);
+   }
+ */
+
+#ifndef GOCR_LIBGOCR_H
+#define GOCR_LIBGOCR_H
+
+#include <wchar.h>
+
+/* return codes of gocr_recognize() */
+#define GOCR_OK       0
+#define GOCR_EINVAL  -1  /* bad arguments (NULL pointer, w,h,stride) */
+#define GOCR_ENOMEM  -2  /* out of memory */
+#define GOCR_EDB     -3  /* database (mode&2) could not be read */
+
+/* options, same meaning as the command line options (see gocr --help) */
+typedef struct gocr_opts_s {
+  int cs;           /* -l grey level 0..255, pixel<cs is black, 0=auto */
+  int spc;          /* -s spacewidth/dots, 0=auto */
+  int mode;         /* -m operation modes, 128 (interactive) is ignored */
+  int dust_size;    /* -d dust size, -1=auto */
+  int only_numbers; /* -n numbers only */
+  int certainty;    /* -a certainty limit in percent, default 95 */
+  int verbose;      /* -v debug output to stderr, 0=quiet (default) */
+  int out_format;   /* -f FORMAT of unicode.h, default UTF8 */
+  const char *db_path;      /* -p database path, used if mode&2 */
+  const char *cfilter;      /* -C char filter, ex: "A-Za-z", NULL=all */
+  const char *unrec_marker; /* -u output for unrecognized chars, "_" */
+} gocr_opts;
+
+/* one recognized object (char, space, picture) of the image */
+typedef struct gocr_box_s {
+  int x0, y0, x1, y1; /* frame, image coordinates, inclusive */
+  int line;           /* text line number, 0 = outside of text lines */
+  wchar_t c;          /* best char, UNKNOWN if not recognized */
+  int certainty;      /* weight of c in percent */
+  const char *s;      /* UTF8-string if c==0 (database strings), or NULL */
+} gocr_box;
+
+/* the result is allocated by gocr_recognize() and owned by the caller,
+ * release it by gocr_result_free() */
+typedef struct gocr_result_s {
+  int num_lines;
+  char **lines;       /* text lines in out_format, without '\n' */
+  int num_boxes;
+  gocr_box *boxes;    /* in the order of the internal box list */
+} gocr_result;
+
+/* set opts to the defaults of the command line program */
+void gocr_opts_init(gocr_opts *opts);
+
+/* recognize a 8bit gray image (0=black, 255=white) of w x h pixels,
+ *  rows are stride bytes apart, opts==NULL means defaults,
+ *  returns GOCR_OK or a negative error code, res is cleared on error */
+int gocr_recognize(const unsigned char *gray, int w, int h, int stride,
+                   const gocr_opts *opts, gocr_result *res);
+
+/* free the result arrays, res can be reused afterwards */
+void gocr_result_free(gocr_result *res);
+
+#endif
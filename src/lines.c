@@ -54,6 +54,80 @@ void free_textlines(List *linelist) {  // list.h
   list_free(linelist); // free list structure
 }
 
+/* struct tlines has growing arrays since v0.53 (was MAXlines=1024),
+ *  tlines_init() allocates line 0, which is the place holder for
+ *  boxes outside of text lines (pictures etc.) */
+void tlines_init(struct tlines *lines) {
+  memset(lines, 0, sizeof(*lines));
+  tlines_grow(lines, 1);
+}
+
+/* make room for n lines, new entries are set to 0, return 0 on success */
+int tlines_grow(struct tlines *lines, int n) {
+  int **arrays[9], *a, i, max;
+  struct tline_boxes *boxes;
+
+  if (n <= lines->max) return 0;
+  max = 2 * lines->max;
+  if (max < n) max = n + TLinesStep;
+  arrays[0] = &lines->m1; arrays[1] = &lines->m2;
+  arrays[2] = &lines->m3; arrays[3] = &lines->m4;
+  arrays[4] = &lines->x0; arrays[5] = &lines->x1;
+  arrays[6] = &lines->wt; arrays[7] = &lines->pitch;
+  arrays[8] = &lines->mono;
+  for (i = 0; i < 9; i++) {
+    a = (int *)realloc(*arrays[i], max * sizeof(int));
+    if (!a) { fprintf(stderr,"realloc failed, lines= %d\n", max); return 1; }
+    memset(a + lines->max, 0, (max - lines->max) * sizeof(int));
+    *arrays[i] = a;
+  }
+  boxes = (struct tline_boxes *)
+    realloc(lines->boxes, max * sizeof(struct tline_boxes));
+  if (!boxes) { fprintf(stderr,"realloc failed, lines= %d\n", max); return 1; }
+  memset(boxes + lines->max, 0, (max - lines->max) * sizeof(struct tline_boxes));
+  lines->boxes = boxes;
+  lines->max = max;
+  return 0;
+}
+
+void tlines_free(struct tlines *lines) {
+  int i;
+  for (i = 0; i < lines->max; i++)
+    if (lines->boxes[i].box) free(lines->boxes[i].box);
+  free(lines->boxes);
+  free(lines->m1); free(lines->m2); free(lines->m3); free(lines->m4);
+  free(lines->x0); free(lines->x1);
+  free(lines->wt); free(lines->pitch); free(lines->mono);
+  memset(lines, 0, sizeof(*lines));
+}
+
+/* collect the boxes of every line (box->line) in the order of the boxlist,
+ *  the arrays are valid until boxes are added to or removed from the list
+ *  or box->line is changed, so call it again before using them */
+int tlines_set_boxes(job_t *job) {
+  struct tlines *lines = &job->res.lines;
+  struct tline_boxes *lb;
+  struct box *box2, **bp;
+  int i, err = 0;
+
+  for (i = 0; i < lines->num; i++) lines->boxes[i].num = 0;
+  for_each_data(&(job->res.boxlist)) {
+    box2 = (struct box *)list_get_current(&(job->res.boxlist));
+    if (box2->line < 0 || box2->line >= lines->num) continue; /* not set */
+    lb = &lines->boxes[box2->line];
+    if (lb->num >= lb->max) {
+      i = (lb->max) ? 2 * lb->max : 16;
+      bp = (struct box **)realloc(lb->box, i * sizeof(struct box *));
+      if (!bp) { err = 1; continue; }
+      lb->box = bp;
+      lb->max = i;
+    }
+    lb->box[lb->num++] = box2;
+  } end_for_each(&(job->res.boxlist));
+  if (err) fprintf(stderr,"realloc failed!\n");
+  return err;
+}
+
 /* append a string (s1) to the string buffer (buffer) of length (len)
  * if buffer is to small or len==0 realloc buffer, len+=512
  */
@@ -79,12 +153,16 @@ char *append_to_line(char *buffer, const char *s1, int *len) {
 }
 
 int calc_median_gap(struct tlines * lines) {
-  int gaps[MAXlines], l;
+  int *gaps, l, gap;
   if (lines->num<2) return 0;
+  gaps = (int *)malloc((lines->num - 1) * sizeof(gaps[0]));
+  if (!gaps) { fprintf(stderr,"malloc failed!\n"); return 0; }
   for (l = 0; l < lines->num - 1; l++)
     gaps[l] = lines->m2[l + 1] - lines->m3[l];
   qsort(gaps, lines->num - 1, sizeof(gaps[0]), intcompare);
-  return gaps[(lines->num - 1) / 2];
+  gap = gaps[(lines->num - 1) / 2];
+  free(gaps);
+  return gap;
 }
 
 /*
@@ -147,12 +225,13 @@ int get_least_line_indent(List * boxlist, int dx, int dy, int verbose) {
  */
 void store_boxtree_lines(job_t *job, int mo) {
   char *buffer;	/* temp buffer for text */
+  char dbuf[DECODE_BUFLEN]; /* for decode_r() */
   int i = 0, j = 0;
   int len = 1024;   // initial buffer length for text line
   struct box *box2;
   int median_gap = 0;
   int max_single_space_gap = 0;
-  struct tlines line_info;
+  struct tlines *line_info = &job->res.lines;
   int line, line_gap, oldline=-1;
   int left_margin;
   int i1=0, i2=0;
@@ -189,7 +268,7 @@ void store_boxtree_lines(job_t *job, int mo) {
           job->res.lines.dx, 
           job->res.lines.dy, job->cfg.verbose);
 
-  if (job->cfg.out_format==XML) { /* subject of change */
+  if (job->cfg.out_format==XML && !job->src.band) { /* subject of change */
     char s1[255]; /* ToDo: avoid potential buffer overflow !!! */
     /* output lot of usefull information for XML filter */
     sprintf(s1,"<page x=\"%d\" y=\"%d\" dx=\"%d\" dy=\"%d\">\n",
@@ -203,7 +282,6 @@ void store_boxtree_lines(job_t *job, int mo) {
   for_each_data(&(job->res.boxlist)) {
     box2 = (struct box *)list_get_current(&(job->res.boxlist));
     line = box2->line;
-    line_info = job->res.lines;
     /* reset the output char if certainty is below the limit v0.44 */
     if (box2->num_ac && box2->wac[0]<job->cfg.certainty) box2->c=UNKNOWN;
     if (line!=oldline) {
@@ -217,9 +295,10 @@ void store_boxtree_lines(job_t *job, int mo) {
         char s1[255]; /* ToDo: avoid potential buffer overflow !!! */
         /* output lot of usefull information for XML filter */
         sprintf(s1,"<line x=\"%d\" y=\"%d\" dx=\"%d\" dy=\"%d\" value=\"%d\">\n",
-           line_info.x0[line],line_info.m1[line],
-           line_info.x1[line]-line_info.x0[line]+1,
-           line_info.m4[line]-line_info.m1[line],line);
+           line_info->x0[line],line_info->m1[line],
+           line_info->x1[line]-line_info->x0[line]+1,
+           line_info->m4[line]-line_info->m1[line],
+           (line) ? line + job->src.line0 : 0); /* --band: of the page */
         buffer=append_to_line(buffer,s1,&len);
       }
       oldline=line;
@@ -228,10 +307,9 @@ void store_boxtree_lines(job_t *job, int mo) {
         box2->c <= 'z') i1++; /* count non-space chars */
     if (box2->c == '\n') {
       if (job->cfg.out_format!=XML) { /* subject of change */
-        line_info = job->res.lines;
         line = box2->line;
         if (line > 0) {
-          line_gap = line_info.m2[line] - line_info.m3[line - 1];
+          line_gap = line_info->m2[line] - line_info->m3[line - 1];
           for (line_gap -= max_single_space_gap; line_gap > 0; 
                line_gap -= median_gap) {
             buffer=append_to_line(buffer,"\n",&len);
@@ -292,7 +370,7 @@ void store_boxtree_lines(job_t *job, int mo) {
       }
       if (box2->c != UNKNOWN  &&  box2->c != 0) {
         buffer=
-          append_to_line(buffer,decode(box2->c,job->cfg.out_format),&len);
+          append_to_line(buffer,decode_r(box2->c,job->cfg.out_format,dbuf),&len);
         if (box2->c >  ' ' &&
             box2->c <= 'z') i2++; /* count non-space chars */
       } else { /* c == UNKNOWN or 0 */
@@ -330,7 +408,7 @@ void store_boxtree_lines(job_t *job, int mo) {
               buffer=append_to_line(buffer,box2->tas[i1],&len);
             else
               buffer=append_to_line(buffer,
-                 decode(box2->tac[i1],job->cfg.out_format),&len);
+                 decode_r(box2->tac[i1],job->cfg.out_format,dbuf),&len);
             // ToDo: add tas[] (achars->avalues or alternate_strings?
             if (i1+1<box2->num_ac) buffer=append_to_line(buffer,",",&len);
           }
@@ -352,7 +430,7 @@ void store_boxtree_lines(job_t *job, int mo) {
   if (job->cfg.out_format==XML && oldline>-1) { /* subject of change */
     buffer=append_to_line(buffer,"</line>\n",&len);
   } 
-  if (job->cfg.out_format==XML) { /* subject of change */
+  if (job->cfg.out_format==XML && !job->src.band) { /* subject of change */
     buffer=append_to_line(buffer,"</block>\n</page>\n",&len);
   } 
 
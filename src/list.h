@@ -40,12 +40,22 @@ struct ocr_element {
 };
 typedef struct ocr_element Element;
 
+/* iterator of for_each_data, lives on the stack of the loop (v0.53) */
+struct ocr_list_iter {
+   Element *cur;		/* current element of this loop level */
+   struct ocr_list_iter *up;	/* iterator of the enclosing loop or NULL */
+};
+typedef struct ocr_list_iter ListIter;
+
 struct ocr_object_list {
    Element start;               /* simplifies for(each_element) { ... */
    Element stop;                /*   ... list_del() ... }  v0.41      */
-   Element **current;	 	/* for(each_element) */
+   ListIter *current;	 	/* for(each_element), innermost loop */
    int n;			/* number of elements */
    int level;			/* level of nested fors */
+   Element **hash;		/* data -> element, build on first lookup */
+   int hsize;			/* size of hash[] (power of 2) or 0 */
+   int hdup;			/* same data twice, use linear search */
 };
 typedef struct ocr_object_list List;
 
@@ -58,10 +68,11 @@ int	list_app		( List *l, void *data );
 int	list_ins		( List *l, void *data_after, void *data);
 Element*list_element_from_data	( List *l, void *data );
 int	list_del		( List *l, void *data );
+Element*list_app_element	( List *l, void *data );
+Element*list_ins_element	( List *l, Element *e_after, void *data);
+int	list_del_element	( List *l, Element *e );
 void	list_free		( List *l );
 int	list_and_data_free	( List *l, void (*free_data)(void *data));
-int	list_higher_level	( List *l );
-void	list_lower_level	( List *l );
 void *	list_next		( List *l, void *data );
 void *	list_prev		( List *l, void *data );
 void	list_sort		( List *l, int (*compare)(const void *, const void *) );
@@ -69,23 +80,33 @@ void	list_sort		( List *l, int (*compare)(const void *, const void *) );
 #define list_empty(l)			((l)->start.next == &(l)->stop ? 1 : 0)
 #define list_get_header(l)		((l)->start.next->data)
 #define list_get_tail(l)		((l)->stop.previous->data)
-#define list_get_current(l)		((l)->current[(l)->level]->data)
-#define list_get_cur_prev(l)		((l)->current[(l)->level]->previous == NULL ? \
-			NULL : (l)->current[(l)->level]->previous->data )
-#define list_get_cur_next(l)		((l)->current[(l)->level]->next == NULL ? \
-			NULL : (l)->current[(l)->level]->next->data )
+#define list_get_current(l)		((l)->current->cur->data)
+#define list_get_cur_prev(l)		((l)->current->cur->previous == NULL ? \
+			NULL : (l)->current->cur->previous->data )
+#define list_get_cur_next(l)		((l)->current->cur->next == NULL ? \
+			NULL : (l)->current->cur->next->data )
 #define list_total(l)			((l)->n)
+/* element handles, O(1), return NULL at start or end of the list */
+#define list_get_cur_element(l)		((l)->current->cur)
+#define list_element_next_data(e)	((e)->next == NULL ? \
+			NULL : (e)->next->data )
+#define list_element_prev_data(e)	((e)->previous == NULL ? \
+			NULL : (e)->previous->data )
 
+/* the iterator is a local variable of the loop block, so nested loops
+ * do not need any heap memory; list_del() walks the iterator chain to
+ * fix the loops whose current element is deleted.
+ * do not leave the loop by return or goto, only break is allowed */
 #define for_each_data(l)		\
- if (list_higher_level(l) == 0) { \
-   for ( ; (l)->current[(l)->level] \
-        && (l)->current[(l)->level]!=&(l)->stop; (l)->current[(l)->level] = \
-	(l)->current[(l)->level]->next ) {
+ { ListIter list_it_; \
+   list_it_.up = (l)->current; (l)->current = &list_it_; (l)->level++; \
+   for ( list_it_.cur = (l)->start.next; list_it_.cur \
+        && list_it_.cur != &(l)->stop; list_it_.cur = list_it_.cur->next ) {
 
 
 #define end_for_each(l)			\
    } \
- list_lower_level(l); \
+ (l)->current = list_it_.up; (l)->level--; \
  }
 
 #endif
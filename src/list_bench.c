@@ -0,0 +1,154 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2026  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ benchmark for list_sort(), compares the merge sort against the old
+ bubble sort on real box lists (not build by default)
+
+ usage: make list_bench
+        gocr -f XML page.pnm | ./list_bench [repeat]
+
+ box positions and line numbers are taken from the XML output,
+ the boxes are brought into scan order (top down as scan_boxes finds
+ them) and sorted by line and x0 like pgm2asc() does with sort_box_func
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "list.h"
+
+struct bbox { int x0, y0, line, id; };
+
+/* same order as sort_box_func() in pgm2asc.c */
+static int sort_bbox_func(const void *a, const void *b) {
+  const struct bbox *boxa = (const struct bbox *)a,
+                    *boxb = (const struct bbox *)b;
+  if ( boxb->line < boxa->line ) return 1;
+  if ( boxb->line > boxa->line ) return -1;
+  if ( boxb->x0   < boxa->x0   ) return 1;
+  return -1;
+}
+
+/* scan order, top down, left to right */
+static int scan_order_func(const void *a, const void *b) {
+  const struct bbox *boxa = (const struct bbox *)a,
+                    *boxb = (const struct bbox *)b;
+  if (boxa->y0 != boxb->y0) return boxa->y0 - boxb->y0;
+  return boxa->x0 - boxb->x0;
+}
+
+/* old bubble sort from list.c (until v0.53), kept here for comparison */
+static void list_sort_bubble( List *l,
+                              int (*compare)(const void *, const void *) ) {
+  Element *temp, *prev;
+  int i, sorted;
+
+  for (i = 0; i < l->n; i++ ) {
+    sorted = 1; /* Flag for early break */
+    for ( temp = l->start.next->next;
+          temp != NULL && temp != &l->stop; temp = temp->next ) {
+      if ( temp->previous == &l->start ) continue;
+      if ( compare((const void *)temp->previous->data,
+                   (const void *)temp->data) > 0 ) {
+        sorted = 0;
+	prev = temp->previous;
+  	prev->previous->next = temp;
+        temp->next->previous = prev;
+	temp->previous = prev->previous;
+	prev->next     = temp->next;
+	prev->previous = temp;
+	temp->next     = prev;
+	temp = prev;
+      }
+    }
+    if (sorted) break;
+  }
+}
+
+static void fill_list(List *l, struct bbox *b, int n) {
+  int i;
+  list_init(l);
+  for (i = 0; i < n; i++) list_app(l, b + i);
+}
+
+int main(int argc, char *argv[]) {
+  char s1[1024], *p;
+  struct bbox *b = NULL;
+  int n = 0, nmax = 0, line = 0, i, rep = 1, err = 0;
+  List l1, l2;
+  Element *e1, *e2;
+  clock_t t0, t1, t2;
+
+  if (argc > 1) rep = atoi(argv[1]);
+  if (rep < 1) rep = 1;
+
+  while (fgets(s1, sizeof(s1), stdin)) {
+    if (strstr(s1, "<line ")) { line++; continue; }
+    if (!(p = strstr(s1, "<box "))) continue;
+    if (n >= nmax) {
+      nmax = 2 * nmax + 1024;
+      b = (struct bbox *)realloc(b, nmax * sizeof(struct bbox));
+      if (!b) { fprintf(stderr, "realloc error\n"); return 1; }
+    }
+    if (sscanf(p, "<box x=\"%d\" y=\"%d\"", &b[n].x0, &b[n].y0) != 2)
+      continue;
+    b[n].line = line;
+    b[n].id = n;
+    n++;
+  }
+  if (!n) {
+    fprintf(stderr, "no boxes found, usage: gocr -f XML x.pnm | %s\n",
+            argv[0]);
+    return 1;
+  }
+  qsort(b, n, sizeof(struct bbox), scan_order_func);
+
+  t0 = clock();
+  for (i = 0; i < rep; i++) {
+    fill_list(&l1, b, n);
+    list_sort_bubble(&l1, sort_bbox_func);
+    if (i + 1 < rep) list_free(&l1);
+  }
+  t1 = clock();
+  for (i = 0; i < rep; i++) {
+    fill_list(&l2, b, n);
+    list_sort(&l2, sort_bbox_func);
+    if (i + 1 < rep) list_free(&l2);
+  }
+  t2 = clock();
+
+  /* both sorts must give the same order */
+  for (e1 = l1.start.next, e2 = l2.start.next;
+       e1 != &l1.stop && e2 != &l2.stop; e1 = e1->next, e2 = e2->next)
+    if (e1->data != e2->data) err++;
+  if (e1 != &l1.stop || e2 != &l2.stop) err++;
+  for (e2 = l2.stop.previous; e2 != &l2.start; e2 = e2->previous)
+    if (e2->previous->next != e2) err++;
+
+  printf("# list_sort boxes= %d lines= %d repeat= %d\n", n, line, rep);
+  printf("# bubble sort %8.3f s\n", (double)(t1 - t0) / CLOCKS_PER_SEC);
+  printf("# merge  sort %8.3f s\n", (double)(t2 - t1) / CLOCKS_PER_SEC);
+  printf("# order %s\n", (err) ? "DIFFERS" : "identical");
+  list_free(&l1);
+  list_free(&l2);
+  free(b);
+  return (err) ? 1 : 0;
+}
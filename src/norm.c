@@ -0,0 +1,173 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2019  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ resolution normalisation (gocr --norm[=h]), v0.53
+   high resolution pages (600 dpi) give big boxes, long frame vectors
+   and slow distance() compares, but glyphs of 20..30 pixels are
+   recognized as well, so after thresholding the typical glyph height
+   is estimated from the 4x4 blocks of the bit planes (pix_pyr_height)
+   and the page is reduced by an integer factor f to glyphs of at least
+   h pixels (default 24), if f>=2
+   the pipeline runs on the reduced image, before the output the boxes
+   and lines are mapped back and the original image is restored, so the
+   coordinates (-f XML, libgocr) are those of the input file, the rows
+   of a band (--band) are moved to the rows of the page here too
+   off by default (cfg.norm=0), spaces and line gaps are decided on the
+   reduced image and may differ from the output of the full image
+
+   pdftoppm -r 600 -gray x.pdf | gocr --norm -f XML -
+
+ not used with the database (-m 2) or the dialog (-m 128), the glyphs
+ would be compared and learned at the reduced size
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pnm.h"
+#include "pgm2asc.h"
+#include "gocr.h"
+
+#define NORM_SAMPLE 4096  /* components used for the glyph height */
+
+typedef struct norm_arg_s {
+  pix *src, *dst;
+  int f, cs;
+} norm_arg_t;
+
+/* rows i0..i1-1 of the reduced image (tpool_for), binary aware: a block
+ *  of f x f pixels with at least 1/3 black pixels gets the mean gray of
+ *  its black pixels, else of its white pixels, so strokes of f/3 pixels
+ *  survive, gaps of more than 2f/3 pixels too, and cs is still valid */
+static void norm_rows(void *arg, int i0, int i1, int id) {
+  norm_arg_t *a = (norm_arg_t *)arg;
+  pix *s = a->src;
+  unsigned char *row, *d;
+  int x, y, xx, yy, nb, nw, sb, sw, v, f = a->f;
+
+  for (y = i0; y < i1; y++) {
+    d = a->dst->p + (size_t)y * a->dst->x;
+    for (x = 0; x < a->dst->x; x++) {
+      nb = nw = sb = sw = 0;
+      for (yy = y * f; yy < y * f + f && yy < s->y; yy++) {
+        row = s->p + (size_t)yy * s->x;
+        for (xx = x * f; xx < x * f + f && xx < s->x; xx++) {
+          v = row[xx];
+          if ((v & ~7) < a->cs) { nb++; sb += v; } else { nw++; sw += v; }
+        }
+      }
+      d[x] = (3 * nb >= nb + nw) ? sb / nb : sw / nw;
+    }
+  }
+}
+
+/* reduce the thresholded image pp if its glyphs are higher than
+ *  2*cfg.norm, pp->bits must exist, the original is kept in
+ *  job->tmp.norm until norm_restore(), returns the factor (1 = none) */
+int norm_reduce(job_t *job, pix *pp) {
+  norm_arg_t a;
+  pix dst;
+  int h;
+
+  if (job->cfg.norm <= 0 || !pp->bits || job->tmp.norm_f > 1) return 1;
+  if (job->cfg.mode & (2|128)) { /* database glyphs in original size */
+    if (job->cfg.verbose)
+      fprintf(stderr, "# norm: not used with the database (-m 2, 128)\n");
+    return 1;
+  }
+  h = pix_pyr_height(pp, 2, NORM_SAMPLE);
+  a.f = h / job->cfg.norm;
+  if (job->cfg.verbose)
+    fprintf(stderr, "# norm: glyph height= %d reduce= 1/%d\n",
+            h, (a.f < 2) ? 1 : a.f);
+  if (a.f < 2) return 1;
+
+  dst = *pp;
+  dst.x = (pp->x + a.f - 1) / a.f;
+  dst.y = (pp->y + a.f - 1) / a.f;
+  dst.p = (unsigned char *)malloc((size_t)dst.x * dst.y);
+  if (!dst.p) {
+    fprintf(stderr, "# no memory for the reduced image, using 1/1\n");
+    return 1;
+  }
+  a.src = pp; a.dst = &dst; a.cs = job->cfg.cs;
+  tpool_for(job->tmp.pool, dst.y, norm_rows, &a);
+
+  pix_bits_free(pp);  /* and sat, fbits of the original */
+  pix_marks_free(pp);
+  job->tmp.norm = *pp;
+  job->tmp.norm_f = a.f;
+  pp->p = dst.p; pp->x = dst.x; pp->y = dst.y;
+  if (job->tmp.ppo.p == job->tmp.norm.p) job->tmp.ppo = *pp;
+  if (pix_bits_init(pp, job->cfg.cs, job->tmp.pool))
+    fprintf(stderr, "# no memory for the packed plane, using bytes\n");
+  return a.f;
+}
+
+/* pixel a of the reduced image to the first (b=0) or last (b=1)
+ *  pixel of its block, rows are moved by the band offset too */
+#define NORM_UP(a, b) ((a) * f + (b) * (f - 1))
+#define NORM_UPY(a, b) (NORM_UP(a, b) + y0)
+
+/* map boxes and lines back to the original image and restore it,
+ *  the rows of a band (--band) are mapped to rows of the page */
+void norm_restore(job_t *job, pix *pp) {
+  struct tlines *lines = &job->res.lines;
+  struct box *box2;
+  int i, n, f = job->tmp.norm_f, y0 = job->src.y0;
+
+  if (f <= 1 && y0 == 0) return;
+  for_each_data(&(job->res.boxlist)) {
+    box2 = (struct box *)list_get_current(&(job->res.boxlist));
+    box2->x0 = NORM_UP(box2->x0, 0);  box2->x1 = NORM_UP(box2->x1, 1);
+    box2->y0 = NORM_UPY(box2->y0, 0); box2->y1 = NORM_UPY(box2->y1, 1);
+    box2->x  = NORM_UP(box2->x, 0);   box2->y  = NORM_UPY(box2->y, 0);
+    box2->m1 = NORM_UPY(box2->m1, 0); box2->m2 = NORM_UPY(box2->m2, 0);
+    box2->m3 = NORM_UPY(box2->m3, 1); box2->m4 = NORM_UPY(box2->m4, 1);
+    n = (box2->num_frames > 0)
+      ? box2->num_frame_vectors[box2->num_frames - 1] : 0;
+    for (i = 0; i < n; i++) {
+      box2->frame_vector[i][0] *= f;
+      box2->frame_vector[i][1] = box2->frame_vector[i][1] * f + y0;
+    }
+  } end_for_each(&(job->res.boxlist));
+  for (i = 0; i < lines->num; i++) {
+    lines->m1[i] = NORM_UPY(lines->m1[i], 0);
+    lines->m2[i] = NORM_UPY(lines->m2[i], 0);
+    lines->m3[i] = NORM_UPY(lines->m3[i], 1);
+    lines->m4[i] = NORM_UPY(lines->m4[i], 1);
+    lines->x0[i] = NORM_UP(lines->x0[i], 0);
+    lines->x1[i] = NORM_UP(lines->x1[i], 1);
+  }
+  job->src.y0 = 0; /* mapped */
+  if (f <= 1) return;
+  job->res.avX  *= f; job->res.avY  *= f;
+  job->res.sumX *= f; job->res.sumY *= f;
+
+  pix_bits_free(pp);
+  pix_marks_free(pp);
+  if (job->tmp.ppo.p == pp->p) job->tmp.ppo = job->tmp.norm;
+  free(pp->p);
+  pp->p = job->tmp.norm.p; pp->x = job->tmp.norm.x; pp->y = job->tmp.norm.y;
+  job->tmp.norm.p = NULL;
+  job->tmp.norm_f = 1;
+}
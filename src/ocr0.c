@@ -95,16 +95,17 @@ ToDo:
  */ 
 int line_deviation( struct box *box1, int j1, int j2 ) {
   int r1x, r1y, r2x, r2y, r3x, r3y, i, x, y, d, dist, maxdist=0, frame, l2;
-  r1x=box1->frame_vector[j1][0];
-  r1y=box1->frame_vector[j1][1];
-  r2x=box1->frame_vector[j2][0];
-  r2y=box1->frame_vector[j2][1];
   if (!box1->num_frames) return(-1);
-  if (j1<0 || j1>box1->num_frame_vectors[box1->num_frames-1] ||
-      j2<0 || j2>box1->num_frame_vectors[box1->num_frames-1]) {
+  // v0.53 vectors are allocated exactly, check range before access
+  if (j1<0 || j1>=box1->num_frame_vectors[box1->num_frames-1] ||
+      j2<0 || j2>=box1->num_frame_vectors[box1->num_frames-1]) {
       fprintf(stderr,"Error in "__FILE__" L%d: idx out of range",__LINE__);
       return(-1);
   }
+  r1x=box1->frame_vector[j1][0];
+  r1y=box1->frame_vector[j1][1];
+  r2x=box1->frame_vector[j2][0];
+  r2y=box1->frame_vector[j2][1];
    /* get the frame the endvector belongs to */
   for (i=0;i<box1->num_frames;i++)
      if (j2<box1->num_frame_vectors[i]) break;
@@ -236,6 +237,7 @@ int testumlaut(struct box *box1, int cs, int m, wchar_t *modifier){
         xl,xr,yu,yl;  // left, right, upper and lower border of dots
    wchar_t mod='\0';	/* (TeX-) modifier ~"'` for compose() */
    DBG( wchar_t c_ask='"'; )
+   DBG( char dbuf[DECODE_BUFLEN]; )
 
    if (box1->num_frames<1) return 0;
    if (box1->num_frames==2) {
@@ -458,7 +460,7 @@ int testumlaut(struct box *box1, int cs, int m, wchar_t *modifier){
      if (m) box1->dots=r; // set to 0 also possible after division
      if (m) box1->modifier=mod; /* should be resetted after compose ??? */
      MSG(fprintf(stderr,"testumlaut mod=%s dots=%d y0+%d m=%d nac=%d",
-       decode(mod,ASCII),r,box1->y0-y0,m,box1->num_ac);)
+       decode_r(mod,ASCII,dbuf),r,box1->y0-y0,m,box1->num_ac);)
    }
 //   printf(" modifier=%c",mod);
    if (modifier) *modifier=mod;	/* set modifier */
@@ -5960,7 +5962,7 @@ static wchar_t ocr0_brackets(ocr0_shared_t *sdata){
        ad=98;
        if (dx<8) ad=99*ad/100;
        if (dx<6) ad=96*ad/100;
-       if( 2*dx > OCR_JOB->res.avX && 4*dx>dy ) ad=98;
+       if( 2*dx > box1->p->job->res.avX && 4*dx>dy ) ad=98;
 // printf(" %d %d %d %d %d %d\n",i5,i1,i3,i2,i4,i6);
        if( i5==0     && i1<=dx/8+1 && i3<=dx/8+1 && i1+i3<=dx/8+1
         && i2>=dx/2  && i4>=3*dx/4 && i6>=3*dx/4 ) {
@@ -7588,7 +7590,7 @@ wchar_t ocr0(struct box *box1, pix *bp, int cs){
    }
 
    // --- test numbers 0..9 --- separated for faster compilation
-   if( OCR_JOB->cfg.only_numbers ) return ocr0n(&sdata);
+   if( box1->p->job->cfg.only_numbers ) return ocr0n(&sdata);
 
    // bc=ocr1(box1,bp,cs);
    if(bc!=UNKNOWN && box1->num_ac>0 && box1->wac[0]==100)
@@ -9,7 +9,7 @@ Copyright (C) 2000-2017 Joerg Schulenburg License: GPL2
 //#include "gocr.h"
 //#include "unicode_defs.h"
 
-#define IFV if(OCR_JOB->cfg.verbose&4)
+#define IFV if(box1->p->job->cfg.verbose&4)  /* needs box1 in scope */
 #define MM {IFV fprintf(stderr,"\nDBG %c L%04d (%d,%d): ",\
             (char)c_ask,__LINE__,box1->x0,box1->y0);}
 
@@ -53,88 +53,184 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
  */
 
+#include "config.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include "tpool.h"
+#include "otsu.h"
 
 #define Abs(x) ((x<0)?-(x):x)
 
-/*======================================================================*
- * global thresholding routine                                          *
- *   takes a 2D unsigned char array pointer, number of rows, and        *
- *   number of cols in the array. returns the value of the threshold    *
- * x0,y0,x0+dx,y0+dy are the edgepoints of the interesting region       *
- * vvv is the verbosity for debugging purpose                           * 
- *======================================================================*/
- /* JS 2019-04 changed 2nd+3th argument, new: 2nd=nx=cols, 3th=ny=rows */
-int
-otsu (unsigned char *image, int cols, int rows,
-      int x0, int y0, int dx, int dy, int vvv) {
-
-  unsigned char *np;    // pointer to position in the image we are working with
-  unsigned char op1, op2, op3, op4;   // predecessor of pixel *np (start value)
-  int maxc=0;           // maximum contrast (start value) 
-  int thresholdValue=1; // value we will threshold at
+/* statistics of otsu() and thresholding(), v0.53 */
+typedef struct otsu_stat_s {
   int ihist[256];       // image histogram
   int chist[256];       // contrast histogram
+  int maxc;             // maximum contrast
+  int gmin, gmax;       // min/max of the rows of the histograms
+  int tmin, tmax;       // min/max of all rows (all!=0), for thresholding
+} otsu_stat_t;
+
+/* rows of one thread (tpool_for), merged by otsu_stat() */
+typedef struct otsu_part_s {
+  int ihist[256];       // only without h2
+  int maxc, tmin, tmax;
+} otsu_part_t;
+
+typedef struct otsu_rows_s {
+  unsigned char *image;
+  int cols, x0, y0, dx, dy, k, all;
+  int *h2;              // 256*256 counters per part or NULL
+  otsu_part_t *part;
+} otsu_rows_t;
+
+/* rows i0..i1-1 of the region, part id */
+static void otsu_rows(void *arg, int i0, int i1, int id) {
+  otsu_rows_t *o = (otsu_rows_t *)arg;
+  otsu_part_t *r = &o->part[id];
+  unsigned char *np;    // pointer to position in the image we are working with
+  int op1, op2, op3, op4;   // predecessor of pixel *np (start value)
+  int *h2 = (o->h2) ? o->h2 + id*256*256 : NULL;
+  int i, j, v, d, t, k = o->k;
+  int tmin=255, tmax=0, maxc=0;
+
+  if (i0 == 0) {
+    op4=op3=op1=op2=o->image[o->y0*o->cols+o->x0];
+  } else { // last pixels of the row before (dx>=4, see otsu_stat)
+    np = &o->image[(o->y0+(i0-1)/k*k)*o->cols+o->x0+o->dx-1];
+    op1=np[0]; op2=np[-1]; op3=np[-2]; op4=np[-3];
+  }
+  for (i = i0; i < i1; i++) {
+    np = &o->image[(o->y0+i)*o->cols+o->x0];
+    if (i % k) { // only min/max of the rows between
+      if (o->all)
+        for (j = 0; j < o->dx ; j++) {
+          if (np[j] > tmax) tmax=np[j];
+          if (np[j] < tmin) tmin=np[j];
+        }
+      continue;
+    }
+    for (j = 0; j < o->dx ; j++) {
+      v = *np++;
+      d = Abs(v-op1);
+      t = Abs(v-op2); if (t>d) d=t;
+      // 2010-10-07 add op3+op4 for invalid_ogv.jpg
+      t = Abs(v-op3); if (t>d) d=t;
+      t = Abs(v-op4); if (t>d) d=t;
+      if (d > maxc) maxc=d; /* new maximum contrast */
+      if (h2) h2[(d<<8)+v]++; else r->ihist[v]++;
+      if (v > tmax) tmax=v;
+      if (v < tmin) tmin=v;
+      op4=op3;op3=op2;op2=op1;    /* shift old pixel to next older */
+      op1=v;       /* store old pixel for contrast check */
+    }
+  }
+  r->maxc=maxc; r->tmin=tmin; r->tmax=tmax;
+}
 
-  int i, j, k;          // various counters
-  int is, i1, i2, ns, n1, n2, gmin, gmax;
-  double m1, m2, sum, csum, fmax, sb;
+/*======================================================================*
+ * collect the histograms in one pass over the image (v0.53, was 2+1)   *
+ *   d = max. contrast of a pixel to its 4 predecessors,                *
+ *   h2[d*256+v] counts the pixels of gray value v and contrast d,      *
+ *   the contrast histogram (pixels with d>=maxc/4) is the sum over d   *
+ *   big images: only every k-th row goes into the histograms           *
+ *   every thread of tp has its own h2, the sums are the same           *
+ *======================================================================*/
+static void
+otsu_stat (unsigned char *image, int cols,
+      int x0, int y0, int dx, int dy, int all, otsu_stat_t *st,
+      tpool_t *tp) {
 
-  // zero out histogram ...
-  memset(ihist, 0, sizeof(ihist));
-  memset(chist, 0, sizeof(chist));
-  op4=op3=op1=op2=image[y0*cols+x0];
+  unsigned char *np;    // pointer to position in the image we are working with
+  unsigned char op1, op2, op3, op4;   // predecessor of pixel *np
+  otsu_rows_t o;
+  int i, j, v, d, n, np1;
+
+  memset(st, 0, sizeof(*st));
+  if (dx < 4) tp = NULL; // the predecessors of a row are in the row before
+  np1 = tpool_size(tp);
+  o.image=image; o.cols=cols; o.x0=x0; o.y0=y0; o.dx=dx; o.dy=dy;
+  o.k=dy/512+1; o.all=all;
+  o.part = (otsu_part_t *)calloc(np1, sizeof(otsu_part_t));
+  o.h2 = (int *)calloc((size_t)np1*256*256, sizeof(int));
+  if (!o.part || (!o.h2 && np1 > 1)) { // no memory, single thread
+    free(o.part); free(o.h2); tp = NULL; np1 = 1;
+    o.part = (otsu_part_t *)calloc(1, sizeof(otsu_part_t));
+    o.h2 = (int *)calloc(256*256, sizeof(int));
+    if (!o.part) { // no statistics, otsu_value() returns 160
+      free(o.h2); st->gmin=st->tmin=255; return; }
+  }
 
-  gmin=255; gmax=0; k=dy/512+1;
+  for (i = 0; i < np1; i++) { o.part[i].tmin=255; o.part[i].tmax=0; }
   // v0.43 first get max contrast, dont do it together with next step
   //  because it failes if we have pattern as background (on top)
-  for (i =  0; i <  dy ; i+=k) {
-    np = &image[(y0+i)*cols+x0];
-    for (j = 0; j < dx ; j++) {
-      ihist[*np]++;
-      if (*np > gmax) gmax=*np;
-      if (*np < gmin) gmin=*np;
-      if (Abs(*np-op1)>maxc) maxc=Abs(*np-op1); /* new maximum contrast */
-      if (Abs(*np-op2)>maxc) maxc=Abs(*np-op2); /* new maximum contrast */
-      // 2010-10-07 add op3+op4 for invalid_ogv.jpg
-      if (Abs(*np-op3)>maxc) maxc=Abs(*np-op3); /* new maximum contrast */
-      if (Abs(*np-op4)>maxc) maxc=Abs(*np-op4); /* new maximum contrast */
-      /* we hope that maxc will be find its maximum very fast */
-      op4=op3;op3=op2;op2=op1;    /* shift old pixel to next older */
-      op1=*np;     /* store old pixel for contrast check */
-      np++;       /* next pixel */
-    }
+  //  v0.53: h2 keeps the contrast of every pixel for the next step
+  tpool_for(tp, dy, otsu_rows, &o);
+  st->tmin=255; st->tmax=0;
+  for (i = 0; i < np1; i++) {
+    if (o.part[i].maxc > st->maxc) st->maxc = o.part[i].maxc;
+    if (o.part[i].tmin < st->tmin) st->tmin = o.part[i].tmin;
+    if (o.part[i].tmax > st->tmax) st->tmax = o.part[i].tmax;
   }
-  if ((vvv&1)) // Debug
-    fprintf(stderr,"# threshold: max_contrast= %d\n", maxc);
 
   // generate the histogram
   // Aug06 images with large white or black homogeneous
   //   areas give bad results, so we only add pixels on contrast edges
-  op4=op3=op1=op2=image[y0*cols+x0];
-  for (i =  0; i <  dy ; i+=k) {
-    np = &image[(y0+i)*cols+x0];
-    for (j = 0; j < dx ; j++) {
-      if (Abs(*np-op1)>=1*maxc/4 // min_d_max_contrast=1
-       || Abs(*np-op2)>=1*maxc/4 // min_d_max_contrast=2
-       || Abs(*np-op3)>=1*maxc/4
-       || Abs(*np-op4)>=1*maxc/4
-//       || Abs(*np-gmax)<=1*maxc/4
-//       || Abs(*np-gmin)<=1*maxc/4
-       )
-         chist[*np]++; // count only relevant pixels
-      op4=op3;op3=op2;op2=op1;    /* shift old pixel to next older */
-      op1=*np;     /* store old pixel for contrast check */
-      np++;       /* next pixel */
+  if (o.h2) {
+    for (i = 0; i < np1; i++)
+      for (d = 0; d <= st->maxc; d++)
+        for (v = 0; v < 256; v++) {
+          n = o.h2[i*256*256+(d<<8)+v];
+          st->ihist[v] += n;
+          if (d >= 1*st->maxc/4) // min_d_max_contrast=1
+            st->chist[v] += n; // count only relevant pixels
+        }
+  } else { // no memory, 2nd pass as before v0.53
+    memcpy(st->ihist, o.part[0].ihist, sizeof(st->ihist));
+    op4=op3=op1=op2=image[y0*cols+x0];
+    for (i =  0; i <  dy ; i+=o.k) {
+      np = &image[(y0+i)*cols+x0];
+      for (j = 0; j < dx ; j++) {
+        if (Abs(*np-op1)>=1*st->maxc/4 // min_d_max_contrast=1
+         || Abs(*np-op2)>=1*st->maxc/4 // min_d_max_contrast=2
+         || Abs(*np-op3)>=1*st->maxc/4
+         || Abs(*np-op4)>=1*st->maxc/4)
+           st->chist[*np]++; // count only relevant pixels
+        op4=op3;op3=op2;op2=op1;    /* shift old pixel to next older */
+        op1=*np;     /* store old pixel for contrast check */
+        np++;       /* next pixel */
+      }
     }
   }
+  free(o.h2); free(o.part);
+
+  st->gmin=255; st->gmax=0;
+  for (v = 0; v < 256; v++) if (st->ihist[v]) { st->gmin=v; break; }
+  for (v = 255; v >= 0; v--) if (st->ihist[v]) { st->gmax=v; break; }
+}
+
+/*======================================================================*
+ * the otsu threshold of the histograms, *inv=1 if the image has to be  *
+ *   inverted (the returned value is for the not inverted image then)   *
+ *======================================================================*/
+static int
+otsu_value (otsu_stat_t *st, int dx, int dy, int vvv, int *inv) {
+
+  int *ihist=st->ihist, *chist=st->chist;
+  int gmin=st->gmin, gmax=st->gmax, maxc=st->maxc;
+  int thresholdValue=1; // value we will threshold at
+  int k, is, i1, i2, ns, n1, n2;
+  double m1, m2, sum, csum, fmax, sb;
+
+  *inv = 0;
+  if ((vvv&1)) // Debug
+    fprintf(stderr,"# threshold: max_contrast= %d\n", maxc);
 
   // set up everything
   sum = csum = 0.0;
   ns = 0;
   is = 0;
-  
+
   for (k = 0; k <= 255; k++) {
     sum += (double) k * (double) chist[k];  /* x*f(x) cmass moment */
     ns  += chist[k];                        /*  f(x)    cmass      */
@@ -152,7 +248,7 @@ otsu (unsigned char *image, int cols, int rows,
   // ToDo: search max contrast in 2 near(r=8) pixels, take as mass centers + dist
   //   expand b/w-mass ranges by further contrast dipols
   //   min_max_b_b_distance + max_b_b distance
-  //  use a range white=... black=... for between values due local thresholding 
+  //  use a range white=... black=... for between values due local thresholding
   //  24x24 field (cashed) where 8x8 center is thresholded
   // ToDo: only care about extremas in a 3 pixel environment
   //       check if there are more than 2 mass centers (more colors)
@@ -160,16 +256,16 @@ otsu (unsigned char *image, int cols, int rows,
   //        also the reagion, where colored objects are found
   //       what if more than one background color? no otsu at all?
   //       whats background? box with lot of other boxes in it
-  //       threshold each box (examples/invers.png,colors.png) 
+  //       threshold each box (examples/invers.png,colors.png)
   //  get maximum white and minimum black pixel color (possible range)
   //    check range between them for low..high contrast ???
-  // typical scenes (which must be covered): 
+  // typical scenes (which must be covered):
   //    - white page with text of different colors (gray values)
   //    - binear page: background (gray=1) + black text (gray=0)
   //    - text mixed with big (dark) images
   //  ToDo: recursive clustering for maximum multipol moments?
   //  idea: normalize ihist to max=1024 before otsu?
-  
+
   // do the otsu global thresholding method
 
   if ((vvv&1)) // Debug
@@ -209,7 +305,7 @@ otsu (unsigned char *image, int cols, int rows,
 
   // at this point we have our thresholding value
   // black_char: value<cs,  white_background: value>=cs
-  
+
   // can it happen? check for sureness
   if (thresholdValue >  gmax) {
     fprintf(stderr,"# threshold: Value >gmax\n");
@@ -227,10 +323,35 @@ otsu (unsigned char *image, int cols, int rows,
      thresholdValue, gmin, gmax, maxc, i1, i2);
 
   // this is a primitive criteria for inversion and should be improved
-  // old: i1 >= 4*i2, but 0811qemu1.png has a bit above 1/4 
+  // old: i1 >= 4*i2, but 0811qemu1.png has a bit above 1/4
   if (2*i1 > 7*i2) { // more black than white, obviously black is background
     if ( vvv & 1 )
       fprintf(stderr,"# threshold: invert the image\n");
+    *inv = 1;
+  }
+
+  return(thresholdValue);
+}
+
+/*======================================================================*
+ * global thresholding routine                                          *
+ *   takes a 2D unsigned char array pointer, number of rows, and        *
+ *   number of cols in the array. returns the value of the threshold    *
+ * x0,y0,x0+dx,y0+dy are the edgepoints of the interesting region       *
+ * vvv is the verbosity for debugging purpose                           *
+ *======================================================================*/
+ /* JS 2019-04 changed 2nd+3th argument, new: 2nd=nx=cols, 3th=ny=rows */
+int
+otsu (unsigned char *image, int cols, int rows,
+      int x0, int y0, int dx, int dy, int vvv) {
+
+  unsigned char *np;    // pointer to position in the image we are working with
+  otsu_stat_t st;
+  int thresholdValue, inv, i, j;
+
+  otsu_stat(image, cols, x0, y0, dx, dy, 0, &st, NULL);
+  thresholdValue = otsu_value(&st, dx, dy, vvv, &inv);
+  if (inv) {
     // we do inversion here (no data lost)
     for (i =  0; i <  dy ; i++) {
       np = &image[(y0+i)*cols+x0];
@@ -242,13 +363,72 @@ otsu (unsigned char *image, int cols, int rows,
     thresholdValue=255-thresholdValue+1;
   }
 
-  return(thresholdValue); 
+  return(thresholdValue);
   /* range: 0 < thresholdValue <= 255, example: 1 on b/w images */
   /* 0..threshold-1 is foreground */
   /* threshold..255 is background */
   /* ToDo:  min=blackmasscenter/2,thresh,max=(whitemasscenter+255)/2 */
 }
 
+/*======================================================================*
+ * table of the new gray values (thresholding) for gmin..gmax, v0.53    *
+ *   returns the threshold (reset if out of range)                      *
+ *======================================================================*/
+static int
+threshold_lut (unsigned char *lut, int thresholdValue, int gmin, int gmax) {
+
+  int v;
+
+  /* allowed_threshold=gmin+1..gmax v0.43 */
+  if (thresholdValue<=gmin || thresholdValue>gmax){
+    thresholdValue=(gmin+gmax+1)/2; /* range=0..1 -> threshold=1 */
+    fprintf(stderr,"# thresholdValue out of range %d..%d, reset to %d\n",
+     gmin, gmax, thresholdValue);
+  }
+
+  /* b/w: min=0,tresh=1,max=1 v0.43 */
+  //  later: grayvalues should also be used, only rescaling threshold=160=0xA0
+  // sometimes images have no contrast (thresholdValue == gmin)
+  //   rescale 0..threshold-1 to 0...150
+  //   rescale threshold..255 to (255-80=175)..255
+  memset(lut, 0, 256); // values out of gmin..gmax are not in the image
+  for (v = gmin; v <= gmax; v++) {
+    lut[v] = (unsigned char) (v >= thresholdValue || thresholdValue == gmin ?
+         (255-(gmax - v)* 79/(gmax - thresholdValue + 1)) :  // -80
+         (  0+(v - gmin)*144/(thresholdValue - gmin    )) ); // 150
+    lut[v] &= ~15; // 2018-10 rnd80-Droid-Sans-Mono-Regular bad "e" pix 452,202
+  }
+  return thresholdValue;
+}
+
+typedef struct lut_remap_s {
+  unsigned char *image;
+  int cols, x0, y0, dx;
+  const unsigned char *lut;
+} lut_remap_t;
+
+/* rows i0..i1-1 (tpool_for) */
+static void lut_rows(void *arg, int i0, int i1, int id) {
+  lut_remap_t *r = (lut_remap_t *)arg;
+  unsigned char *np;
+  int i, j;
+  for (i = r->y0+i0; i < r->y0+i1; i++) {
+    np = &r->image[i*r->cols +r->x0];
+    for (j = 0; j < r->dx; j++) np[j] = r->lut[np[j]];
+  }
+}
+
+/* replace every pixel of the region by lut[pixel] */
+static void
+lut_remap (unsigned char *image, int cols,
+           int x0, int y0, int dx, int dy, const unsigned char *lut,
+           tpool_t *tp) {
+  lut_remap_t r;
+  r.image = image; r.cols = cols; r.x0 = x0; r.y0 = y0; r.dx = dx;
+  r.lut = lut;
+  tpool_for(tp, dy, lut_rows, &r);
+}
+
 /*======================================================================*/
 /* thresholding the image  (set threshold to 128+32=160=0xA0)           */
 /*   now we have a fixed thresholdValue good to recognize on gray image */
@@ -261,10 +441,10 @@ thresholding (unsigned char *image, int cols, int rows, /* pp dx dy */
   int x0, int y0, int dx, int dy, int thresholdValue) {
 
   unsigned char *np; // pointer to position in the image we are working with
+  unsigned char lut[256]; // new gray values, v0.53
 
   int i, j;          // various counters
   int gmin=255,gmax=0;
-  int nmin=255,nmax=0;
 
   // Aug10: i=y0+1, why 1 pixel frame? bug if v[y0] > gmax, fixed
   // calculate min/max (twice?)
@@ -276,42 +456,229 @@ thresholding (unsigned char *image, int cols, int rows, /* pp dx dy */
       np++; /* next pixel */
     }
   }
-  
-  /* allowed_threshold=gmin+1..gmax v0.43 */
-  if (thresholdValue<=gmin || thresholdValue>gmax){
-    thresholdValue=(gmin+gmax+1)/2; /* range=0..1 -> threshold=1 */
-    fprintf(stderr,"# thresholdValue out of range %d..%d, reset to %d\n",
-     gmin, gmax, thresholdValue);
-  }
 
-  /* b/w: min=0,tresh=1,max=1 v0.43 */
   // actually performs the thresholding of the image...
-  //  later: grayvalues should also be used, only rescaling threshold=160=0xA0
-  // sometimes images have no contrast (thresholdValue == gmin)
-  //   rescale 0..threshold-1 to 0...150
-  //   rescale threshold..255 to (255-80=175)..255 
-  for (i = y0; i < y0+dy; i++) {
-    np = &image[i*cols +x0];
-    for (j = x0; j < x0+dx; j++) {
-      // if (j==453 && i==203) fprintf(stderr,"DBG.otsu %3d %3d\n",*np,thresholdValue);
-      if ( *np > gmax || *np <gmin) // should never happen
-        fprintf(stderr,"ERROR th yx= %2d %2d t= %d v= %3d min/max= %d %d\n",
-          i,j,thresholdValue,*np,gmin,gmax);
-      *np = (unsigned char) (*np >= thresholdValue || thresholdValue == gmin ?
-         (255-(gmax - *np)* 79/(gmax - thresholdValue + 1)) :  // -80
-         (  0+(*np - gmin)*144/(thresholdValue - gmin    )) ); // 150
-      *np &= ~15; // 2018-10 rnd80-Droid-Sans-Mono-Regular bad "e" pix 452,202
-      if(*np > nmax) nmax=*np;
-      if(*np < nmin) nmin=*np;
-      np++;
-      // if (j==453 && i==203) fprintf(stderr,"DBG.otsu %3d %3d\n",*np,thresholdValue);
-    }
-  }
-
-  // fprintf(stderr,"# thresholding:  nmin=%d nmax=%d\n", nmin, nmax);
+  threshold_lut(lut, thresholdValue, gmin, gmax);
+  lut_remap(image, cols, x0, y0, dx, dy, lut, NULL);
 
   return(128+32); // return the new normalized threshold value
   /*   0..159 is foreground (0..144) */
   /* 160..255 is background (176..255) */
 }
 
+/*======================================================================*/
+/* otsu() + thresholding() with one pass for the statistics and one     */
+/*   for the new gray values, the inversion is part of the table, v0.53 */
+/*   thresholdValue=0: use the otsu threshold, threads of tp or NULL    */
+/*======================================================================*/
+int
+otsu_thresholding (unsigned char *image, int cols, int rows,
+      int x0, int y0, int dx, int dy, int thresholdValue, int vvv,
+      tpool_t *tp) {
+
+  unsigned char lut[256], ilut[256];
+  otsu_stat_t st;
+  int t, inv, gmin, gmax, v;
+
+  otsu_stat(image, cols, x0, y0, dx, dy, 1, &st, tp);
+  t = otsu_value(&st, dx, dy, vvv, &inv);
+  gmin = st.tmin; gmax = st.tmax;
+  if (inv) { // min/max of the inverted image
+    t = 255-t+1;
+    gmin = 255-st.tmax; gmax = 255-st.tmin;
+  }
+  if (thresholdValue == 0) thresholdValue = t;
+  threshold_lut(lut, thresholdValue, gmin, gmax);
+  if (inv) { // we do inversion here (no data lost)
+    for (v = 0; v < 256; v++) ilut[v] = lut[255-v];
+    lut_remap(image, cols, x0, y0, dx, dy, ilut, tp);
+  } else
+    lut_remap(image, cols, x0, y0, dx, dy, lut, tp);
+
+  return(128+32); // see thresholding()
+}
+
+/*======================================================================*
+ * local thresholding (gocr --local=sauvola|wolf[,w[,k]]), v0.53        *
+ *   threshold of every pixel from mean m and standard deviation s of   *
+ *   the w x w window around it, m and s from integral images of v and  *
+ *   v*v (O(1) per pixel), for uneven light and photos                  *
+ *   sauvola: T = m*(1+k*(s/128-1))            default k=0.34           *
+ *   wolf:    T = m-k*(1-s/R)*(m-M)            default k=0.50           *
+ *            M = min. gray value, R = max. s of the image              *
+ *   the image is cut into tiles of rows, every tile has its own        *
+ *   integral images (tile + window rows), tiles run on the threads     *
+ *   output is the same 0..144/176..255 as thresholding() (table of the *
+ *   new gray value for every threshold t and value v)                  *
+ * ToDo: w from the size of the chars                                   *
+ *======================================================================*/
+#define LTHR_TILE 128   /* rows of a tile */
+#define LTHR_VMAX 16257 /* max. variance of 0..255 + 1 */
+
+typedef struct lthr_s {
+  unsigned char *src;   // copy of the region (inverted if needed)
+  unsigned char *image; // output
+  int cols, x0, y0, dx, dy;
+  int method, h, k;     // h=w/2, k in percent
+  int gmin, gmax;
+  int R8;               // wolf: max. of 8*s
+  int *sq8;             // sq8[var] = 8*sqrt(var)
+  unsigned char *lut;   // lut[t*256+v] new gray value of v, threshold t
+  int pass;             // 0: R8 only (wolf), 1: thresholding
+  int *s8max;           // max. of 8*s of the tiles of every part (pass 0)
+  int *err;             // no memory, for every part
+} lthr_t;
+
+/* tiles i0..i1-1 of the image (tpool_for) */
+static void lthr_tiles(void *arg, int i0, int i1, int id) {
+  lthr_t *lt = (lthr_t *)arg;
+  unsigned int *S, *S2, *r0, *r1, *q0, *q1, rs, rs2;
+  unsigned char *sp, *np;
+  int tile, ya, yb, y, x, x1, x2, y1, y2, v, t, s8, w1;
+  double m, var, T, A, B, *ninv;
+
+  w1 = lt->dx + 1;
+  S  = (unsigned int *)malloc(sizeof(unsigned int) * w1
+                              * (LTHR_TILE + 2 * lt->h + 2));
+  S2 = (unsigned int *)malloc(sizeof(unsigned int) * w1
+                              * (LTHR_TILE + 2 * lt->h + 2));
+  ninv = (double *)malloc(sizeof(double) * (2 * lt->h + 2));
+  if (!S || !S2 || !ninv) {
+    free(S); free(S2); free(ninv); lt->err[id] = 1; return; }
+  // T = m*(A+B*s8) (sauvola) or m-(m-M)*(A-B*s8) (wolf), no divisions
+  if (lt->method == 2) { A = lt->k / 100.0; B = A / lt->R8; }
+  else { A = 1.0 - lt->k / 100.0; B = lt->k / 102400.0; }
+  for (tile = i0; tile < i1; tile++) {
+    // integral images of rows ya..yb-1, row 0 is zero
+    // sums of unsigned int may wrap, the window sums are exact (w<256)
+    ya = tile * LTHR_TILE - lt->h;               if (ya < 0) ya = 0;
+    yb = (tile + 1) * LTHR_TILE + lt->h + 1;     if (yb > lt->dy) yb = lt->dy;
+    memset(S, 0, sizeof(unsigned int) * w1);
+    memset(S2, 0, sizeof(unsigned int) * w1);
+    for (y = ya; y < yb; y++) {
+      sp = lt->src + (size_t)y * lt->dx;
+      r0 = S  + (size_t)(y - ya) * w1; r1 = r0 + w1;
+      q0 = S2 + (size_t)(y - ya) * w1; q1 = q0 + w1;
+      r1[0] = q1[0] = rs = rs2 = 0;
+      for (x = 0; x < lt->dx; x++) {
+        v = sp[x]; rs += v; rs2 += v * v;
+        r1[x+1] = r0[x+1] + rs;
+        q1[x+1] = q0[x+1] + rs2;
+      }
+    }
+    for (y = tile * LTHR_TILE; y < (tile + 1) * LTHR_TILE && y < lt->dy; y++) {
+      y1 = y - lt->h;     if (y1 < ya) y1 = ya;
+      y2 = y + lt->h + 1; if (y2 > yb) y2 = yb;
+      r0 = S  + (size_t)(y1 - ya) * w1; r1 = S  + (size_t)(y2 - ya) * w1;
+      q0 = S2 + (size_t)(y1 - ya) * w1; q1 = S2 + (size_t)(y2 - ya) * w1;
+      sp = lt->src + (size_t)y * lt->dx;
+      np = lt->image + (size_t)(lt->y0 + y) * lt->cols + lt->x0;
+      for (x = 1; x <= 2 * lt->h + 1; x++) ninv[x] = 1.0 / ((y2 - y1) * x);
+      for (x = 0; x < lt->dx; x++) {
+        x1 = x - lt->h;     if (x1 < 0) x1 = 0;
+        x2 = x + lt->h + 1; if (x2 > lt->dx) x2 = lt->dx;
+        m   = (double)(r1[x2] - r1[x1] - r0[x2] + r0[x1]) * ninv[x2 - x1];
+        var = (double)(q1[x2] - q1[x1] - q0[x2] + q0[x1]) * ninv[x2 - x1]
+            - m * m;
+        v = (int)var; if (v < 0) v = 0; if (v >= LTHR_VMAX) v = LTHR_VMAX - 1;
+        s8 = lt->sq8[v];
+        if (lt->pass == 0) {
+          if (s8 > lt->s8max[id]) lt->s8max[id] = s8;
+          continue;
+        }
+        if (lt->method == 2) T = m - (m - lt->gmin) * (A - B * s8); // wolf
+        else                 T = m * (A + B * s8);                  // sauvola
+        t = (int)T; if (t < T) t++;  // v < T is black
+        if (t <= lt->gmin) t = lt->gmin + 1;
+        if (t >  lt->gmax) t = lt->gmax;
+        np[x] = lt->lut[(t << 8) + sp[x]];
+      }
+    }
+  }
+  free(S); free(S2); free(ninv);
+}
+
+/* run lthr_tiles on the threads, returns max. of 8*s or -1 (no memory) */
+static int lthr_pass(lthr_t *lt, int pass, tpool_t *tp) {
+  int i, n = tpool_size(tp), s8max = 0, err = 0;
+
+  lt->pass = pass;
+  for (i = 0; i < n; i++) lt->s8max[i] = lt->err[i] = 0;
+  tpool_for(tp, (lt->dy + LTHR_TILE - 1) / LTHR_TILE, lthr_tiles, lt);
+  for (i = 0; i < n; i++) {
+    if (lt->s8max[i] > s8max) s8max = lt->s8max[i];
+    if (lt->err[i]) err = 1;
+  }
+  return (err) ? -1 : s8max;
+}
+
+int
+local_thresholding (unsigned char *image, int cols, int rows,
+      int x0, int y0, int dx, int dy, int method, int w, int k,
+      int vvv, tpool_t *tp) {
+
+  lthr_t lt;
+  otsu_stat_t st;
+  unsigned char *np, *sp;
+  int t, inv, i, j, r;
+
+  // otsu for the inversion and the messages of -v 1
+  otsu_stat(image, cols, x0, y0, dx, dy, 1, &st, tp);
+  t = otsu_value(&st, dx, dy, vvv, &inv);
+  memset(&lt, 0, sizeof(lt));
+  lt.gmin = st.tmin; lt.gmax = st.tmax;
+  if (inv) { t = 255-t+1; lt.gmin = 255-st.tmax; lt.gmax = 255-st.tmin; }
+  if (w <= 0) w = 31;
+  if (w > 255) w = 255; // unsigned int window sums
+  if (k <= 0) k = (method == 2) ? 50 : 34;
+  lt.image = image; lt.cols = cols; lt.x0 = x0; lt.y0 = y0;
+  lt.dx = dx; lt.dy = dy; lt.method = method; lt.h = w / 2; lt.k = k;
+  if (lt.gmax > lt.gmin && dx > 0 && dy > 0) {
+    lt.src = (unsigned char *)malloc((size_t)dx * dy);
+    lt.sq8 = (int *)malloc(sizeof(int) * LTHR_VMAX);
+    lt.lut = (unsigned char *)malloc(256 * 256);
+    lt.s8max = (int *)malloc(2 * sizeof(int) * tpool_size(tp));
+    lt.err = lt.s8max + tpool_size(tp);
+  }
+  if (!lt.src || !lt.sq8 || !lt.lut || !lt.s8max) { // no memory/contrast
+    if (lt.gmax > lt.gmin)
+      fprintf(stderr, "# local thresholding: no memory, use otsu\n");
+    free(lt.src); free(lt.sq8); free(lt.lut); free(lt.s8max);
+    if (inv) for (i = 0; i < dy; i++) {
+      np = &image[(y0+i)*cols+x0];
+      for (j = 0; j < dx; j++) np[j] = 255 - np[j];
+    }
+    return thresholding(image, cols, rows, x0, y0, dx, dy, t);
+  }
+  for (i = 0; i < dy; i++) {
+    np = &image[(y0+i)*cols+x0];
+    sp = lt.src + (size_t)i * dx;
+    if (inv) for (j = 0; j < dx; j++) sp[j] = 255 - np[j];
+    else memcpy(sp, np, dx);
+  }
+  for (r = i = 0; i < LTHR_VMAX; i++) { // r = 8*sqrt(i) without libm
+    while ((r + 1) * (r + 1) <= 64 * i) r++;
+    lt.sq8[i] = r;
+  }
+  for (t = lt.gmin + 1; t <= lt.gmax; t++) // as thresholding()
+    threshold_lut(lt.lut + (t << 8), t, lt.gmin, lt.gmax);
+
+  r = 0;
+  if (method == 2) { // wolf needs R, the max. s of the image
+    r = lthr_pass(&lt, 0, tp);
+    lt.R8 = (r > 0) ? r : 1;
+  }
+  if (r >= 0) r = lthr_pass(&lt, 1, tp);
+  if (vvv & 1)
+    fprintf(stderr, "# local thresholding: %s w= %d k= %d gmin= %d gmax= %d"
+      " R= %d threads= %d\n", (method == 2) ? "wolf" : "sauvola",
+      2 * lt.h + 1, k, lt.gmin, lt.gmax, lt.R8 / 8, tpool_size(tp));
+  if (r < 0) { // no memory for the integral images
+    fprintf(stderr, "# local thresholding: no memory, use otsu\n");
+    for (i = 0; i < dy; i++)
+      memcpy(&image[(y0+i)*cols+x0], lt.src + (size_t)i * dx, dx);
+    t = thresholding(image, cols, rows, x0, y0, dx, dy, t);
+  }
+  free(lt.src); free(lt.sq8); free(lt.lut); free(lt.s8max);
+  return(128+32); // see thresholding()
+}
@@ -4,6 +4,7 @@
 
  */
 
+#include "tpool.h"
 
 /*======================================================================*/
 /* OTSU global thresholding routine                                     */
@@ -25,3 +26,24 @@ otsu (unsigned char *image, int cols, int rows,
 int
 thresholding (unsigned char *image, int cols, int rows,
               int x0, int y0, int dx, int dy, int thresholdValue);
+
+/*======================================================================*/
+/* otsu() + thresholding() in one call, one pass for the statistics     */
+/*   and one for the new gray values (v0.53), same result               */
+/*   thresholdValue=0: use the otsu threshold, returns 160              */
+/*   tp: threads for the passes (NULL = 1), same result for all tp      */
+/*======================================================================*/
+int
+otsu_thresholding (unsigned char *image, int cols, int rows,
+      int x0, int y0, int dx, int dy, int thresholdValue, int vvv,
+      tpool_t *tp);
+
+/*======================================================================*/
+/* local thresholding (Sauvola method=1, Wolf method=2), v0.53          */
+/*   w = window size (0 = 31), k in percent (0 = default of method)     */
+/*   same output as thresholding(), returns 160                         */
+/*======================================================================*/
+int
+local_thresholding (unsigned char *image, int cols, int rows,
+      int x0, int y0, int dx, int dy, int method, int w, int k,
+      int vvv, tpool_t *tp);
@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "unicode.h"
 #include "output.h"
 #include "pcx.h"
-#include "gocr.h"  /* extern job_t OCR_JOB; */
+#include "gocr.h"  /* job_t, boxes find it by box->p->job */
 #include "unicode_defs.h" /* UNKNOWN + PICTURE */
 
 /* function is only for debugging and for developing
@@ -34,7 +34,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 void out_b(struct box *px, pix *b, int x0, int y0, int dx, int dy, int cs ){
   int x,y,x2,y2,yy0,tx,ty,n1,i;
-  char c1, c2;
+  char c1, c2, dbuf[2][DECODE_BUFLEN];
   yy0=y0;
   if (px) { /* overwrite rest of arguments */
     if (!b) {
@@ -42,15 +42,16 @@ void out_b(struct box *px, pix *b, int x0, int y0, int dx, int dy, int cs ){
       x0=px->x0; dx=px->x1-px->x0+1;
       y0=px->y0; dy=px->y1-px->y0+1; yy0=y0;
     }
-    if(cs==0) cs=OCR_JOB->cfg.cs;
+    if(cs==0) cs=px->p->job->cfg.cs;
     fprintf(stderr,"\n# list box      x= %4d %4d d= %3d %3d r= %3d %3d"
                     " nrun=%d p=%p", /* ToDo: r,nrun is obsolete */
 	  px->x0, px->y0, px->x1 - px->x0 + 1, px->y1 - px->y0 + 1,
-	  px->x - px->x0, px->y - px->y0, OCR_JOB->tmp.n_run, (void*)px);
+	  px->x - px->x0, px->y - px->y0, px->p->job->tmp.n_run, (void*)px);
     fprintf(stderr,"\n#  dots=%d boxes=%d subboxes=%d c=%s mod=%s"
             " line=%d m= %d %d %d %d",
 	  px->dots, px->num_boxes, px->num_subboxes, 
-	  decode(px->c,ASCII), decode(px->modifier,ASCII), px->line,
+	  decode_r(px->c,ASCII,dbuf[0]), decode_r(px->modifier,ASCII,dbuf[1]),
+	  px->line,
 	  px->m1 - px->y0, px->m2 - px->y0, px->m3 - px->y0, px->m4 - px->y0);
     if (px->num_frames) {
       int i,j,jo;
@@ -75,7 +76,7 @@ void out_b(struct box *px, pix *b, int x0, int y0, int dx, int dy, int cs ){
         if (px->tas[i])
          fprintf(stderr," %s(%d)",       px->tas[i]       ,px->wac[i]);
         else
-         fprintf(stderr," %s(%d)",decode(px->tac[i],ASCII),px->wac[i]);
+         fprintf(stderr," %s(%d)",decode_r(px->tac[i],ASCII,dbuf[0]),px->wac[i]);
     }
     fprintf(stderr,"\n");
     if (px->m2 && px->m1<y0 && (px->dots || y0>px->m2)) {
@@ -133,7 +134,7 @@ void out_b(struct box *px, pix *b, int x0, int y0, int dx, int dy, int cs ){
 /* same as out_b, but for faster use, only a box as argument
  */
 void out_x(struct box *px) {
-  out_b(px,NULL,0, 0, 0, 0, OCR_JOB->cfg.cs);
+  out_b(px,NULL,0, 0, 0, 0, px->p->job->cfg.cs);
 }
 
 
@@ -141,7 +142,8 @@ void out_x(struct box *px) {
 void out_x2(struct box *box1, struct box *box2){
   int x,y,i,tx,ty,dy;
   /*FIXME jb static*/static char *c1="OXXXXxx@.,,,,,,,";
-  pix *b=&OCR_JOB->src.p;
+  pix *b=box1->p; /* source image of the job */
+  int cs=b->job->cfg.cs;
   dy=(box1->y1-box1->y0+1);
   if(dy<box2->y1-box2->y0+1)dy=box2->y1-box2->y0+1;
   tx=(box1->x1-box1->x0)/40+1;
@@ -150,11 +152,11 @@ void out_x2(struct box *box1, struct box *box2){
   for(i=0;i<dy;i+=ty) { /* reduce the output to max 78x40??? */
     fprintf(stderr,"\n"); y=box1->y0+i;
     for(x=box1->x0;x<=box1->x1;x+=tx) 
-    fprintf(stderr,"%c", c1[ ((getpixel(b,x,y)<OCR_JOB->cfg.cs)?0:8)+marked(b,x,y) ] );
+    fprintf(stderr,"%c", c1[ ((getpixel(b,x,y)<cs)?0:8)+marked(b,x,y) ] );
     if(!box2) continue;
     fprintf(stderr,"  "); y=box2->y0+i;
     for(x=box2->x0;x<=box2->x1;x+=tx)
-    fprintf(stderr,"%c", c1[ ((getpixel(b,x,y)<OCR_JOB->cfg.cs)?0:8)+marked(b,x,y) ] );
+    fprintf(stderr,"%c", c1[ ((getpixel(b,x,y)<cs)?0:8)+marked(b,x,y) ] );
   }
 }
 
@@ -166,7 +168,7 @@ int output_list(job_t *job) {
   int i = 0, j;
   struct box *box2;
   pix  *pp = &job->src.p;
-  char *lc = job->cfg.lc;
+  char *lc = job->cfg.lc, dbuf[DECODE_BUFLEN];
 
   fprintf(stderr,"\n# list shape for charlist %s",lc);
   for_each_data(&(job->res.boxlist)) {
@@ -187,7 +189,7 @@ int output_list(job_t *job) {
 	      box2->y1 - box2->y0 + 1,
 	      box2->num_frames, box2->num_ac, 
 	      (int)box2->c,   /* wchar_t -> char ???? */
-	      decode(box2->c,ASCII) );
+	      decode_r(box2->c,ASCII,dbuf) );
       if (job->cfg.verbose & 4) out_x(box2);
     }
     i++;
@@ -209,7 +211,7 @@ int debug_img(char *fname, struct job_s *job, int opt) {
   struct box *box2;
   int x, y, ic, dx, i, j, col;
   unsigned char *np;
-  if (!job) { fprintf(stderr,"ERR job==NULL\n"); exit(1); }
+  if (!job) { fprintf(stderr,"ERR job==NULL\n"); return -1; }
   pix *pp = &job->tmp.ppo;
   
   if ( opt & 8 ) {		/* clear debug bits in image */
@@ -289,7 +291,7 @@ int debug_img(char *fname, struct job_s *job, int opt) {
 
   if ((job->cfg.verbose&33) || pp->x*pp->y <= 0)
     fprintf(stderr,"# writing %s[.png] xy= %d %d\n", fname, pp->x, pp->y);
-  if (pp->x*pp->y <= 0) exit(1); // generate error
+  if (pp->x*pp->y <= 0) return -1; // was exit(1), v0.53
   writeppm(fname, pp, opt);
   return 0;
 }
@@ -29,26 +29,28 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 typedef unsigned char byte;
 
 #define ERR(x) { fprintf(stderr,"ERROR "__FILE__" L%d: " x "\n",__LINE__);exit(1);}
+/* error of readpcx, the batch mode goes on with the next file */
+#define RERR(x) { fprintf(stderr,"ERROR "__FILE__" L%d: " x "\n",__LINE__); \
+                  if (f1) fclose(f1); return -1; }
 
-int err;
-/* --- needed for reading PCX-files */
-unsigned char read_b(FILE *f1){
-  unsigned char c=0; c=fgetc(f1); if(feof(f1) || ferror(f1))err=1; return c;
+/* --- needed for reading PCX-files, err was global before v0.53 */
+unsigned char read_b(FILE *f1, int *err){
+  unsigned char c=0; c=fgetc(f1); if(feof(f1) || ferror(f1))*err=1; return c;
 }
 
-/* something here is wrong! */
-void readpcx(char *name,pix *p,int vvv){  /* see pcx.format.txt */
-  int page,pages,nx,ny,i,j,b,x,y,bpl,bits,pal[256][3];
-  FILE *f1;
+/* something here is wrong! returns 0 or -1 on errors (was exit, v0.53) */
+int readpcx(char *name,pix *p,int vvv){  /* see pcx.format.txt */
+  int page,pages,nx,ny,i,j,b,x,y,bpl,bits,pal[256][3],err;
+  FILE *f1=NULL;
   unsigned char *pic,h[128],bb,b1,b2,b3;
   err=0;
   for(i=0;i<256;i++)for(j=0;j<3;j++)pal[i][j]=i;
-  f1=fopen(name,"rb"); if(!f1) ERR("open");
-  if(fread(h,1,128,f1)!=128)ERR("read PCX header");    /* 128 Byte lesen -> h[] */
-  if(h[0]!=10)ERR("no ZSoft sign");	/* ZSoft sign */
-  if(h[2]>  1)ERR("unknown coding");	/* run length encoding */
+  f1=fopen(name,"rb"); if(!f1) RERR("open");
+  if(fread(h,1,128,f1)!=128)RERR("read PCX header");    /* 128 Byte lesen -> h[] */
+  if(h[0]!=10)RERR("no ZSoft sign");	/* ZSoft sign */
+  if(h[2]>  1)RERR("unknown coding");	/* run length encoding */
   bits = h[3];		/* 1 or 8 */
-  if(bits!=1 && bits!=8)ERR("only 1 or 8 bits supported");
+  if(bits!=1 && bits!=8)RERR("only 1 or 8 bits supported");
   nx = h[ 9]*256+h[ 8] - h[ 5]*256-h[ 4] +1;	/* Xmax-Xmin 16bit 65Kpix/2 */
   ny = h[11]*256+h[10] - h[ 7]*256-h[ 6] +1;	/* Ymax-Ymin 16bit */
   pages=h[65]; bpl=h[66]+256*h[67]; /* bytes per line */
@@ -64,21 +66,21 @@ void readpcx(char *name,pix *p,int vvv){  /* see pcx.format.txt */
   if(pages>1)for(b=0;b<16;b++) for(i=0;i<16;i++)
              for(j=0;j< 3;j++) pal[b*16+i][j]=h[16+3*i+j]>>2;
   if(bits>7){
-   fseek(f1,-3*256,2); if(fread(pal,3,256,f1)!=256)ERR("read palette");
+   fseek(f1,-3*256,2); if(fread(pal,3,256,f1)!=256)RERR("read palette");
    for(i=0;i<256;i++) for(j=0;j<3;j++) pal[i][j]>>=2;
   }
   fseek(f1,128,0);
   /* we do not support uint16 to make things simpler, safety */
   if (nx<=0 || ny<=0 || nx*ny<=0   /* 2019-04 accept 31bit-product maximum */
-   || ((unsigned)(nx*ny))/nx != ny) ERR("nx*ny out of range"); /* opt away? */
+   || ((unsigned)(nx*ny))/nx != ny) RERR("nx*ny out of range"); /* opt away? */
   pic=(unsigned char *)malloc( nx*ny );  /* max. 2GB, size_t (>= int32) */
-  if (pic==NULL) ERR("malloc(x*y) failed"); /* not enough memory? */
+  if (pic==NULL) RERR("malloc(x*y) failed"); /* not enough memory? */
   x=y=0;
   do {
     for(page=0;page<pages;page++)    /* 192 == 0xc0 => b1=counter */
     do {
-      b1=1; bb=read_b(f1); b2=bb; if(b1==192)fprintf(stderr,"?");
-      if((b2>=192) && (h[2]==1)){b1=b2&63;bb=read_b(f1);b2=bb;}
+      b1=1; bb=read_b(f1,&err); b2=bb; if(b1==192)fprintf(stderr,"?");
+      if((b2>=192) && (h[2]==1)){b1=b2&63;bb=read_b(f1,&err);b2=bb;}
       if(err){fprintf(stderr,"\nread error x=%d y=%d\n",x,y);x=nx;y=ny;break;}
       for(b3=0;b3<b1;b3++)for(b=0;b<8;b+=bits,x++)if(x<nx){
         bb=(b2>>(8-bits-b)) & ~((~0)<<bits);
@@ -90,8 +92,9 @@ void readpcx(char *name,pix *p,int vvv){  /* see pcx.format.txt */
   } while(y<ny);
   /*  */
   fclose(f1);
-  p->p=pic;  p->x=nx;  p->y=ny; p->bpp=1;
+  p->p=pic;  p->x=nx;  p->y=ny; p->bpp=1; p->bits=NULL; p->fbits=NULL; p->sat=NULL; p->marks=NULL;
   if(vvv)fprintf(stderr,"\n");
+  return 0;
 }
 
 /* -----------------------------------------------------------------------
@@ -102,7 +105,7 @@ void readpcx(char *name,pix *p,int vvv){  /* see pcx.format.txt */
 void writebmp(char *name,pix p,int vvv){ /* see pcx.format.txt */
   int nx,ny,i,y,rest[4]={0,0,0,0};
   FILE *f1;
-  /*FIXME jb static*/static unsigned char *pic, h[54+4*256];
+  unsigned char *pic, h[54+4*256];
   long fs,fo,hs,is; /* filesize, offset, headersize, imagesize */
 
   nx=p.x; ny=p.y; pic=p.p;
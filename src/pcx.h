@@ -1,7 +1,7 @@
 
 #include "pnm.h"
 
-void readpcx(char *name,pix *p,int vvv);
+int readpcx(char *name,pix *p,int vvv); /* 0 or -1 on errors */
 
 /* write 8bit palette no RLE, ToDo: obsolete?  */
 void writebmp(char *name,pix p,int vvv);
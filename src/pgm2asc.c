@@ -195,6 +195,23 @@ char get_bw(int x0, int x1, int y0, int y1, pix * p, int cs, int mask) {
   if (y0 < 0)        y0 = 0;
   if (y1 >= p->y)    y1 = p->y - 1;
 
+  if (x0 <= x1 && y0 <= y1 && PIX_SAT_OK(p, cs, x0, x1, y0, y1)) { /* O(1) */
+    x = pix_sat_count(p, x0, x1, y0, y1);
+    if (x > 0)                           rc |= 1;
+    if (x < (x1 - x0 + 1) * (y1 - y0 + 1)) rc |= 2;
+    return (rc & mask);
+  }
+  if (PIX_BITS_OK(p, cs)) { /* count black pixels word by word, v0.53 */
+    for ( y = y0; y <= y1 && x0 <= x1; y++) {
+      x = pix_bits_count(p, x0, x1, y);
+      if (x > 0)       rc |= 1;
+      if (x <= x1 - x0) rc |= 2;
+      if ((rc & mask) == mask)
+        return mask;
+    }
+    return (rc & mask);
+  }
+
   for ( y = y0; y <= y1; y++)
     for ( x = x0; x <= x1; x++) {
       rc |= ((getpixel(p, x, y) < cs) ? 1 : 2);	// break if rc==3
@@ -204,6 +221,35 @@ char get_bw(int x0, int x1, int y0, int y1, pix * p, int cs, int mask) {
   return (rc & mask);
 }
 
+/* number of black pixels (<cs) in the rectangle x0..x1, y0..y1, v0.53
+ *  by the summed-area table of the page, if it is up to date and the
+ *  rectangle is not too big, else by the packed plane */
+int count_black(int x0, int x1, int y0, int y1, pix * p, int cs) {
+  int x, y, n = 0;
+
+  if (x0 < 0)        x0 = 0;
+  if (x1 >= p->x)    x1 = p->x - 1;
+  if (y0 < 0)        y0 = 0;
+  if (y1 >= p->y)    y1 = p->y - 1;
+  if (x0 > x1 || y0 > y1) return 0;
+
+  if (PIX_SAT_OK(p, cs, x0, x1, y0, y1))
+    return pix_sat_count(p, x0, x1, y0, y1);
+  if (PIX_BITS_OK(p, cs)) {
+    for ( y = y0; y <= y1; y++) n += pix_bits_count(p, x0, x1, y);
+    return n;
+  }
+  for ( y = y0; y <= y1; y++)
+    for ( x = x0; x <= x1; x++)
+      if (getpixel(p, x, y) < cs) n++;
+  return n;
+}
+
+/* 1 if the rectangle x0..x1, y0..y1 has no black pixel, v0.53 */
+int empty_rect(int x0, int x1, int y0, int y1, pix * p, int cs) {
+  return (get_bw(x0, x1, y0, y1, p, cs, 1) == 0);
+}
+
 /* more general Mar2000 (x0,x1,y0,y1 instead of x0,y0,x1,y1! (history))
  * look for black crossings throw a line from x0,y0 to x1,y1 and count them
  * follow line and count crossings ([white]-black-transitions)
@@ -217,17 +263,27 @@ char get_bw(int x0, int x1, int y0, int y1, pix * p, int cs, int mask) {
  *            ......#.#########.#...... should count as 1 cross
  */
 int num_cross(int x0, int x1, int y0, int y1, pix *p, int cs) {
-  int rc = 0, col = 0, k, x, y, i, d;	// rc=crossings  col=0=white
+  int rc = 0, col = 0, k, x, y, i, d, n;	// rc=crossings  col=0=white
   int dx = x1 - x0, dy = y1 - y0;
   int w2_cross=0, w1_cross=0, w1_white=0; // last + 2nd-last cross-width
+  /* horizontal lines are done run by run on the packed plane, v0.53 */
+  int runs = (dy == 0 && dx >= 0 && x0 >= 0 && x1 < p->x
+           && y0 >= 0 && y0 < p->y && PIX_BITS_OK(p, cs));
 
   d = MAX(abs(dx), abs(dy));
-  for (i = 0, x = x0, y = y0; i <= d; i++) {
-    if (d) {
-      x = x0 + i * dx / d;
-      y = y0 + i * dy / d;
+  for (i = 0, x = x0, y = y0; i <= d; i += n) {
+    n = 1; /* number of pixels of same color */
+    if (runs) {
+      x = x0 + i;
+      k = PIX_BIT(p, x, y0);
+      n = pix_bits_next(p, x, x1, y0, !k) - x;
+    } else {
+      if (d) {
+        x = x0 + i * dx / d;
+        y = y0 + i * dy / d;
+      }
+      k = ((getpixel(p, x, y) < cs) ? 1 : 0);	// 0=white 1=black
     }
-    k = ((getpixel(p, x, y) < cs) ? 1 : 0);	// 0=white 1=black
     if (col == 0 && k == 1) rc++; // found a white-black transition
     if (col == 1 && k == 1) w1_cross++; // 1810 add line-width
     if (col == 1 && k == 0) {
@@ -238,6 +294,7 @@ int num_cross(int x0, int x1, int y0, int y1, pix *p, int cs) {
     }
     if (col == 0 && k == 0) w1_white++; // 1810 add line-width
     if (col == 0 && k == 1) w1_white=0;
+    if (k) w1_cross += n - 1; else w1_white += n - 1; /* rest of the run */
     col = k;        // last color
   }
   return rc;
@@ -247,6 +304,14 @@ int num_cross_fine(int x0, int x1, int y0, int y1, pix *p, int cs) {
   int rc = 0, col = 0, k, x, y, i, d;	// rc=crossings  col=0=white
   int dx = x1 - x0, dy = y1 - y0;
 
+  if (dy == 0 && dx >= 0 && x0 >= 0 && x1 < p->x
+   && y0 >= 0 && y0 < p->y && PIX_BITS_OK(p, cs)) { /* v0.53 */
+    for (x = x0; ; rc++) { /* count black runs */
+      x = pix_bits_next(p, x, x1, y0, 1); if (x > x1) break;
+      x = pix_bits_next(p, x, x1, y0, 0);
+    }
+    return rc;
+  }
   d = MAX(abs(dx), abs(dy));
   for (i = 0, x = x0, y = y0; i <= d; i++) {
     if (d) {
@@ -266,7 +331,7 @@ int num_cross_fine(int x0, int x1, int y0, int y1, pix *p, int cs) {
  *   ToDo: wchar_t cc + matching UTF-8 pattern for nonASCII
  */
 int my_strchr( char *pattern, wchar_t cc ) {
-  char *s1;
+  char *s1, dbuf[DECODE_BUFLEN];
   if (pattern==(char *)NULL) return 0;
   
   /* if (!(cc&0x80)) s1=strchr(pattern,(char)cc);  else */          
@@ -275,7 +340,7 @@ int my_strchr( char *pattern, wchar_t cc ) {
       s1=strstr(pattern,"--"); /* search string -- in pattern */
       if (s1) return 1; break;
     default:
-      s1=strstr(pattern,decode(cc, UTF8)); /* search string cc in pattern */
+      s1=strstr(pattern,decode_r(cc, UTF8, dbuf)); /* search string cc in pattern */
       if (s1) return 1; /* cc simply matches */
       /* single char not found, now check the ranges */
       s1=pattern;
@@ -301,7 +366,7 @@ int my_strchr( char *pattern, wchar_t cc ) {
  */
 
 int setas(struct box *b, char *as, int weight){
-  job_t *job=OCR_JOB;
+  job_t *job=b->p->job;
   int i,j;
   if (b->num_ac > NumAlt || b->num_ac<0) {
     fprintf(stderr,"\nDBG: There is something wrong with setas()!");
@@ -375,12 +440,14 @@ int setas(struct box *b, char *as, int weight){
 /* ToDo: this function will be replaced by a call of setas() later */
 int setac(struct box *b, wchar_t ac, int weight){
   int i,j;
-  job_t *job=OCR_JOB;
+  char dbuf[DECODE_BUFLEN];
+  job_t *job;
   if ((!b) || b->num_ac > NumAlt || b->num_ac<0) {
     fprintf(stderr,"\nDBG: This is a bad call to setac()!");
-    if(b && (job->cfg.verbose & 6)) out_x(b);
+    if(b && (b->p->job->cfg.verbose & 6)) out_x(b);
     b->num_ac=0;
   }
+  job=b->p->job;
   if (ac==0 || ac==UNKNOWN) {
     fprintf(stderr,"\nDBG: setac(0) makes no sense!");
     return 0;
@@ -398,7 +465,7 @@ int setac(struct box *b, wchar_t ac, int weight){
     if (newac == ac) { /* nothing composed */
       if(job->cfg.verbose & 7) 
         fprintf(stderr, "\nDBG %s setac (%d,%d): compose was useless, wac=%d",
-                decode(ac,ASCII), b->x0, b->y0, weight);
+                decode_r(ac,ASCII,dbuf), b->x0, b->y0, weight);
       /* if(job->cfg.verbose & 6) out_x(b); */
     }
     ac = newac;
@@ -566,6 +633,28 @@ int joined(pix *p, int x0, int y0, int x1, int y1, int cs){
  * return the number of steps done */
 int loop(pix *p,int x,int y,int l,int cs,int col, DIRECTION r){ 
   int i=0;
+  if(x>=0 && y>=0 && x<p->x && y<p->y && l>0
+   && (col==0 || col==1) && PIX_BITS_OK(p, cs)){ /* packed plane, v0.53 */
+    switch (r) {
+    case UP:
+      for( ;i<l && y>=0;i++,y--)
+	if( PIX_BIT(p,x,y)^col )
+	  break;
+      break;
+    case DO:
+      for( ;i<l && y<p->y;i++,y++)
+	if( PIX_BIT(p,x,y)^col )
+	  break;
+      break;
+    case LE:
+      i = x - pix_bits_prev(p, x, ((x+1>l) ? x-l+1 : 0), y, !col);
+      break;
+    case RI:
+      i = pix_bits_next(p, x, ((p->x-x>l) ? x+l-1 : p->x-1), y, !col) - x;
+      break;
+    default:;
+    }
+  } else
   if(x>=0 && y>=0 && x<p->x && y<p->y){
     switch (r) {
     case UP:
@@ -611,11 +700,11 @@ int frame_nn(pix *p, int  x,  int  y,
              int *x0, int *x1, int *y0, int *y1,	// enlarge frame
              int cs, int mark,int diag){
 #if 1 /* flood-fill to detect black objects, simple and faster? */
-  int rc = 0, dx, col, maxstack=0; static int overflow=0;
+  int rc = 0, dx, col, maxstack=0, overflow=0;
   int bmax=1024, blen=0, *buf;  /* buffer as replacement for recursion stack */
 
-  /* check bounds */
-  if (outbounds(p, x, y))  return 0;
+  /* check bounds, marks are needed to stop */
+  if (outbounds(p, x, y) || !p->marks)  return 0;
   /* check if already marked (with mark since v0.4) */
   if ((marked(p,x,y)&mark)==mark) return 0;
 
@@ -652,7 +741,7 @@ int frame_nn(pix *p, int  x,  int  y,
     if (x < *x0) *x0 = x;
     /* second go right, mark and get new starting points */ 
     for ( ; x<p->x && (col == ((getpixel(p, x  , y) < cs) ? 0 : 1)) ; x++) {
-      p->p[x + y * p->x] |= (mark & 7);    rc++;  /* mark pixel */
+      put_mark(p, x, y, mark);    rc++;  /* mark pixel */
       /* enlarge frame */
       if (x > *x1) *x1 = x;
       for (dx=-1;dx<2;dx+=2) /* look at upper and lower line */
@@ -685,8 +774,8 @@ int frame_nn(pix *p, int  x,  int  y,
   
   /* debug, ToDo: use info maxstack and pixels for image classification */
   g_debug(fprintf(stderr," maxstack= %4d pixels= %6d",maxstack,rc);)
-  if (overflow==1){
-    overflow|=2;
+  if (overflow && p->job && !(p->job->tmp.warned & 1)){
+    p->job->tmp.warned|=1; /* once per job, was static before v0.53 */
     fprintf(stderr,"# Warning: frame_nn stack oerflow\n");
   }
   free(buf);
@@ -740,7 +829,7 @@ int frame_nn(pix *p, int  x,  int  y,
 	              	&& i == ((getpixel(p, x + j, y) < cs) ? 0 : 1); j += dx) {
 	  if (!((marked(p, x + j, y)&mark)==mark))
 	    rc++;
-	  p->p[x + j + y * p->x] |= (mark & 7);
+	  put_mark(p, x + j, y, mark);
 	}
       }
       /* look to the front of robot */
@@ -780,7 +869,7 @@ int mark_nn(pix * p, int x, int y, int cs, int r) {
     int x0, x1, y0, y1;
     x0 = x1 = x;
     y0 = y1 = y;			// not used
-    return frame_nn(p, x, y, &x0, &x1, &y0, &y1, cs, r, OCR_JOB->tmp.n_run & 1);
+    return frame_nn(p, x, y, &x0, &x1, &y0, &y1, cs, r, p->job->tmp.n_run & 1);
     // using same scheme
   }
 }
@@ -892,7 +981,7 @@ int frame_vector(struct box *box1, int  x,  int  y,
     /* ToDo: store max. abs(rot) ??? for better recognition */
     if (new_x) {
       g_debug(fprintf(stderr,"\nLEV2: markB xy= %3d %3d ", x, y);)
-      p->p[x + y * p->x] |= (mark & 7); /* mark black pixel */
+      put_mark(p, x, y, mark); /* mark black pixel */
     }
 
     /* store a new vector or enlarge the predecessor */
@@ -904,8 +993,10 @@ int frame_vector(struct box *box1, int  x,  int  y,
         /* enlarge steps on big chars getting speedup */
         steps=(box1->y1-box1->y0+box1->x1-box1->x0)/32+1;
       }
-      /* store frame-vector */
-      if (i2<MaxFrameVectors) {
+      /* store frame-vector, enlarge the vector buffer if needed */
+      if (i2<MaxFrameVectors
+       && (i2<box1->max_frame_vectors
+        || box_alloc_vectors(box1, 2*i2+16)==0)) {
         box1->frame_vector[i2][0]=x;
         box1->frame_vector[i2][1]=y;
         /* test if older vector points to the same direction */
@@ -941,7 +1032,7 @@ int frame_vector(struct box *box1, int  x,  int  y,
     if ( outbounds(p, nx, ny) || i1 != ((getpixel(p,nx,ny)<cs) ? 0 : 1) ) {
       if (y==ny && nx>=0 && nx<p->x) { /* if inbound */
         g_debug(fprintf(stderr,"\nLEV2: markW xy= %3d %3d ", nx, ny);)
-        p->p[nx + ny * p->x] |= (mark & 7); /* mark white pixel */
+        put_mark(p, nx, ny, mark); /* mark white pixel */
       }
       /* rotate left 90 or 45 degrees */
       d=(d+2-diag) & 7; rot+=2-diag;
@@ -975,6 +1066,8 @@ int frame_vector(struct box *box1, int  x,  int  y,
   if (i2-i2o>1) { 
     i2--; rc--; box1->num_frame_vectors[ box1->num_frames-1 ]=i2;
   }
+  /* free unused vector memory */
+  box_alloc_vectors(box1, box1->num_frame_vectors[ box1->num_frames-1 ]);
   /* output break conditions */
   g_debug(fprintf(stderr,"\nLEV2 o= %3d %3d  xy %3d %3d  r=%d v=%d",ox,oy,x,y,rot,vol);)
   /* rc=1 for a single point, rc=2 for a two pixel sized point */
@@ -985,12 +1078,16 @@ int frame_vector(struct box *box1, int  x,  int  y,
 
 
 
-/* clear lowest 3 (marked) bits (they are used for marking) */ 
-void clr_bits(pix * p, int x0, int x1, int y0, int y1) {
+/* clear the scan marks (lowest 3 bits before v0.53), 0 or -1
+ *  the whole image is cleared in O(1) by a new epoch of p->marks */
+int clr_bits(pix * p, int x0, int x1, int y0, int y1) {
   int x, y;
+  if (!p->marks || (x0 <= 0 && y0 <= 0 && x1 >= p->x-1 && y1 >= p->y-1))
+    return pix_marks_init(p);
   for ( y=y0; y <= y1; y++)
     for ( x=x0; x <= x1; x++)
-      p->p[x+y*p->x] &= ~7;
+      p->marks[x+y*p->x] = 0;  /* epoch 0 is never valid */
+  return 0;
 }
 
 /* look for white holes surrounded by black points
@@ -1014,7 +1111,8 @@ int num_hole(int x0, int x1, int y0, int y1, pix * p, int cs, holes_t *holes) {
     fprintf( stderr, "\nFATAL: malloc(%d) failed, skip num_hole", dx*dy );
     return 0;
   }
-  if (copybox(p, x0, y0, dx, dy, &b, dx * dy))
+  if (copybox(p, x0, y0, dx, dy, &b, dx * dy)
+   || clr_bits(&b, 0, b.x - 1, 0, b.y - 1))
     { free(b.p); return -1;}
 
   // printf(" num_hole(");
@@ -1047,7 +1145,7 @@ int num_hole(int x0, int x1, int y0, int y1, pix * p, int cs, holes_t *holes) {
             int x0, x1, y0, y1, i, j;
             x0 = x1 = x;
             y0 = y1 = y;			// not used
-            hole_size=frame_nn(&b, x, y, &x0, &x1, &y0, &y1, cs, AT, OCR_JOB->tmp.n_run & 1);
+            hole_size=frame_nn(&b, x, y, &x0, &x1, &y0, &y1, cs, AT, b.job->tmp.n_run & 1);
             // store hole for future use, num is initialized with 0
  	    if (hole_size > 1 || dx * dy <= 40){
  	      num_holes++;
@@ -1073,6 +1171,7 @@ int num_hole(int x0, int x1, int y0, int y1, pix * p, int cs, holes_t *holes) {
           }
 #endif
 	}
+  pix_marks_free(&b);
   free(b.p);
   // printf(")=%d",num_holes);
   return num_holes;
@@ -1091,7 +1190,8 @@ int num_obj(int x0, int x1, int y0, int y1, pix * p, int cs) {
     fprintf( stderr, "\nFATAL: malloc(%d) failed, skip num_obj",(x1-x0+1)*(y1-y0+1) );
     return 0;
   }
-  if (copybox(p, x0, y0, x1 - x0 + 1, y1 - y0 + 1, &b, (x1-x0+1) * (y1-y0+1)))
+  if (copybox(p, x0, y0, x1 - x0 + 1, y1 - y0 + 1, &b, (x1-x0+1) * (y1-y0+1))
+   || clr_bits(&b, 0, b.x - 1, 0, b.y - 1))
     { free(b.p); return -1; }
   // --- mark black-points connected with neighbours
   for (x = 0; x < b.x; x++)
@@ -1101,6 +1201,7 @@ int num_obj(int x0, int x1, int y0, int y1, pix * p, int cs) {
 	  rc++;
 	  mark_nn(&b, x, y, cs, AT);
 	}
+  pix_marks_free(&b);
   free(b.p);
   return rc;
 }
@@ -1173,7 +1274,7 @@ int distance( pix *p1, struct box *box1,
      else      rbad++;    
    }
    if(rgood+rbad) rc= (100*rbad+(rgood+rbad-1))/(rgood+rbad); else rc=99;
-   if(rc<10 && OCR_JOB->cfg.verbose & 7){
+   if(rc<10 && p1->job->cfg.verbose & 7){
      fprintf(stderr,"\n#  distance rc=%d good=%d bad=%d",rc,rgood,rbad);
 //     out_x(box1);out_x(box2);
    }
@@ -1189,10 +1290,11 @@ wchar_t whatletter(struct box *box1, int cs, int nrun){
    wchar_t um=SPACE;			// umlaut? '" => modifier
    pix *p=box1->p;   // whole image
    int	x,y,dots,xa,ya,x0,x1,y0,y1,dx,dy,i;
+   char dbuf[DECODE_BUFLEN];
    pix b;            // box
    struct box bbuf=*box1;  // restore after modifikation!
 
-   if (box1->num_ac>0 && box1->wac[0]>=OCR_JOB->cfg.certainty && bc==UNKNOWN) {
+   if (box1->num_ac>0 && box1->wac[0]>=p->job->cfg.certainty && bc==UNKNOWN) {
       bc=box1->tac[0];
    }
    // if (bc!=UNKNOWN) return bc;
@@ -1252,9 +1354,9 @@ wchar_t whatletter(struct box *box1, int cs, int nrun){
    if(dx<1 || dy<1) return bc; /* should not happen */
    b.p = (unsigned char *) malloc( dx * dy );
    if (!b.p) fprintf(stderr,"Warning: malloc failed L%d\n",__LINE__);
-   if( copybox(p,x0,y0,dx,dy,&b,dx*dy) ) 
+   if( copybox(p,x0,y0,dx,dy,&b,dx*dy) 
+    || clr_bits(&b,0,b.x-1,0,b.y-1) ) /* marks of the copy, v0.53 */
      { free(b.p); return bc; }
-   // clr_bits(&b,0,b.x-1,0,b.y-1);
    // ------ use diagonal too (only 2nd run?) 
    /* following code failes on ! and ?  obsolete if vectors are used
       ToDo:
@@ -1294,7 +1396,7 @@ wchar_t whatletter(struct box *box1, int cs, int nrun){
    bc=ocr0(box1,&b,cs);
 
    /* ToDo: try to change pixels near cs?? or melt? */
-   if (box1->num_ac>0 && box1->wac[0]>=OCR_JOB->cfg.certainty && bc==UNKNOWN) {
+   if (box1->num_ac>0 && box1->wac[0]>=p->job->cfg.certainty && bc==UNKNOWN) {
      bc=box1->tac[0];
    }
 
@@ -1302,10 +1404,10 @@ wchar_t whatletter(struct box *box1, int cs, int nrun){
      wchar_t newbc;
      newbc = compose(bc, um );
      if (newbc == bc) { /* nothing composed */
-       if(OCR_JOB->cfg.verbose & 7) 
+       if(p->job->cfg.verbose & 7) 
          fprintf(stderr, "\nDBG whatletter: compose(%s) was useless (%d,%d)",
-           decode(bc,ASCII), box1->x0, box1->y0);
-       // if(OCR_JOB->cfg.verbose & 6) out_x(box1);
+           decode_r(bc,ASCII,dbuf), box1->x0, box1->y0);
+       // if(p->job->cfg.verbose & 6) out_x(box1);
      }
      bc = newbc;
    }
@@ -1314,6 +1416,7 @@ wchar_t whatletter(struct box *box1, int cs, int nrun){
    box1->x1=bbuf.x1; box1->y1=bbuf.y1;
 //   if (box1->c==UNKNOWN) out_b(box1,&b,0,0,dx,dy,cs); // test
 
+   pix_marks_free(&b);
    free(b.p);
    return bc;
 }
@@ -1327,9 +1430,8 @@ wchar_t whatletter(struct box *box1, int cs, int nrun){
 **        divide boxes? or for bold fonts (min-xpixels bigger 1?)
 */
 int scan_boxes( job_t *job, pix *p ){
-  int x, y, nx, cs, rc, ds;
+  int x, y, nx, cs, rc, ds, fast;
   struct box *box3;
-  //  job_t *job=OCR_JOB; /* fixme */
 
   if (job->cfg.verbose)
     fprintf(stderr,"# scan_boxes");
@@ -1337,12 +1439,18 @@ int scan_boxes( job_t *job, pix *p ){
   cs = job->cfg.cs;
   job->res.sumX = job->res.sumY = job->res.numC = 0;
 
-  /* clear the lowest bits of each pixel, later used as "scanned"-marker */
+  /* clear the "scanned"-markers of each pixel (p->marks since v0.53) */
   /* so boxes can overlap like bold "To" (proportional-font) */
-  clr_bits( p, 0, p->x - 1, 0, p->y - 1);
-
-  for (y=0; y < p->y; y++)
-    for (x=0; x < p->x; x++)  // ds = direction to go 2=left 6=right
+  if (clr_bits( p, 0, p->x - 1, 0, p->y - 1)) return 0;
+
+  /* a transition starts at a black pixel, skip white 8x8 blocks and
+     words of p->bits (same boxes), v0.53 */
+  fast = PIX_BITS_OK(p, cs);
+  for (y=0; y < p->y; y++) {
+   if (fast && !(y & 7) && pix_pyr_empty(p, PIX_PYR, 0, p->x-1, y, y+7)) {
+     y += 7; continue; } /* 8 white rows */
+   for (x=0; x < p->x; x++) { // ds = direction to go 2=left 6=right
+    if (fast && (x = pix_black_next(p, x, p->x-1, y)) >= p->x) break;
     for (ds=2; ds<7; ds+=4) { // NO - dust of size 1 is not removed !!!
       nx=x+((ds==2)?-1:+1);
       if (nx<0 || nx>=p->x) continue; /* out of image, ex: recframe */
@@ -1353,7 +1461,7 @@ int scan_boxes( job_t *job, pix *p ){
       /* non-marked b/w-transition found, start boxing connected pixels */
       /* check (and mark) only horizontal b/w transitions */
       // --- insert new box in list
-      box3 = (struct box *)malloc_box(NULL);
+      box3 = (struct box *)box_pool_get(&job->tmp.boxpool, NULL);
       box3->x0=box3->x1=box3->x=x;
       box3->y0=box3->y1=box3->y=y;
       box3->num_frames=0;
@@ -1389,7 +1497,10 @@ int scan_boxes( job_t *job, pix *p ){
       list_app(&(job->res.boxlist), box3); 	// append to list
       // ToDo: debug
       // if (job->cfg.verbose && box3->y0==29) out_x(box3);
+    }
+   }
   }
+  pix_marks_free(p); /* only the boxes are scanned from now on */
   if(job->res.numC){
     if (job->cfg.verbose)
       fprintf(stderr," nC= %3d avD= %2d %2d\n",job->res.numC,
@@ -1461,18 +1572,21 @@ void measure_pitch( job_t *job ){     /* word spacing */
       mono_em_max=2047, // minimum distance left side of two chars
       d1l, d1r; // left-left and right-right distance of 2 chars
   int d1, d2; // temporary vars, d1l + d1r sorted
+  int l2, i2; /* line and box index of job->res.lines.boxes */
   struct box *box2, *pre1=NULL, *pre2=NULL;
 
   if(job->cfg.verbose){ fprintf(stderr,"# check for word pitch"); }
+  tlines_set_boxes(job); /* boxlist is sorted by line and x0 */
   for (l1=0; l1<job->res.lines.num; l1++)
   { /* 0 means all lines */
     if(job->cfg.verbose){ fprintf(stderr,"\n#  line %2d\n# ...",l1); }
     numdists = 0;  /* clear distance lists */
     monospaced=1; mono_em_min=0;  mono_em_max=2047; // reset, 2010-09-28
     char_width_min=1023; char_width_max=0; // reset, 2010-09-28
-    for_each_data(&(job->res.boxlist)) {
-      box2 = (struct box *)list_get_current(&(job->res.boxlist));
-      if (l1>0 && box2->line!=l1) continue; /* ignore other lines */
+    /* v0.53: only the boxes of line l1, all lines in list order for l1=0 */
+    for (l2=((l1)?l1:0); l2<((l1)?l1+1:job->res.lines.num); l2++)
+    for (i2=0; i2<job->res.lines.boxes[l2].num; i2++) {
+      box2 = job->res.lines.boxes[l2].box[i2];
       /* ignore dots and pictures (min. font is 4x6) */
       if (box2->y1 - box2->y0 + 1 < 4 || box2->c==PICTURE) pre2=pre1=NULL;
       if (!pre1) { pre1=box2; continue; } /* we need a predecessor */
@@ -1634,7 +1748,7 @@ void measure_pitch( job_t *job ){     /* word spacing */
         }
       }
       pre2 = pre1; pre1 = box2;
-    } end_for_each(&(job->res.boxlist));
+    } /* boxes of the line */
     
     if (job->cfg.verbose)
       fprintf(stderr, " L%02d num_gaps= %2d x_width= %2d - %2d"
@@ -1679,7 +1793,7 @@ void measure_pitch( job_t *job ){     /* word spacing */
       //   mean gapdiff? gap[n-1-i]-gap[0+i] until gapdiff=0, skip table gaps
       // 2010-09-28 check until end of table, because old bad wide gaps are 
       //     no more added to the table
-      for (ni=ni_min=1024,max=0,i=((numdists<8)?0:numdists/2+1);
+      for (ni=ni_min=1024,max=0,i=((numdists<8)?1:numdists/2+1); // i>0, v0.53
                                 i<numdists;i++) {
         if (pdists[i]<=char_width_min/3) continue; // JS-2010-09
         if (pdists[i]> char_width_max*2) {
@@ -1763,10 +1877,9 @@ void measure_pitch( job_t *job ){     /* word spacing */
  *    objects
  * ToDo: count only frames of invers spin? do we need sorted list here? -> no
  */
-int count_subboxes( pix *pp ){
+int count_subboxes( job_t *job, pix *pp ){
   int ii=0, num_mini=0, num_same=0, cnt=0;
   struct box *box2,*box4;
-  job_t *job=OCR_JOB; /* fixme */
   progress_counter_t *pc = NULL;
   if (job->cfg.verbose) { fprintf(stderr,"# count subboxes\n# ..."); }
   
@@ -1814,15 +1927,14 @@ int count_subboxes( pix *pp ){
    Dont add dust to a char!  (ij-dots later)
    lines are not detected yet
 */
-int glue_holes_inside_chars( pix *pp ){
+int glue_holes_inside_chars( job_t *job, pix *pp ){
   int ii, x0, y0, x1, y1, cnt=0,
       glued_same=0, glued_holes=0;
   struct box *box2, *box4;
-  job_t *job=OCR_JOB; /* fixme */
   progress_counter_t *pc = NULL;
   // int cs=job->cfg.cs;
   {
-    count_subboxes( pp ); /* move to pgm2asc() later */
+    count_subboxes( job, pp ); /* move to pgm2asc() later */
     
     pc = open_progress(job->res.boxlist.n,"glue_holes_inside_chars");
     if (job->cfg.verbose)
@@ -1916,18 +2028,18 @@ int glue_holes_inside_chars( pix *pp ){
 */
 int glue_broken_chars( job_t *job, pix *pp ){
   int ii, y, cs, x0, y0, x1, y1, cnt=0,
-      num_frags=0, glued_frags=0, glued_hor=0,
+      num_frags=0, glued_frags=0, glued_hor=0, i, n, r, seq, nnb=0,
       do_join=0; /* 1..n means we have a reason to join two objects to one */
 //  for better debugging:        upper_dots(umlauts) lower_dots ...
 // char *(join_reason)[5]={"no","\"A\"Uij\%","!?;\%","=:;","'',,"}; 2018-09
   char *(join_reason)[5]={"no", "\"A\"Uij%%", "!?;%%", "=:;", "'',,"};
 //             do_join:    0      1            2        3       4            
-  struct box *box2, *box4;
-  // job_t *job=OCR_JOB; /* fixme */
+  struct box *box2, *box4, **nb=NULL; /* nb = boxes near box2 */
   progress_counter_t *pc = NULL;
   cs=job->cfg.cs;
   {
-    count_subboxes( pp ); /* move to pgm2asc() later */
+    count_subboxes( job, pp ); /* move to pgm2asc() later */
+    box_grid_build(&job->tmp.boxgrid, job);
     
     pc = open_progress(job->res.boxlist.n,"glue_broken_chars");
     if (job->cfg.verbose)
@@ -1962,21 +2074,30 @@ int glue_broken_chars( job_t *job, pix *pp ){
         box4=NULL;
         num_frags++;   /* count for debugging */
         // get the [2nd] next x-nearest box in the same line
-        for_each_data(&(job->res.boxlist)) {
-  	  box4=(struct box *)list_get_current(&(job->res.boxlist));
-          if (box4 == box2  ||  box4->c == PICTURE) continue;
-          /* 0.42 speed up for background pixel pattern, box4 to small */
-          if ( box4->x1 - box4->x0 + 1 < x1-x0+1
-            && box4->y1 - box4->y0 + 1 < y1-y0+1 ) continue;
-          // have in mind that line number may be wrong for dust 
-          if (box4->line>=0 && box2->line>=0 && box4->line==box2->line)
-          {
-             if (!box5) box5=box4;
-             if ( abs(box4->x0 + box4->x1 - 2*box2->x0)
-                 <abs(box5->x0 + box5->x1 - 2*box2->x0))
-               { /* box6=box5; next-nearest box */ box5=box4; }
-  	  }
-        } end_for_each(&(job->res.boxlist));
+        //   v0.53 search in a growing column around x0, the middle of
+        //   the nearest box must be within the column
+        for (r=job->res.avX+1; ; r*=2) {
+          n = box_grid_query(&job->tmp.boxgrid, box2->x0-r, 0,
+                             box2->x0+r, pp->y-1, &nb, &nnb);
+          box5=NULL;
+          for (i=0; i<n; i++) {
+            box4=nb[i];
+            if (box4 == box2  ||  box4->c == PICTURE) continue;
+            /* 0.42 speed up for background pixel pattern, box4 to small */
+            if ( box4->x1 - box4->x0 + 1 < x1-x0+1
+              && box4->y1 - box4->y0 + 1 < y1-y0+1 ) continue;
+            // have in mind that line number may be wrong for dust 
+            if (box4->line>=0 && box2->line>=0 && box4->line==box2->line)
+            {
+               if (!box5) box5=box4;
+               if ( abs(box4->x0 + box4->x1 - 2*box2->x0)
+                   <abs(box5->x0 + box5->x1 - 2*box2->x0))
+                 { /* box6=box5; next-nearest box */ box5=box4; }
+            }
+          }
+          if (box5 && abs(box5->x0 + box5->x1 - 2*box2->x0) <= 2*r) break;
+          if (box2->x0-r <= 0 && box2->x0+r >= pp->x-1) break; /* all */
+        }
 	box4=box5; // next nearest box within the same line
       	if (box4) {
           // do not glue "%^" in 0811qemu2.png 2010-09-28
@@ -2072,8 +2193,9 @@ int glue_broken_chars( job_t *job, pix *pp ){
       // horizontally broken w' K'
       if(     2*y1  <   (box2->m3+box2->m2) )
       if( 2*(y1-y0) <   (box2->m3+box2->m2) )	// fragment
-      for_each_data(&(job->res.boxlist)) {
-	box4=(struct box *)list_get_current(&(job->res.boxlist));
+      for (n = box_grid_query(&job->tmp.boxgrid, x0-1, 0, x0-1, pp->y-1,
+                              &nb, &nnb), i=0; i<n; i++) {
+	box4=nb[i];
         if (box4!=box2 && box4->c != PICTURE)
 	{
           if( box4->line>=0 && box4->line==box2->line
@@ -2093,11 +2215,17 @@ int glue_broken_chars( job_t *job, pix *pp ){
             y0 = box2->y0; y1 = box2->y1;
             job->res.numC--; ii++;	// remove
             glued_hor++;
+            seq=box4->grid_seq;
 	    list_del(&(job->res.boxlist), box4);
 	    free_box(box4);
+            /* x0 is changed, continue with the new neighbours after box4 */
+            n = box_grid_query(&job->tmp.boxgrid, x0-1, 0, x0-1, pp->y-1,
+                               &nb, &nnb);
+            for (i=0; i<n; i++) if (nb[i]->grid_seq > seq) break;
+            i--; /* i++ of the loop */
           }
         }
-      } end_for_each(&(job->res.boxlist));
+      }
 
       // horizontally broken n h	(h=l_)		v0.2.5 Jun00
       if( abs(box2->m2-y0)<=(y1-y0)/8 )
@@ -2107,8 +2235,9 @@ int glue_broken_chars( job_t *job, pix *pp ){
       if(    get_bw((3*x0+x1)/4,(3*x0+x1)/4,(3*y0+y1)/4,y1,pp,cs,1) == 0)
       if(    get_bw(x0,(3*x0+x1)/4,(3*y0+y1)/4,(y0+3*y1)/4,pp,cs,1) == 0)
       if(    get_bw(x0,         x0,         y0,(3*y0+y1)/4,pp,cs,1) == 1)
-      for_each_data(&(job->res.boxlist)) {
-	box4=(struct box *)list_get_current(&(job->res.boxlist));
+      for (n = box_grid_query(&job->tmp.boxgrid, x0-2, 0, x0+1, pp->y-1,
+                              &nb, &nnb), i=0; i<n; i++) {
+	box4=nb[i];
       	if (box4!=box2 && box4->c != PICTURE)
 	{
           if( box4->line>=0 && box4->line==box2->line
@@ -2128,12 +2257,20 @@ int glue_broken_chars( job_t *job, pix *pp ){
             y0 = box2->y0; y1 = box2->y1;
             job->res.numC--; ii++;	// remove
             glued_hor++;
+            seq=box4->grid_seq;
 	    list_del(&(job->res.boxlist), box4);
 	    free_box(box4);
+            /* x0 is changed, continue with the new neighbours after box4 */
+            n = box_grid_query(&job->tmp.boxgrid, x0-2, 0, x0+1, pp->y-1,
+                               &nb, &nnb);
+            for (i=0; i<n; i++) if (nb[i]->grid_seq > seq) break;
+            i--; /* i++ of the loop */
           }
       	}
-      } end_for_each(&(job->res.boxlist));
+      }
     } end_for_each(&(job->res.boxlist)); 
+    box_grid_free(&job->tmp.boxgrid);
+    if (nb) free(nb);
     if (job->cfg.verbose)
       fprintf(stderr," joined: %3d fragments (found %3d), %3d rest, nC= %d\n",
         glued_frags, num_frags, glued_hor, job->res.numC);
@@ -2150,10 +2287,10 @@ int glue_broken_chars( job_t *job, pix *pp ){
 */
   // ---- analyse boxes, compare chars, compress picture ------------
   // ToDo: - error-correction only on large chars! 
-int find_same_chars( pix *pp){
+int find_same_chars( job_t *job, pix *pp){
   int i,k,d,cs,dist,n1,dx; struct box *box2,*box3,/* *box4, */ *box5;
+  Element *e3;
   pix p=(*pp);
-  job_t *job=OCR_JOB; /* fixme */
   cs=job->cfg.cs;
   {
     if(job->cfg.verbose)fprintf(stderr,"# packing");
@@ -2165,8 +2302,8 @@ int find_same_chars( pix *pp){
 
       if(job->cfg.verbose)fprintf(stderr,"\r# packing %5d",i);
       if( dx>3 )
-      for(box3=(struct box *)list_next(&(job->res.boxlist),box2);box3;
-	  box3=(struct box *)list_next(&(job->res.boxlist),box3)) {
+      for(e3=list_get_cur_element(&(job->res.boxlist))->next;
+          (box3=(struct box *)e3->data); e3=e3->next) {
         if(box2->num!=box3->num){
           int d=distance(&p,box2,&p,box3,cs);
           if ( d<dist ) { dist=d; /* box4=box3; */ }	// best fit
@@ -2192,17 +2329,16 @@ int find_same_chars( pix *pp){
       struct box *box3,*box4;
       int j,dist;
       box2=(struct box *)list_get_current(&(job->res.boxlist));
-      for(box3=(struct box *)list_get_header(&(job->res.boxlist));
-          box3!=box2 && box3!=NULL;
-	  box3=(struct box *)list_next(&(job->res.boxlist), box3))
+      for(e3=job->res.boxlist.start.next;
+          (box3=(struct box *)e3->data)!=box2 && box3!=NULL; e3=e3->next)
         if(box3->num==box2->num)break;
       if(box3!=box2 && box3!=NULL)continue;
       i++;
       // count number of same chars
       dist=0;box4=box2;
       
-      for(box3=box2,j=0;box3;
-          box3=(struct box *)list_next(&(job->res.boxlist), box3)) {
+      for(e3=list_get_cur_element(&(job->res.boxlist)),j=0;
+          (box3=(struct box *)e3->data); e3=e3->next) {
 	if(box3->num==box2->num){
           j++;
           d=distance(&p,box2,&p,box3,cs);
@@ -2230,12 +2366,11 @@ int find_same_chars( pix *pp){
 ** call the first engine for all boxes and set box->c=result;
 **
 */
-int char_recognition( pix *pp, int mo){
+int char_recognition( job_t *job, pix *pp, int mo){
   int i,ii,ni,cs,x0,y0,x1,y1;
   struct box *box2;
   progress_counter_t *pc;
   wchar_t cc;
-  job_t *job=OCR_JOB; /* fixme */
   cs=job->cfg.cs;
   // ---- analyse boxes, find chars ---------------------------------
   if (job->cfg.verbose) 
@@ -2294,24 +2429,55 @@ int char_recognition( pix *pp, int mo){
 }
 
 
+/* boxes sorted by width for compare_unknown_with_known_chars() */
+struct box_by_width_s { struct box *box; int dx, seq; };
+
+static int box_by_width_compare(const void *a, const void *b) {
+  const struct box_by_width_s *ba = (const struct box_by_width_s *)a,
+                              *bb = (const struct box_by_width_s *)b;
+  if (ba->dx != bb->dx) return ba->dx - bb->dx;
+  return ba->seq - bb->seq;
+}
+
+static int box_seq_compare(const void *a, const void *b) {
+  return (*(const struct box_by_width_s **)a)->seq
+       - (*(const struct box_by_width_s **)b)->seq;
+}
+
 /*
 ** compare unknown with known chars,
 ** very similar to the find_similar_char_function but here only to
 ** improve the result
+** v0.53: distance() returns 100% for chars of different size, so only
+**  chars of similar width are compared (table sorted by width),
+**  this is not a spatial neighbourhood, therefore boxgrid is not used
 */
-int compare_unknown_with_known_chars(pix * pp, int mo) {
-  job_t *job=OCR_JOB; /* fixme */
-  int i, cs = job->cfg.cs, dist, d, ad, wac, ni, ii;
+int compare_unknown_with_known_chars(job_t *job, pix * pp, int mo) {
+  int i, cs = job->cfg.cs, dist, d, ad, wac, ni, ii, k, n, nc, dx, lo, hi;
   struct box *box2, *box3, *box4;
+  struct box_by_width_s *bw=NULL, **bws=NULL;
   progress_counter_t *pc=NULL;
   wchar_t bc;
   i = ii = 0; // ---- -------------------------------
   if (job->cfg.verbose)
     fprintf(stderr, "# try to compare unknown with known chars !(mode&8)");
-  if (!(mo & 8))
+  ni=0;
+  for_each_data(&(job->res.boxlist)) { ni++; } end_for_each(&(job->res.boxlist));
+  if (!(mo & 8) && ni) {
+    bw = (struct box_by_width_s *)malloc(ni*sizeof(struct box_by_width_s));
+    bws = (struct box_by_width_s **)malloc(ni*sizeof(struct box_by_width_s *));
+    if (!bw || !bws) fprintf(stderr," malloc failed\n");
+  }
+  if (bw && bws)
   {
-    ii=ni=0;
-    for_each_data(&(job->res.boxlist)) { ni++; } end_for_each(&(job->res.boxlist));
+    ii=0;
+    n=0;
+    for_each_data(&(job->res.boxlist)) {
+      bw[n].box = (struct box *)list_get_current(&(job->res.boxlist));
+      bw[n].dx  = bw[n].box->x1 - bw[n].box->x0 + 1;
+      bw[n].seq = n;  n++;
+    } end_for_each(&(job->res.boxlist));
+    qsort(bw, n, sizeof(struct box_by_width_s), box_by_width_compare);
     pc = open_progress(ni,"compare_chars");
     for_each_data(&(job->res.boxlist)) {
       box2 = (struct box *)list_get_current(&(job->res.boxlist)); ii++;
@@ -2320,8 +2486,17 @@ int compare_unknown_with_known_chars(pix * pp, int mo) {
 	  box4 = (struct box *)list_get_header(&(job->res.boxlist));;
 	  dist = 1000;		/* 100% maximum */
 	  bc = UNKNOWN;		/* best fit char */
-	  for_each_data(&(job->res.boxlist)) {
-	    box3 = (struct box *)list_get_current(&(job->res.boxlist));
+	  /* widths accepted by distance(), |dx-dx2| <= 1+max(dx,dx2)/16 */
+	  dx = box2->x1 - box2->x0 + 1;
+	  lo = dx - 2 - dx/16;
+	  hi = 16*(dx+1)/15 + 1;
+	  for (k=0, d=n; k<d; ) { /* first entry with width >= lo */
+	    if (bw[(k+d)/2].dx < lo) k=(k+d)/2+1; else d=(k+d)/2;
+	  }
+	  for (nc=0; k<n && bw[k].dx<=hi; k++) bws[nc++]=&bw[k];
+	  qsort(bws, nc, sizeof(struct box_by_width_s *), box_seq_compare);
+	  for (k=0; k<nc; k++) {  /* in list order */
+	    box3 = bws[k]->box;
             wac=((box3->num_ac>0)?box3->wac[0]:100);	    
 	    if (box3 == box2 || box3->c == UNKNOWN
                              || wac<job->cfg.certainty) continue;
@@ -2330,7 +2505,7 @@ int compare_unknown_with_known_chars(pix * pp, int mo) {
 	    if (d < dist) {
 		dist = d;  bc = box3->c;  box4 = box3;
 	    }
-	  } end_for_each(&(job->res.boxlist));
+	  }
 	  if (dist < 10) {
             /* sureness can be maximal of box3 */
 	    if (box4->num_ac>0) ad = box4->wac[0];
@@ -2354,6 +2529,8 @@ int compare_unknown_with_known_chars(pix * pp, int mo) {
     } end_for_each(&(job->res.boxlist));
     close_progress(pc);
   }
+  if (bws) free(bws);
+  if (bw) free(bw);
   if (job->cfg.verbose)
     fprintf(stderr, " - found %d (nC=%d)\n", i, ii);
   return 0;
@@ -2374,9 +2551,10 @@ int compare_unknown_with_known_chars(pix * pp, int mo) {
 //  Todo: tmp08/gocr0801_bad5.jpg double-touching-"ke"= 2 holes!
 //        middle hole must be splitted to left and right char, ToDo18
 */
-int  try_to_divide_boxes( pix *pp, int mo){
+int  try_to_divide_boxes( job_t *job, pix *pp, int mo){
   struct box *box2, boxa, boxb;
-  job_t *job=OCR_JOB; /* fixme */
+  frame_vector_t *fva=NULL, *fvb=NULL; /* vectors of boxa, boxb */
+  int nfva=0, nfvb=0;
   int cs=job->cfg.cs, ad=100,
       a2[8], ar, // certainty of each part, ar = product of all certainties
       cbest;  // best certainty, skip search of certainty<cbest-1 for speed
@@ -2386,6 +2564,7 @@ int  try_to_divide_boxes( pix *pp, int mo){
   int x0, x1, y0, y1,
       xi[8+1]; // cutting positions
   int i, ii, i1, i2, n1, dx; // dy, dx;
+  char dbuf[DECODE_BUFLEN];
   // pix p=(*pp); // remove!
   if (job->cfg.verbose)
     fprintf(stderr,"# try to divide unknown chars !(mode&16)");
@@ -2419,6 +2598,8 @@ int  try_to_divide_boxes( pix *pp, int mo){
              x0, y0, x1-x0+1, y1-y0+1, i1); }
         if (i1>(x1-x0-1)/4) {
           i=0; boxa=*box2;   // copy contents, ToDo: reset ac-list (in cut_box?)
+          boxa.frame_vector=box_copy_vectors(box2, &fva, &nfva);
+          if (!boxa.frame_vector) continue;
           boxa.x=x0; boxa.y=y0;        // obsolete? mark pixel, overlap?
           boxa.x0=xi[i]=x0;boxa.x1=xi[i+1]=x0+i1-1;  // new horizontal box range   
           cut_box(&boxa); boxa.num_ac=0;  // ToDo: add box2 as src argument?
@@ -2428,8 +2609,10 @@ int  try_to_divide_boxes( pix *pp, int mo){
           { setac(&boxa,ci[i],a2[i]=99);
               if ((job->cfg.verbose&2)) {
                DBG(fprintf(stderr,"\nDBG %s set split certainty 99",\
-               decode(ci[0],ASCII))); }}
+               decode_r(ci[0],ASCII,dbuf))); }}
           i++; boxb=*box2;  // try rest if it has to be split again
+          boxb.frame_vector=box_copy_vectors(box2, &fvb, &nfvb);
+          if (!boxb.frame_vector) continue;
           boxb.x=xi[i]+1; boxb.y=y0;
           boxb.x0=xi[i]+1;boxb.x1=xi[i+1]=box2->x1;
           cut_box(&boxb); boxb.num_ac=0;  
@@ -2438,7 +2621,7 @@ int  try_to_divide_boxes( pix *pp, int mo){
           { char buf[8]=""; setac(&boxb,ci[i],a2[i]=99);
               if ((job->cfg.verbose&2)) {
               DBG(fprintf(stderr,"\nDBG %s set split certainty 99",\
-               decode(ci[1],ASCII)));}
+               decode_r(ci[1],ASCII,dbuf)));}
             buf[0]=ci[0];buf[1]=ci[1];buf[2]=0;
             ar=a2[1]; // not final, just testing
             if (buf[0]) setas(box2,buf,ar); }
@@ -2591,6 +2774,8 @@ int  try_to_divide_boxes( pix *pp, int mo){
             fprintf(stderr,"\n# try to split, newbox[%d].x= %2d ... %2d "
                            "dy= %d ", i, xi[i]-x0, xi[i+1]-x0, y1-y0+1);
           boxa=*box2;	// copy contents, ToDo: reset ac-list (in cut_box?)
+          boxa.frame_vector=box_copy_vectors(box2, &fva, &nfva);
+          if (!boxa.frame_vector) continue;
           boxa.x=xi[i]; boxa.y=y0;        // obsolete? mark pixel, overlap?
           boxa.x0=xi[i];boxa.x1=xi[i+1];  // new horizontal box range
           // ToDo: vector-version cut at 2vec near xi, allow dx/8 overlapp!
@@ -2623,6 +2808,8 @@ int  try_to_divide_boxes( pix *pp, int mo){
             fprintf(stderr,"\n try end split [%d].x=%d [%d].x=%d ",
                            i, xi[i]-x0, i+1, xi[i+1]-x0);
           boxb=*box2;  // try rest if it has to be split again
+          boxb.frame_vector=box_copy_vectors(box2, &fvb, &nfvb);
+          if (!boxb.frame_vector) continue;
           boxb.x=xi[i]+1; boxb.y=y0;
           boxb.x0=xi[i]+1;boxb.x1=xi[i+1];
           cut_box(&boxb); boxb.num_ac=0;
@@ -2635,7 +2822,7 @@ int  try_to_divide_boxes( pix *pp, int mo){
             fprintf(stderr,"\n split at/to: ");
             for (ii=0;ii<=i;ii++)
             fprintf(stderr,"  %2d %s (%3d)", xi[ii+1]-x0,
-              decode(ci[ii],ASCII), a2[ii]);
+              decode_r(ci[ii],ASCII,dbuf), a2[ii]);
             fprintf(stderr,"\n");
           }
 	  // boxa..c changed!!! dots should be modified!!!
@@ -2646,7 +2833,7 @@ int  try_to_divide_boxes( pix *pp, int mo){
           for (buf[0]=0,ar=ad,ii=0;ii<=i;ii++) {
             ar=a2[ii]*ar/100;  // multiply all probabilities
             if (i>0 && ci[ii]=='n' && ci[ii-1]=='r') ar--; // m == rn
-            strncat(buf,decode(ci[ii],job->cfg.out_format),20);
+            strncat(buf,decode_r(ci[ii],job->cfg.out_format,dbuf),20);
           }
 
           if (ar>cbest) cbest=ar; // best (highest) certainty found
@@ -2661,6 +2848,8 @@ int  try_to_divide_boxes( pix *pp, int mo){
       } /* divide box */
     } /* unknown box dx>5 */
   } end_for_each(&(job->res.boxlist));
+  if (fva) free(fva);
+  if (fvb) free(fvb);
   if (job->cfg.verbose) fprintf(stderr,", numC %d\n",job->res.numC); 
   return 0;
 } /* try_to_divide_boxes */
@@ -2668,11 +2857,12 @@ int  try_to_divide_boxes( pix *pp, int mo){
 /*
 // ---- divide vertical glued boxes (ex: g above T);
 */
-int  divide_vert_glued_boxes( pix *pp, int mo){
-  struct box *box2,*box3,*box4;
-  job_t *job=OCR_JOB; /* fixme */
-  int y0,y1,y,dy,flag_found,dx;
+int  divide_vert_glued_boxes( job_t *job, pix *pp, int mo){
+  struct box *box2,*box3,*box4, **nb=NULL; /* nb = boxes near box2 */
+  int y0,y1,y,dy,flag_found,dx,i,n,nnb=0;
+  Element *e3;
   if(job->cfg.verbose)fprintf(stderr,"# divide vertical glued boxes");
+  box_grid_build(&job->tmp.boxgrid, job);
   for_each_data(&(job->res.boxlist)) {
     box2 = (struct box *)list_get_current(&(job->res.boxlist));
     if (box2->c != UNKNOWN) continue; /* dont try on pictures */
@@ -2683,14 +2873,16 @@ int  divide_vert_glued_boxes( pix *pp, int mo){
       && y1>=box2->m4+job->res.avY-2)
     { // test if lower end fits one of the other lines?
       box4=box2; flag_found=0;
-      for_each_data(&(job->res.boxlist)) {
-        box4 = (struct box *)list_get_current(&(job->res.boxlist));
+      n = box_grid_query(&job->tmp.boxgrid, box2->x0-dx, 0,
+                         box2->x1+dx, pp->y-1, &nb, &nnb);
+      for (i=0; i<n; i++) {
+        box4 = nb[i];
         if (box4->c != UNKNOWN) continue; /* dont try on pictures */
         if (box4->x1<box2->x0-dx || box4->x0>box2->x1+dx) continue; // ignore far boxes
         if (box4->line==box2->line  ) flag_found|=1;    // near char on same line
         if (box4->line==box2->line+1) flag_found|=2;    // near char on next line
         if (flag_found==3) break;                 // we have two vertical glued chars
-      } end_for_each(&(job->res.boxlist));
+      }
       if (flag_found!=3) continue;         // do not divide big chars or special symbols
       y=box2->m4;  // lower end of the next line
       if(job->cfg.verbose&2){
@@ -2698,19 +2890,24 @@ int  divide_vert_glued_boxes( pix *pp, int mo){
         if(job->cfg.verbose&6)out_x(box2);
       }
       // --- insert box3 before box2
-      box3= (struct box *) malloc_box(box2);
+      box3= (struct box *) box_pool_get(&job->tmp.boxpool, box2);
       box3->y1=y;
       box2->y0=y+1; box2->line++; // m1..m4 should be corrected!
+      box_grid_update(box2);
       if (box4->line == box2->line){
         box2->m1=box4->m1;        box2->m2=box4->m2;
         box2->m3=box4->m3;        box2->m4=box4->m4;
       }
       box3->num=job->res.numC;
-      if (list_ins(&(job->res.boxlist), box2, box3)) {
-          fprintf(stderr,"ERROR list_ins\n"); };
+      if (!(e3=list_ins_element(&(job->res.boxlist),
+                  list_get_cur_element(&(job->res.boxlist)), box3))) {
+          fprintf(stderr,"ERROR list_ins\n"); }
+      else box_grid_add(&job->tmp.boxgrid, e3);
       job->res.numC++;
     }
   } end_for_each(&(job->res.boxlist));
+  box_grid_free(&job->tmp.boxgrid);
+  if (nb) free(nb);
   if(job->cfg.verbose)fprintf(stderr,", numC %d\n",job->res.numC); 
   return 0;
 }
@@ -2730,18 +2927,19 @@ int wisspace(wchar_t cc){ return ((cc<128)?isspace(cc):0); }
 /* set box2->c to cc if cc is in the ac-list of box2, return 1 on success  */
 int setc(struct box *box2, wchar_t cc){
   int ret=0, w2; // w1
+  char dbuf[3][DECODE_BUFLEN];
   // w1=((box2->num_ac) ? box2->wac[0] : 0);  // weight of replaced char
   w2=testac(box2,cc);
-  if (OCR_JOB->cfg.verbose) {
+  if (box2->p->job->cfg.verbose) {
     // print first 2 alternative chars
       fprintf(stderr, "\n#  setc old nac=%d %s %s %3d %3d  to %s %3d at %4d %4d",
-       box2->num_ac, decode(box2->c,ASCII),
-       (box2->num_ac<2)?" ":decode(box2->tac[1],ASCII), box2->wac[0], 
+       box2->num_ac, decode_r(box2->c,ASCII,dbuf[0]),
+       (box2->num_ac<2)?" ":decode_r(box2->tac[1],ASCII,dbuf[1]), box2->wac[0], 
        (box2->num_ac<2)?0:box2->wac[1],
-       decode(cc,ASCII), (100+w2+1)/2, box2->x0, box2->y0);
+       decode_r(cc,ASCII,dbuf[2]), (100+w2+1)/2, box2->x0, box2->y0);
   }
   if (w2) { if (box2->c!=cc) { ret=1; setac(box2,cc,(100+w2+1)/2); } }
-  // if(OCR_JOB->cfg.verbose & 4) out_x(box2);
+  // if(box2->p->job->cfg.verbose & 4) out_x(box2);
   // ToDo: modify per setac (shift ac)
   return ret;
 }
@@ -2765,6 +2963,7 @@ int context_correction( job_t *job ) {
   char *l_nonvo = "bcdfghjklmnpqrstvwxzBCDFGHJKLMNPQRSTVWXZ";
   int  hexdigits = 0, hexdivpos = 0; // "O0lI123456789ABCDEFabcdef:"
   struct box *box3, *box2, *prev, *next, *pre2, *pre3, *pre4;
+  char dbuf[DECODE_BUFLEN];
   int dx, dy, O0_num=0, O0_slashed_zeros=0,
       O0_maxw=0, O0_minw=999999, O0_maxh=0, O0_minh=999999; 
   //  pix *pp = &(job->src.p);
@@ -2826,9 +3025,9 @@ int context_correction( job_t *job ) {
       && last_double_quotation == DOUBLE_LOW_9_QUOTATION_MARK) {
       last_double_quotation = 0;
       box2->c = box2->tac[0] = DOUBLE_HIGH_REVERSED_9_QUOTATION_MARK;
-      IFV fprintf(stderr,"\n#  change nac=%d %s   %3d to %s %3d at %3d %3d",
+      if (job->cfg.verbose&4) fprintf(stderr,"\n#  change nac=%d %s   %3d to %s %3d at %3d %3d",
         box2->num_ac, "\"", box2->wac[0],
-        decode(box2->c,ASCII), box2->wac[0], box2->x0, box2->y0);
+        decode_r(box2->c,ASCII,dbuf), box2->wac[0], box2->x0, box2->y0);
     } // box2->c==QUOTATION_MARK // 0x22 = ""
     
     if (           box2->c > 0xFF ) continue; // temporary UNICODE fix 1
@@ -2922,7 +3121,7 @@ int context_correction( job_t *job ) {
          && (box2->x1 - box2->x0 + 1) > (O0_maxw+O0_minw)/2
          && dy >= box2->m3 - box2->m2) {
         nc+=setc(box2,(wchar_t)'O'); // big width
-        IFV fprintf(stderr," DBG%04d %d,%d: O0 to O", __LINE__,
+        if (job->cfg.verbose&4) fprintf(stderr," DBG%04d %d,%d: O0 to O", __LINE__,
           box2->x0,box2->y0);
       } else
       if (O0_slashed_zeros==0 && O0_num>1  // 2018-09 rnd80.tt
@@ -2930,7 +3129,7 @@ int context_correction( job_t *job ) {
          && (box2->x1 - box2->x0 + 1) < (O0_maxw+O0_minw+1)/2
          && dy >= box2->m3 - box2->m2) {
         nc+=setc(box2,(wchar_t)'0'); // small width 
-        IFV fprintf(stderr," DBG%04d %d,%d: O0 to 0", __LINE__,
+        if (job->cfg.verbose&4) fprintf(stderr," DBG%04d %d,%d: O0 to 0", __LINE__,
           box2->x0,box2->y0);
       } else
       if (((!next) || !strchr(" .,", next->c))
@@ -2939,7 +3138,7 @@ int context_correction( job_t *job ) {
            && (!have_digits))
        ||    (have_upper && (!have_digits)) )) // UPWORD?
       { nc+=setc(box2,(wchar_t)'O');
-        IFV fprintf(stderr," DBG%04d %d,%d: O0 to O", __LINE__,
+        if (job->cfg.verbose&4) fprintf(stderr," DBG%04d %d,%d: O0 to O", __LINE__,
           box2->x0,box2->y0);}
       // ! "  Otto"
       // wchar_t c_ask= '0'; // + replace else if !!!
@@ -2948,7 +3147,7 @@ int context_correction( job_t *job ) {
                  next && strchr(" .,", next->c)))
             && (!have_upper) /*&& (!have_hexhi)*/) /* 2017-07 */
 	{ nc+=setc(box2,(wchar_t)'0');
-          IFV fprintf(stderr," DBG%04d %d,%d: O0 to 0", __LINE__,
+          if (job->cfg.verbose&4) fprintf(stderr," DBG%04d %d,%d: O0 to 0", __LINE__,
             box2->x0,box2->y0);}
     } // O0
 
@@ -2967,7 +3166,7 @@ int context_correction( job_t *job ) {
     if (wisupper(box2->c) && next && prev) {
       if (wislower(prev->c) && wislower(next->c)
 	  && 2 * (box2->x0 - prev->x1) > 3 * (next->x0 - box2->x1)) {
-	struct box *box3 = malloc_box((struct box *) NULL);
+	struct box *box3 = box_pool_get(&job->tmp.boxpool, NULL);
 	box3->x0 = prev->x1 + 2;
 	box3->x1 = box2->x0 - 2;
 	box3->y0 = box2->y0;
@@ -3047,7 +3246,7 @@ int list_insert_spaces( pix *pp, job_t *job ) {
     int thispitch=0, thismono=0, pdist=0; // spacing paras per line
     box2 =(struct box *)list_get_current(&(job->res.boxlist));
     cc=0; num_nl=0; num_spc=0;
-    box3 = (struct box *)list_prev(&(job->res.boxlist), box2);
+    box3 = (struct box *)list_get_cur_prev(&(job->res.boxlist));
     if (box2->line > maxline) {  // new line, lines and chars must be sorted!
       int ydist=0, ypitch=0;
       if (maxline>=0) {
@@ -3086,11 +3285,11 @@ int list_insert_spaces( pix *pp, job_t *job ) {
     // call this multiple times
     for (i1=0;i1<num_nl+num_spc;i1++) {
       int mdist=0;
-      box4=(struct box *)list_prev(&(job->res.boxlist), box2);
+      box4=(struct box *)list_get_cur_prev(&(job->res.boxlist));
       if (box4) mdist  = box2->x0 - box4->x1 + 1; // 2010-09
       else      mdist  = 0;
       if (mdist<0) mdist=0;
-      box3=(struct box *)malloc_box(NULL);
+      box3=(struct box *)box_pool_get(&job->tmp.boxpool, NULL);
       box3->x0=box2->x0-2+((num_spc)?-mdist+ i1   *mdist/num_spc:0);
       box3->x1=box2->x0-2+((num_spc)?-mdist+(i1+1)*mdist/num_spc:0);
       box3->y0=box2->y0;
@@ -3115,7 +3314,8 @@ int list_insert_spaces( pix *pp, job_t *job ) {
       box3->m3=box2->m3;   box3->m4=box2->m4;
       box3->p=pp;
       setac(box3,cc,100);   /* ToDo: weight depends from distance */
-      list_ins(&(job->res.boxlist),box2,box3); // insert box3 before box2
+      list_ins_element(&(job->res.boxlist),
+        list_get_cur_element(&(job->res.boxlist)), box3); // before box2
       if( job->cfg.verbose&1 ) {
         fprintf(stderr,"\n# insert space &%d; at %4d %4d box= %p"
           " mono %d dx %2d pdx,mdx %2d %2d",
@@ -3206,6 +3406,7 @@ int  add_line_info( job_t *job /* , List *boxlist2 */){
         num_rest++;
     } else num_line_members++;
   } end_for_each(&(job->res.boxlist));
+  tlines_set_boxes(job);
   if (job->cfg.verbose&1)
     fprintf(stderr," done, num_line_chars=%d rest=%d\n",
             num_line_members, num_rest);
@@ -3244,16 +3445,16 @@ int pgm2asc(job_t *job)
 {
   pix *pp;
   progress_counter_t *pc;
-  static int multi_image_count=0;  /* number of image within multi-image */
   int orig_cs=0; 
   
-  if (!multi_image_count) orig_cs = job->cfg.cs; /* save for multi-images */
+  assert(job);
+  if (!job->src.num_image) orig_cs = job->cfg.cs; /* save for multi-images */
   
-  multi_image_count++;
+  job->src.num_image++; /* number of image within multi-image */
 
-  assert(job);
   /* FIXME jb: remove pp */
   pp = &(job->src.p);
+  pp->job = job; /* getpixel() etc. need the job of the image */
 
   pc = open_progress(100,"pgm2asc_main");
   progress(0,pc); /* start progress output 0% 0% */
@@ -3280,16 +3481,27 @@ int pgm2asc(job_t *job)
      - this should be used to create a upper and lower limit for cs
      - cs is the optimum gray value between cs_min and cs_max
      - also inverse scans could be detected here later */
-  if (orig_cs==0)
-    job->cfg.cs=otsu( pp->p,pp->x,pp->y,0,0,pp->x,pp->y,job->cfg.verbose & 1);
-  else  // dont set cs, output stats + do inversion if needed 2010-10-07
-    otsu( pp->p,pp->x,pp->y,0,0,pp->x,pp->y,job->cfg.verbose & 1);
-//  if (job->cfg.verbose&32) debug_img("out001.ppm",job,0);
-  /* renormalize the image and set the normalized threshold value */
-  /* JS 2019-04 changed 2nd+3th argument, new: 2nd=nx=cols, 3th=ny=rows */
-  job->cfg.cs=thresholding( pp->p,pp->x,pp->y,0,0,pp->x,pp->y, job->cfg.cs );
+  /* orig_cs!=0: dont set cs, output stats + do inversion if needed 2010-10-07
+     renormalize the image and set the normalized threshold value,
+     otsu() + thresholding() in one call v0.53,
+     the pixel passes run on cfg.threads threads (job->tmp.pool) v0.53 */
+  if (job->cfg.threads > 1 && !job->tmp.pool)
+    job->tmp.pool = tpool_new(job->cfg.threads);
+  if (job->cfg.local) /* threshold of every pixel, -l is not used, v0.53 */
+    job->cfg.cs=local_thresholding( pp->p,pp->x,pp->y,0,0,pp->x,pp->y,
+      job->cfg.local, job->cfg.local_w, job->cfg.local_k,
+      job->cfg.verbose & 1, job->tmp.pool);
+  else
+    job->cfg.cs=otsu_thresholding( pp->p,pp->x,pp->y,0,0,pp->x,pp->y,
+                                   orig_cs, job->cfg.verbose & 1,
+                                   job->tmp.pool);
   if( job->cfg.verbose ) 
     fprintf(stderr, "# thresholding new_threshold= %d\n", job->cfg.cs);
+  /* packed black plane for get_bw, num_cross, loop, v0.53 */
+  if (pix_bits_init(pp, job->cfg.cs, job->tmp.pool))
+    fprintf(stderr, "# no memory for the packed plane, using bytes\n");
+  else
+    norm_reduce(job, pp); /* high resolution to ~cfg.norm pixel glyphs */
 //  if (job->cfg.verbose&32) debug_img("out002.ppm",job,0);
 
   progress(5,pc); /* progress is only estimated */
@@ -3305,9 +3517,13 @@ int pgm2asc(job_t *job)
 
 //  if (job->cfg.verbose&32) debug_img("out008.ppm",job,8);
   scan_boxes( job, pp );
+  /* for get_bw, built after the scan has freed its marks, v0.53 */
+  if (pp->bits && pix_sat_init(pp, job->tmp.pool))
+    fprintf(stderr, "# no memory for the summed-area table\n");
   if ( !job->res.numC ){ 
     fprintf( stderr,"# no boxes found - stopped\n" );
     if(job->cfg.verbose&32) debug_img("out01",job,8);
+    norm_restore(job, pp);
     /***** should free stuff, etc) */
     return(1);
   }
@@ -3320,6 +3536,7 @@ int pgm2asc(job_t *job)
   // ToDo: matrix printer preprocessing
 
   remove_dust( job ); /* from the &(job->res.boxlist)! */
+  pix_sat_update( pp ); /* recount the rows changed by put() */
 // if(job->cfg.verbose&32) debug_img("out02",job,4+8);
 // output_list(job);  // for debugging 
 #if 0 // ToDo 2010-10-15 destroys QR-barcodes
@@ -3341,7 +3558,7 @@ int pgm2asc(job_t *job)
 //  if(job->cfg.verbose&32) debug_img("out06",job,4+8);
 // output_list(job);  // for debugging
 
-  glue_holes_inside_chars( pp ); /* including count subboxes (holes)  */
+  glue_holes_inside_chars( job, pp ); /* including count subboxes (holes)  */
 
   detect_rotation_angle( job );
 
@@ -3350,21 +3567,23 @@ int pgm2asc(job_t *job)
     // in work! ??? (at end set dy=0) think on ppo!
   }
 #endif
-  detect_text_lines( pp, job->cfg.mode ); /* detect and mark job->tmp.ppo */
+  detect_text_lines( job, pp, job->cfg.mode ); /* detect and mark job->tmp.ppo */
 // if(job->cfg.verbose&32) debug_img("out07",job,4+8);
   progress(20,pc); /* progress is only estimated */
 
   add_line_info( job /* , &(job->res.boxlist) */);
   if (job->cfg.verbose&32) debug_img("out10",job,4+8);
 
-  divide_vert_glued_boxes( pp, job->cfg.mode); /* after add_line_info, before list_sort! */
+  divide_vert_glued_boxes( job, pp, job->cfg.mode); /* after add_line_info, before list_sort! */
 //  if(job->cfg.verbose&32) debug_img("out11",job,0);
 
   remove_melted_serifs( job, pp ); /* make some corrections on pixmap */
+  pix_sat_update( pp );
   /* list_ins seems to sort in the boxes on the wrong place ??? */
 //  if(job->cfg.verbose&32) debug_img("out12",job,4+8);
 
   glue_broken_chars( job, pp ); /* 2nd glue */
+  pix_sat_update( pp );
 //  if(job->cfg.verbose&32) debug_img("out14",job,4+8);
 // 2010-09-24 overall box size is correct here, but later broken
 
@@ -3376,19 +3595,19 @@ int pgm2asc(job_t *job)
 
   measure_pitch( job );
 
-  if(job->cfg.mode&64) find_same_chars( pp );
+  if(job->cfg.mode&64) find_same_chars( job, pp );
   progress(30,pc); /* progress is only estimated */
 //  if(job->cfg.verbose&32) debug_img("out16",job,4+8);
 
-  char_recognition( pp, job->cfg.mode);
+  char_recognition( job, pp, job->cfg.mode);
   progress(60,pc); /* progress is only estimated */
 //  if(job->cfg.verbose&32) debug_img("out17",job,4+8);
 
-  if ( adjust_text_lines( pp, job->cfg.mode ) ) { /* correct using chars */
+  if ( adjust_text_lines( job, pp, job->cfg.mode ) ) { /* correct using chars */
     /* may be, characters/pictures have changed line number */
     list_sort(&(job->res.boxlist), sort_box_func);
     // 2nd recognition call if lines are adjusted
-    char_recognition( pp, job->cfg.mode);
+    char_recognition( job, pp, job->cfg.mode);
   }
 
 #define BlownUpDrawing 1     /* german: Explosionszeichnung, temporarly */
@@ -3409,10 +3628,10 @@ int pgm2asc(job_t *job)
   // ----------- write out20.pgm ----------- mark lines + boxes
   if (job->cfg.verbose&32) debug_img("out20",job,1+4+8);
 
-  compare_unknown_with_known_chars( pp, job->cfg.mode);
+  compare_unknown_with_known_chars( job, pp, job->cfg.mode);
   progress(70,pc); /* progress is only estimated */
 
-  try_to_divide_boxes( pp, job->cfg.mode);
+  try_to_divide_boxes( job, pp, job->cfg.mode);
   progress(80,pc); /* progress is only estimated */
 
   /* --- list output ---- for debugging --- */
@@ -3425,6 +3644,10 @@ int pgm2asc(job_t *job)
   if (job->cfg.verbose)
     fprintf(stderr,"# context correction if !(mode&32)\n");
   if (!(job->cfg.mode&32)) context_correction( job );
+
+  /* boxes and lines to the coordinates of the input image (--norm)
+     and of the page (--band), v0.53 */
+  norm_restore( job, pp );
   
   store_boxtree_lines( job, job->cfg.mode );
   progress(90,pc); /* progress is only estimated */
@@ -3468,6 +3691,13 @@ int pgm2asc(job_t *job)
   // ---- write internal picture of textsite
   // ----------- write out30.pgm -----------
   if( job->cfg.verbose&32 ) debug_img("out30",job,2+4);
+
+  if (job->cfg.verbose)
+    fprintf(stderr,"# box pool: boxes= %d peak= %d reused= %d"
+      " slabs= %d (%d KB)\n", job->tmp.boxpool.num_boxes,
+      job->tmp.boxpool.max_boxes, job->tmp.boxpool.num_reused,
+      job->tmp.boxpool.num_slabs,
+      (int)(job->tmp.boxpool.num_slabs*sizeof(struct box_slab_s)/1024));
     
   progress(100,pc); /* progress is only estimated */
 
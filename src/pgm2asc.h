@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "pnm.h"
 #include "output.h"
 #include "list.h"
+#include "tpool.h"
 /* #include "unicode.h" JS.Aug2010 reduce dependencies */
 
 #define pixel_at(pic, xx, yy)           (pic).p[(xx)+((yy)*((pic).x))]
@@ -54,25 +55,53 @@ int box_gt(struct box *box1, struct box *box2);
 int reset_box_ac(struct box *box);           /* reset and free char table */
 struct box *malloc_box( struct box *inibox );   /* alloc memory for a box */
 int free_box( struct box *box );                /* free memory of a box */
+int  box_alloc_vectors( struct box *box1, int num ); /* frame_vector[num] */
+void box_free_vectors( struct box *box1 );
+frame_vector_t *box_copy_vectors( struct box *box1,
+                   frame_vector_t **buf, int *bufsize );
+void box_pool_init( box_pool_t *pool );
+struct box *box_pool_get( box_pool_t *pool, struct box *inibox ); /* alloc */
+void box_pool_free( box_pool_t *pool );         /* release all boxes */
 int copybox( pix *p, int x0, int y0, int dx, int dy, pix *b, int len);
 int reduce_vectors ( struct box *box1, int mode );
 int merge_boxes( struct box *box1, struct box *box2 );
 int cut_box( struct box *box1);
+
+/* declared in boxgrid.c, spatial index of job->res.boxlist */
+void box_grid_init( box_grid_t *grid );
+int  box_grid_build( box_grid_t *grid, job_t *job );
+void box_grid_free( box_grid_t *grid );
+int  box_grid_add( box_grid_t *grid, Element *e ); /* after list_ins */
+void box_grid_del( struct box *box1 );    /* called by free_box() */
+void box_grid_update( struct box *box1 ); /* after change of x0..y1 */
+int  box_grid_query( box_grid_t *grid, int x0, int y0, int x1, int y1,
+                     struct box ***buf, int *bufsize );
+int  box_grid_nearest( box_grid_t *grid, int x, int y, int k, int maxdist2,
+                     int (*accept)(struct box *box1, void *data), void *data,
+                     struct box ***buf, int *bufsize );
+struct box *box_grid_right_neighbour( box_grid_t *grid, struct box *box1,
+                     int maxdist2,
+                     int (*accept)(struct box *box1, void *data), void *data );
   
 
 /* declared in database.c */
 int load_db(job_t *job);
+void free_db(job_t *job);
 wchar_t ocr_db(struct box *box1, job_t *job);
 
 /* declared in detect.c */
-int detect_lines1(pix * p, int x0, int y0, int dx, int dy);
-int detect_lines2(pix *p,int x0,int y0,int dx,int dy,int r);
+int detect_lines1(job_t *job, pix * p, int x0, int y0, int dx, int dy);
+int detect_lines2(job_t *job, pix *p,int x0,int y0,int dx,int dy,int r);
 int detect_rotation_angle(job_t *job);
-int detect_text_lines(pix * pp, int mo);
-int adjust_text_lines(pix * pp, int mo);
+int detect_text_lines(job_t *job, pix * pp, int mo);
+int adjust_text_lines(job_t *job, pix * pp, int mo);
 int detect_pictures(job_t *job);
 
 /* declared in lines.c */
+void tlines_init(struct tlines *lines);
+int  tlines_grow(struct tlines *lines, int n);
+void tlines_free(struct tlines *lines);
+int  tlines_set_boxes(job_t *job);
 void store_boxtree_lines( job_t *job, int mo );
    /* free memory for internal stored textlines.
     * Needs to be called _after_ having retrieved the text.
@@ -87,6 +116,10 @@ void free_textlines(List *linelist);
     */
 const char *getTextLine(List *linelist, int line);
 
+/* declared in norm.c, resolution normalisation (--norm), band offset */
+int  norm_reduce(job_t *job, pix *pp);
+void norm_restore(job_t *job, pix *pp);
+
 /* declared in remove.c */
 int remove_dust( job_t *job );
 int remove_pictures( job_t *job);
@@ -96,8 +129,55 @@ int smooth_borders( job_t *job );
 
 /* declared in pixel.c */
 int marked(pix * p, int x, int y);
+void put_mark(pix * p, int x, int y, int mark);
+int  pix_marks_init(pix *p);
+void pix_marks_free(pix *p);
 int pixel(pix *p, int x, int y);
+void pixel_filter_init(job_t *job);
 void put(pix * p, int x, int y, int ia, int io);
+int  pix_bits_init(pix *p, int cs, tpool_t *tp);
+void pix_bits_free(pix *p);
+int  pix_bits_count(pix *p, int x0, int x1, int y);
+int  pix_bits_next(pix *p, int x, int x1, int y, int black);
+int  pix_bits_prev(pix *p, int x, int x0, int y, int black);
+int  pix_pyr_empty(pix *p, int l, int x0, int x1, int y0, int y1);
+int  pix_black_next(pix *p, int x, int x1, int y);
+int  pix_pyr_height(pix *p, int l, int nmax);
+int  pix_fbits_init(pix *p);
+void pix_fbits_free(pix *p);
+int  pix_sat_init(pix *p, tpool_t *tp);
+int  pix_sat_update(pix *p);
+void pix_sat_free(pix *p);
+int  pix_sat_count(pix *p, int x0, int x1, int y0, int y1);
+/* reduced planes behind p->bits: 2x, 4x, 8x (pix_pyr_empty), v0.53 */
+#define PIX_PYR 3
+/* p->bits can replace getpixel(p,x,y)<cs */
+#define PIX_BITS_OK(p,cs) ((p)->bits && (cs) == (p)->bcs \
+                          && !((p)->job && (p)->job->tmp.n_run > 0))
+/* p->sat can count the black pixels of x0..x1, y0..y1 (16 bit counts) */
+#define PIX_SAT_MAX 65535
+#define PIX_SAT_OK(p,cs,x0,x1,y0,y1) (PIX_BITS_OK(p,cs) && (p)->sat \
+          && (y1) < (p)->saty \
+          && (double)((x1) - (x0) + 1) * ((y1) - (y0) + 1) <= PIX_SAT_MAX)
+#define PIX_BIT(p,x,y) (int)(((p)->bits[(size_t)(y) * (p)->bstride \
+          + (x) / PIXWORD_BITS] >> ((x) % PIXWORD_BITS)) & 1)
+
+/* declared in serve.c, gocr --serve */
+int serve(job_t *job, const char *path);
+
+/* declared in band.c, gocr --band[=rows] */
+int band_ocr(job_t *job, int rows);
+
+/* declared in pipeline.c, gocr --threads=n (with pthread.h only) */
+int pipe_ocr(job_t *job);
+
+/* declared in batch.c, gocr file1 file2 ..., --list=name, --suffix=.txt */
+int batch_ocr(job_t *job, char **files, int nfiles, char *list,
+              char *suffix);
+
+/* declared in gocr.c, print the text lines of job.res.linelist */
+void print_output(job_t *job);
+void fprint_output(FILE *f, job_t *job); /* to f instead of stdout */
 
 /* start ocr on a image in job.src.p */
 int pgm2asc(job_t *job);
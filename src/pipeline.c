@@ -0,0 +1,246 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2019  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ page pipeline (gocr --threads=n), v0.53
+   the pages of a multi-image file are recognized by n worker threads,
+   the main thread reads the next pages meanwhile and prints the text
+   of the finished pages in page order, at most 2*n pages are read
+   but not printed (bounded memory)
+
+   pdftoppm -r 300 -gray x.pdf | gocr --threads=4 -
+
+   the text is the same as without threads: every worker has its own
+   job (and database, -m 2), pages after the first are recognized with
+   the dust size of the first page (-d -1) as the page loop of main() does,
+   so they wait for the first page in that case
+
+   the preprocessing of a page (pgm2asc, job->tmp.pool) gets the threads
+   of the idle workers, n/busy pages, so a single page uses all n threads
+   and a long file uses one thread per page (no n*n threads)
+
+ ToDo: verbose output of the workers is mixed
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "pnm.h"
+#include "pgm2asc.h"
+#include "gocr.h"
+
+#ifdef HAVE_PTHREAD_H
+
+#define PAGE_EMPTY 0 /* slot is free */
+#define PAGE_READY 1 /* image is read, waiting for a worker */
+#define PAGE_BUSY  2 /* recognition is running */
+#define PAGE_DONE  3 /* text is waiting for the output */
+
+typedef struct page_s {
+  int state;
+  int num;     /* page number, 0 is the first page */
+  pix p;       /* image, the worker takes it */
+  char *txt;   /* text of the page */
+  int len, max;
+  int err;     /* no memory for the text */
+} page_t;
+
+typedef struct pipe_s {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;  /* broadcast on every change of a page state */
+  page_t *page;         /* page num uses page[num % npage] */
+  int npage;
+  int quit;             /* no more pages, workers return */
+  int busy;             /* pages in recognition */
+  job_t *job;           /* options of the command line */
+  int cfg_ok;           /* cfg of the pages after the first is known */
+  job_t cfg;            /* only cfg.cfg is used */
+} pipe_t;
+
+typedef struct worker_s {
+  pthread_t tid;
+  pipe_t *pp;
+  job_t job;  /* own job, the engine has no shared state since v0.53 */
+} worker_t;
+
+static int page_cat(page_t *pg, const char *s) {
+  int n = strlen(s);
+  char *p;
+  if (pg->len + n + 1 > pg->max) {
+    p = (char *)realloc(pg->txt, 2 * (pg->len + n + 1));
+    if (!p) return -1;
+    pg->txt = p; pg->max = 2 * (pg->len + n + 1);
+  }
+  memcpy(pg->txt + pg->len, s, n + 1);
+  pg->len += n;
+  return 0;
+}
+
+/* same text as print_output() */
+static void page_text(job_t *job, page_t *pg) {
+  const char *line;
+  int i;
+  pg->len = 0;
+  for (i = 0; (line = getTextLine(&job->res.linelist, i)) != NULL; i++) {
+    if (page_cat(pg, line)
+     || (job->cfg.out_format == HTML && page_cat(pg, "<br />"))
+     || (job->cfg.out_format != XML  && page_cat(pg, "\n"))) {
+      pg->err = 1; break;
+    }
+  }
+  free_textlines(&job->res.linelist);
+}
+
+/* the READY page with the lowest number, NULL if none can start */
+static page_t *next_page(pipe_t *pp) {
+  page_t *pg = NULL;
+  int i;
+  for (i = 0; i < pp->npage; i++)
+    if (pp->page[i].state == PAGE_READY
+     && (!pg || pp->page[i].num < pg->num)) pg = &pp->page[i];
+  if (pg && pg->num > 0 && !pp->cfg_ok) pg = NULL;
+  return pg;
+}
+
+static void *worker(void *arg) {
+  worker_t *w = (worker_t *)arg;
+  pipe_t *pp = w->pp;
+  job_t *job = &w->job;
+  page_t *pg;
+
+  for (;;) {
+    pthread_mutex_lock(&pp->mutex);
+    while (!(pg = next_page(pp)) && !pp->quit)
+      pthread_cond_wait(&pp->cond, &pp->mutex);
+    if (!pg) { pthread_mutex_unlock(&pp->mutex); break; }
+    pg->state = PAGE_BUSY;
+    job->cfg = (pg->num) ? pp->cfg.cfg : pp->job->cfg;
+    job->cfg.threads = pp->job->cfg.threads / ++pp->busy;
+    if (job->cfg.threads < 1) job->cfg.threads = 1;
+    pthread_mutex_unlock(&pp->mutex);
+
+    job_init_image(job);
+    job->src.p.p = pg->p.p; /* freed by job_free_image */
+    job->src.p.x = pg->p.x;
+    job->src.p.y = pg->p.y;
+    job->src.p.bpp = pg->p.bpp;
+    pg->p.p = NULL;
+    job->src.num_image = pg->num; /* -l only for the first page */
+    pgm2asc(job);
+    page_text(job, pg);
+    job_free_image(job);
+
+    pthread_mutex_lock(&pp->mutex);
+    if (!pp->cfg_ok) { pp->cfg.cfg = job->cfg; pp->cfg_ok = 1; }
+    pp->busy--;
+    pg->state = PAGE_DONE;
+    pthread_cond_broadcast(&pp->cond);
+    pthread_mutex_unlock(&pp->mutex);
+  }
+  return NULL;
+}
+
+/* main loop of gocr --threads=n, returns 0 or -1 on error */
+int pipe_ocr(job_t *job) {
+  pipe_t pp;
+  worker_t *w;
+  page_t *pg;
+  int i, n, nw = 0, nread = 0, nout = 0, rc = 1, out, in;
+
+  n = job->cfg.threads;
+  memset(&pp, 0, sizeof(pp));
+  pp.job = job;
+  pp.npage = 2 * n;
+  pp.cfg.cfg = job->cfg;
+  pp.cfg_ok = (job->cfg.dust_size >= 0); /* else after the first page */
+  pp.page = (page_t *)calloc(pp.npage, sizeof(page_t));
+  w = (worker_t *)calloc(n, sizeof(worker_t));
+  if (!pp.page || !w) {
+    fprintf(stderr, "ERROR pipe: no memory for %d threads\n", n);
+    free(pp.page); free(w); return -1;
+  }
+  pthread_mutex_init(&pp.mutex, NULL);
+  pthread_cond_init(&pp.cond, NULL);
+  job->src.stream.threads = 1; /* the workers are busy meanwhile */
+  for (nw = 0; nw < n; nw++) {
+    job_init(&w[nw].job);
+    w[nw].job.cfg = job->cfg;
+    w[nw].pp = &pp;
+    if ((job->cfg.mode & 2) && load_db(&w[nw].job) < 0) {
+      free_db(&w[nw].job); break; }
+    if (pthread_create(&w[nw].tid, NULL, worker, &w[nw])) {
+      fprintf(stderr, "ERROR pipe: pthread_create failed\n");
+      free_db(&w[nw].job); break;
+    }
+  }
+  if (nw < n) rc = -1;
+
+  while (nw > 0) {
+    pthread_mutex_lock(&pp.mutex);
+    for (;;) {
+      out = (nout < nread && pp.page[nout % pp.npage].state == PAGE_DONE);
+      in  = (rc == 1 && pp.page[nread % pp.npage].state == PAGE_EMPTY);
+      if (out || in || (rc != 1 && nout == nread)) break;
+      pthread_cond_wait(&pp.cond, &pp.mutex);
+    }
+    pthread_mutex_unlock(&pp.mutex);
+    if (out) { /* the main thread owns EMPTY and DONE pages */
+      pg = &pp.page[nout % pp.npage];
+      if (pg->err) fprintf(stderr, "ERROR pipe: no memory for text\n");
+      else if (pg->len) fwrite(pg->txt, 1, pg->len, stdout);
+      pthread_mutex_lock(&pp.mutex);
+      pg->state = PAGE_EMPTY;
+      pthread_mutex_unlock(&pp.mutex);
+      nout++;
+    } else if (in) {
+      pg = &pp.page[nread % pp.npage];
+      rc = readpgm_stream(&job->src.stream, job->src.fname, &pg->p,
+                          job->cfg.verbose);
+      if (rc < 0) continue; /* read error, print the pages before */
+      pg->num = nread++;
+      pg->err = 0;
+      pthread_mutex_lock(&pp.mutex);
+      pg->state = PAGE_READY;
+      pthread_cond_broadcast(&pp.cond);
+      pthread_mutex_unlock(&pp.mutex);
+    } else break; /* all pages are printed */
+  }
+
+  pthread_mutex_lock(&pp.mutex);
+  pp.quit = 1;
+  pthread_cond_broadcast(&pp.cond);
+  pthread_mutex_unlock(&pp.mutex);
+  for (i = 0; i < nw; i++) {
+    pthread_join(w[i].tid, NULL);
+    free_db(&w[i].job);
+  }
+  for (i = 0; i < pp.npage; i++) { free(pp.page[i].txt); free(pp.page[i].p.p); }
+  pthread_cond_destroy(&pp.cond);
+  pthread_mutex_destroy(&pp.mutex);
+  free(pp.page);
+  free(w);
+  return ((rc < 0) ? -1 : 0);
+}
+
+#endif
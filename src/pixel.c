@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "pgm2asc.h"
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*
@@ -34,15 +35,63 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // ------------------ (&~7)-pixmap-functions ------------------------
  
+/* ------------------ scan marks, v0.53 --------------------------------
+ * scan_boxes(), frame_vector() and frame_nn() mark scanned pixels with
+ * 3 bits. The marks were stored in the lowest bits of the image bytes,
+ * now they live in p->marks, one byte per pixel:
+ * bits 0..2 = marks, bits 3..7 = epoch. Only entries of the current
+ * epoch p->mepoch are valid, so clearing all marks is mepoch++ and the
+ * image bytes are not written by the scans. The page needs the marks
+ * only in scan_boxes(), which frees them at the end.
+ */
+#define MARK_EPOCH_MAX 31 /* 5 bits */
+
+/* alloc the mark plane or clear all marks (new epoch), 0 or -1 */
+int pix_marks_init(pix *p) {
+  if (!p->marks) {
+    p->marks = (unsigned char *)calloc((size_t)p->x * p->y + 1, 1);
+    if (!p->marks) {
+      fprintf(stderr, "ERROR: malloc failed (pix_marks_init)\n");
+      return -1;
+    }
+    p->mepoch = 1;
+    return 0;
+  }
+  if (++p->mepoch > MARK_EPOCH_MAX) { /* wrap around, every 31th clear */
+    memset(p->marks, 0, (size_t)p->x * p->y + 1);
+    p->mepoch = 1;
+  }
+  return 0;
+}
+
+void pix_marks_free(pix *p) {
+  if (p->marks) free(p->marks);
+  p->marks = NULL;
+}
+
 /* test if pixel marked?
  * Returns: 0 if not marked, least 3 bits if marked.
  */
 int marked (pix * p, int x, int y) {
-  if (x < 0 || y < 0 || x >= p->x || y >= p->y)
+  unsigned v;
+  if (x < 0 || y < 0 || x >= p->x || y >= p->y || !p->marks)
     return 0;
-  return (pixel_atp(p, x, y) & 7);
+  v = p->marks[x + y * p->x];
+  return ((v >> 3) == p->mepoch) ? (int)(v & 7) : 0;
 }
 
+/* add 3 bit mark to the marks of pixel x,y (was p->p[] |= mark) */
+void put_mark(pix * p, int x, int y, int mark) {
+  unsigned char *m;
+  if (x < 0 || y < 0 || x >= p->x || y >= p->y || !p->marks)
+    return;
+  m = p->marks + x + y * p->x;
+  if ((*m >> 3) != p->mepoch) *m = (unsigned char)(p->mepoch << 3);
+  *m |= (mark & 7);
+}
+
+static void fbits_update(pix *p, int y, int i0, int i1); /* v0.53 */
+
 #define Nfilt3 6 /* number of 3x3 filter */
 /*
  * Filters to correct possible scanning or image errors.
@@ -144,7 +193,7 @@ void print_filter_stats() {
  */
 int pixel_filter_by_matrix(pix * p, int x, int y) {
   int i;
-  static char c33[9];
+  char c33[9];
   memset(c33, 0, sizeof(c33));
   /* copy environment of a point (only highest bit)
 bbg: FASTER now. It has 4 ifs less at least, 8 at most. */
@@ -171,7 +220,7 @@ bbg: FASTER now. It has 4 ifs less at least, 8 at most. */
         && ( (filt3[i][6]>>1) || c33[6]!=(1 & filt3[i][6]) )
         && ( (filt3[i][7]>>1) || c33[7]!=(1 & filt3[i][7]) )
         && ( (filt3[i][8]>>1) || c33[8]!=(1 & filt3[i][8]) ) ) {
-      return ((filt3[i][4])?OCR_JOB->cfg.cs:0);
+      return ((filt3[i][4])?p->job->cfg.cs:0);
     }
   return pixel_atp(p, x, y) & ~7;
 }
@@ -220,17 +269,18 @@ void rec_generate_number_table(char * num_table, const char * filter,
  * the same way to a numeric representation P, and that environment
  * matches a filter if num_table[P] == 1.
  */
+static void filter_number_init(job_t *job) {
+  int f;
+  memset(job->tmp.filter_num, 0, NUM_TABLE_SIZE);
+  for (f = 0; f < Nfilt3; f++)
+    rec_generate_number_table(job->tmp.filter_num, filt3[f], 0, 0);
+  job->tmp.filter_init |= 2;
+}
+
 int pixel_filter_by_number(pix * p, int x, int y) {
   unsigned short val = 0;
-  static char num_table[NUM_TABLE_SIZE];
-  static int num_table_generated = 0;
-  if (!num_table_generated) {
-    int f;
-    memset(num_table, 0, sizeof(num_table));
-    for (f = 0; f < Nfilt3; f++)
-      rec_generate_number_table(num_table, filt3[f], 0, 0);
-    num_table_generated = 1;
-  }
+  char *num_table = p->job->tmp.filter_num; /* per job since v0.53 */
+  if (!(p->job->tmp.filter_init & 2)) filter_number_init(p->job);
 
   /* calculate a numeric value for the 3x3 square around the pixel. */
   if (x > 0) {	val |= (pixel_atp(p,x-1, y )>>7) << (8 - 3);
@@ -247,7 +297,7 @@ int pixel_filter_by_number(pix * p, int x, int y) {
   assert(val < NUM_TABLE_SIZE);
 
   if (num_table[val])
-      return (val & (1 << 4)) ? 0 : OCR_JOB->cfg.cs;
+      return (val & (1 << 4)) ? 0 : p->job->cfg.cs;
   else
     return pixel_atp(p, x, y) & ~7;
 }
@@ -313,9 +363,18 @@ void rec_generate_tree(char * tree, const char * filter, int i, int n) {
  * represented by this branch turns a black pixel white, and 2 a
  * white pixel black.
  */
+static void filter_tree_init(job_t *job) {
+  int f;
+  memset(job->tmp.filter_tree, 0, TREE_ARRAY_SIZE);
+  for (f = 0; f < Nfilt3; f++) {
+    const char * filter = filt3[f];
+    rec_generate_tree(job->tmp.filter_tree, filter, 0, -1);
+  } 
+  job->tmp.filter_init |= 1;
+}
+
 int pixel_filter_by_tree(pix * p, int x, int y) {
-  static char tree[TREE_ARRAY_SIZE];
-  static int tree_generated = 0;
+  char *tree = p->job->tmp.filter_tree; /* per job since v0.53 */
   int n;
   int pixel_val = pixel_atp(p, x, y) & ~7;
 #ifdef FILTER_STATISTICS
@@ -326,15 +385,7 @@ int pixel_filter_by_tree(pix * p, int x, int y) {
   }
   filter_tries++;
 #endif  /* FILTER_STATISTICS */
-  if (!tree_generated) {
-    int f;
-    memset(tree, 0, sizeof(tree));
-    for (f = 0; f < Nfilt3; f++) {
-      const char * filter = filt3[f];
-      rec_generate_tree(tree, filter, 0, -1);
-    } 
-    tree_generated = 1;
-  }
+  if (!(p->job->tmp.filter_init & 1)) filter_tree_init(p->job);
   n = -1;
 
   /* Note that for the image, low is black, high is white, whereas
@@ -423,13 +474,13 @@ int pixel_filter_by_tree(pix * p, int x, int y) {
 #endif
   if (tree[n] == 1) {
 #ifdef FILTER_STATISTICS
-    if (pixel_atp(p, x, y) < OCR_JOB->cfg.cs)
+    if (pixel_atp(p, x, y) < p->job->cfg.cs)
       filter_whitened++;
 #endif
-    return OCR_JOB->cfg.cs;
+    return p->job->cfg.cs;
   } else {
 #ifdef FILTER_STATISTICS
-    if (pixel_atp(p, x, y) >= OCR_JOB->cfg.cs)
+    if (pixel_atp(p, x, y) >= p->job->cfg.cs)
       filter_blackened++;
 #endif
     return 0;
@@ -479,20 +530,48 @@ void print_pixel_env(FILE * out, pix * p, int x, int y) {
 }
 #endif
 
+/* build the getpixel() filter tables of job in advance, v0.53
+ *  otherwise they are built at first use, a server (--serve) builds
+ *  them once before serving requests */
+void pixel_filter_init(job_t *job) {
+#if FILTER_METHOD == FILTER_BY_NUMBER || defined(FILTER_CHECKED)
+  if (!(job->tmp.filter_init & 2)) filter_number_init(job);
+#endif
+#if FILTER_METHOD == FILTER_BY_TREE || defined(FILTER_CHECKED)
+  if (!(job->tmp.filter_init & 1)) filter_tree_init(job);
+#endif
+}
+
 /* this function is heavily used
  * test if pixel was set, remove low bits (marks) --- later with error-correction
- * result depends on n_run, if n_run>0 filter are used
+ * result depends on n_run of the owning job p->job, if n_run>0 filter are used
  * Returns: pixel-color (without marks)
  */
 int getpixel(pix *p, int x, int y){
-  job_t *job=OCR_JOB; /* fixme */
   if ( x < 0 || y < 0 || x >= p->x || y >= p->y ) 
     return 255 & ~7;
 
   /* filter will be used only once later, when vectorization replaces pixel
    * processing 
    */
-  if (job->tmp.n_run > 0) { /* use the filters (correction of errors) */
+  if (p->job && p->job->tmp.n_run > 0) { /* use the filters (correction of errors) */
+    /* precomputed flips of the page, v0.53 */
+    if (p->fbits || (p->bits && pix_fbits_init(p) == 0)) {
+      int pix = pixel_atp(p, x, y) & ~7;
+      if ((p->fbits[(size_t)y * p->bstride + x / PIXWORD_BITS]
+           >> (x % PIXWORD_BITS)) & 1)
+        pix = (pix >> 7) ? 0 : p->job->cfg.cs;
+#ifdef FILTER_CHECKED
+      if (pix != pixel_filter_by_tree(p, x, y)) {
+        fprintf(stderr,
+            "# BUG: pixel_filter: fbits: %d; tree: %d, atp %d; env: ",
+            pix, pixel_filter_by_tree(p, x, y), pixel_atp(p, x, y) & ~7);
+        print_pixel_env(stderr, p, x, y);
+        fputc('\n', stderr);
+      }
+#endif /* FILTER_CHECKED */
+      return pix;
+    }
 #if FILTER_METHOD == FILTER_BY_NUMBER
     int pix = pixel_filter_by_number(p, x, y);
 #ifdef FILTER_CHECKED
@@ -531,8 +610,515 @@ int getpixel(pix *p, int x, int y){
   return (pixel_atp(p,x,y) & ~7);
 }
 
+static void pyr_set(pix *p, int x, int y);
+
 /* modify pixel, test if out of range */
 void put(pix * p, int x, int y, int ia, int io) {
-  if (x < p->x && x >= 0 && y >= 0 && y < p->y)
+  int i;
+  if (x < p->x && x >= 0 && y >= 0 && y < p->y) {
     pixel_atp(p, x, y) = (pixel_atp(p, x, y) & ia) | io;
+    if (p->bits) { /* keep the packed plane in sync, v0.53 */
+      pixword_t *w = p->bits + (size_t)y * p->bstride + x / PIXWORD_BITS,
+                 m = (pixword_t)1 << (x % PIXWORD_BITS);
+      if ((pixel_atp(p, x, y) & ~7) >= p->bcs) *w &= ~m;
+      else if (!(*w & m)) { *w |= m; pyr_set(p, x, y); } /* new black */
+    }
+    if (p->sat && y < p->saty) p->saty = y; /* rows >= y are stale */
+    if (p->fbits) /* the filter of the 3x3 environment may change */
+      for (i = -1; i < 2; i++)
+        fbits_update(p, y + i, (x - 1) / PIXWORD_BITS, (x + 1) / PIXWORD_BITS);
+    if (p->marks && (ia & 7) != 7) { /* marks were the lowest bits */
+      unsigned char *mk = p->marks + x + y * p->x;
+      if ((*mk >> 3) == p->mepoch) *mk &= ~(unsigned char)(7 & ~ia);
+    }
+  }
+}
+
+/* ------------------ packed black plane, v0.53 ------------------------
+ * After thresholding() the image is binary in effect. p->bits holds one
+ * bit per pixel (1 = black = (pixel&~7) < bcs), pixel x of row y is bit
+ * x%PIXWORD_BITS of word x/PIXWORD_BITS, rows are bstride words apart,
+ * bits behind p->x are 0. get_bw(), num_cross() and loop() test whole
+ * words, if PIX_BITS_OK (same cs, no getpixel filter active).
+ * put() keeps the plane in sync, the byte image stays for gray values.
+ */
+#if defined(__GNUC__)
+#define WORD_POPCOUNT(w) __builtin_popcountl(w)
+#define WORD_CTZ(w)      __builtin_ctzl(w)
+#define WORD_MSB(w)      (PIXWORD_BITS - 1 - __builtin_clzl(w))
+#else
+static int WORD_POPCOUNT(pixword_t w) {
+  int n = 0;
+  for (; w; w &= w - 1) n++;
+  return n;
+}
+static int WORD_CTZ(pixword_t w) { /* w!=0 */
+  int n = 0;
+  for (; !(w & 1); w >>= 1) n++;
+  return n;
+}
+static int WORD_MSB(pixword_t w) { /* w!=0 */
+  int n = 0;
+  for (; w >>= 1; ) n++;
+  return n;
+}
+#endif
+#define ALL1 (~(pixword_t)0)
+
+/* rows i0..i1-1 of p->bits (tpool_for) */
+static void bits_rows(void *arg, int i0, int i1, int id) {
+  pix *p = (pix *)arg;
+  int x, y, cs = p->bcs;
+  unsigned char *s;
+  pixword_t *w, v;
+
+  for (y = i0; y < i1; y++) {
+    s = p->p + (size_t)y * p->x;
+    w = p->bits + (size_t)y * p->bstride;
+    for (x = 0, v = 0; x < p->x; x++) {
+      if ((s[x] & ~7) < cs) v |= (pixword_t)1 << (x % PIXWORD_BITS);
+      if (x % PIXWORD_BITS == PIXWORD_BITS - 1) { *w++ = v; v = 0; }
+    }
+    if (x % PIXWORD_BITS) *w = v;
+  }
+}
+
+static size_t pyr_words(pix *p);
+static void pyr_build(pix *p, tpool_t *tp);
+
+/* (re)build p->bits and the reduced planes behind it from the byte
+ *  image, return 0 or -1 (no memory),
+ *  the rows are cut into parts for the threads of tp (NULL = 1) */
+int pix_bits_init(pix *p, int cs, tpool_t *tp) {
+  pix_bits_free(p);
+  if (p->x <= 0 || p->y <= 0) return -1;
+  p->bstride = (p->x + PIXWORD_BITS - 1) / PIXWORD_BITS;
+  p->bits = (pixword_t *)malloc(((size_t)p->bstride * p->y + pyr_words(p))
+                                * sizeof(pixword_t));
+  if (!p->bits) return -1;
+  p->bcs = cs;
+  tpool_for(tp, p->y, bits_rows, p);
+  pyr_build(p, tp);
+  return 0;
+}
+
+void pix_bits_free(pix *p) {
+  if (p->bits) free(p->bits);
+  p->bits = NULL;
+  pix_fbits_free(p); /* uses the layout of bits */
+  pix_sat_free(p);   /* counts the bits */
+}
+
+/* number of black pixels of row y from x0 to x1 (inside the image) */
+int pix_bits_count(pix *p, int x0, int x1, int y) {
+  const pixword_t *w = p->bits + (size_t)y * p->bstride;
+  int i, i0 = x0 / PIXWORD_BITS, i1 = x1 / PIXWORD_BITS, n;
+  pixword_t m0 = ALL1 << (x0 % PIXWORD_BITS),
+            m1 = ALL1 >> (PIXWORD_BITS - 1 - x1 % PIXWORD_BITS);
+  if (x0 > x1) return 0;
+  if (i0 == i1) return WORD_POPCOUNT(w[i0] & m0 & m1);
+  n = WORD_POPCOUNT(w[i0] & m0);
+  for (i = i0 + 1; i < i1; i++) n += WORD_POPCOUNT(w[i]);
+  return n + WORD_POPCOUNT(w[i1] & m1);
+}
+
+/* first x of row y in x..x1 with color black (1) or white (0),
+ *  x1+1 if there is none, x and x1 inside the image */
+int pix_bits_next(pix *p, int x, int x1, int y, int black) {
+  const pixword_t *w = p->bits + (size_t)y * p->bstride;
+  pixword_t inv = (black) ? 0 : ALL1, v;
+  int i, i1 = x1 / PIXWORD_BITS;
+  if (x > x1) return x1 + 1;
+  i = x / PIXWORD_BITS;
+  v = (w[i] ^ inv) & (ALL1 << (x % PIXWORD_BITS));
+  while (!v) {
+    if (++i > i1) return x1 + 1;
+    v = w[i] ^ inv;
+  }
+  x = i * PIXWORD_BITS + WORD_CTZ(v);
+  return (x > x1) ? x1 + 1 : x;
+}
+
+/* same as pix_bits_next to the left, last x in x0..x or x0-1 */
+int pix_bits_prev(pix *p, int x, int x0, int y, int black) {
+  const pixword_t *w = p->bits + (size_t)y * p->bstride;
+  pixword_t inv = (black) ? 0 : ALL1, v;
+  int i, i0 = x0 / PIXWORD_BITS;
+  if (x < x0) return x0 - 1;
+  i = x / PIXWORD_BITS;
+  v = (w[i] ^ inv) & (ALL1 >> (PIXWORD_BITS - 1 - x % PIXWORD_BITS));
+  while (!v) {
+    if (--i < i0) return x0 - 1;
+    v = w[i] ^ inv;
+  }
+  x = i * PIXWORD_BITS + WORD_MSB(v);
+  return (x < x0) ? x0 - 1 : x;
+}
+
+/* ------------------ reduced planes (pyramid), v0.53 ------------------
+ * Behind the rows of p->bits pix_bits_init() stores PIX_PYR reduced
+ * planes for coarse decisions. Level l=1..PIX_PYR has one bit per
+ * 2^l x 2^l block of pixels (2x, 4x, 8x), the OR of 2x2 bits of level
+ * l-1 (level 0 is p->bits), same layout as p->bits with pyr_stride()
+ * words per row. put() sets the bits of new black pixels but does not
+ * clear them, so a 0 is exact (no black pixel in the block) and a 1
+ * means "may be black". scan_boxes() skips white blocks by level 3,
+ * detect_lines2() empty zones and detect_pictures() white margins.
+ */
+
+/* words per row and rows of level l */
+static int pyr_stride(pix *p, int l) {
+  return (((p->x + (1 << l) - 1) >> l) + PIXWORD_BITS - 1) / PIXWORD_BITS;
+}
+
+static int pyr_rows(pix *p, int l) {
+  return (p->y + (1 << l) - 1) >> l;
+}
+
+/* row y of level l, 0 = p->bits */
+static pixword_t *pyr_row(pix *p, int l, int y) {
+  pixword_t *w = p->bits;
+  int i;
+  for (i = 0; i < l; i++) w += (size_t)pyr_stride(p, i) * pyr_rows(p, i);
+  return w + (size_t)y * pyr_stride(p, l);
+}
+
+/* words of the levels 1..PIX_PYR */
+static size_t pyr_words(pix *p) {
+  size_t n = 0;
+  int l;
+  for (l = 1; l <= PIX_PYR; l++) n += (size_t)pyr_stride(p, l) * pyr_rows(p, l);
+  return n;
+}
+
+/* bit i = OR of the bits 2i and 2i+1 of w (lower half), all pairs of
+ *  the word at once by shifts and masks 0101.., 0011.., 00001111.. */
+static pixword_t pair_or(pixword_t w) {
+  int s;
+  w = (w | (w >> 1)) & (ALL1 / 3);
+  for (s = 1; 2 * s < PIXWORD_BITS; s <<= 1)
+    w = (w | (w >> s)) & (ALL1 / (((pixword_t)1 << (2 * s)) + 1));
+  return w;
+}
+
+typedef struct pyr_arg_s { pix *p; int l; } pyr_arg_t;
+
+/* rows i0..i1-1 of level a->l from level a->l-1 (tpool_for) */
+static void pyr_level_rows(void *arg, int i0, int i1, int id) {
+  pyr_arg_t *a = (pyr_arg_t *)arg;
+  pix *p = a->p;
+  pixword_t *s0, *s1, *d, lo, hi;
+  int y, i, l = a->l, sf = pyr_stride(p, l - 1), sd = pyr_stride(p, l),
+      nf = pyr_rows(p, l - 1);
+
+  for (y = i0; y < i1; y++) {
+    s0 = pyr_row(p, l - 1, 2 * y);
+    s1 = (2 * y + 1 < nf) ? pyr_row(p, l - 1, 2 * y + 1) : NULL;
+    d  = pyr_row(p, l, y);
+    for (i = 0; i < sd; i++) {
+      lo = (2 * i     < sf) ? s0[2 * i] | ((s1) ? s1[2 * i] : 0) : 0;
+      hi = (2 * i + 1 < sf) ? s0[2 * i + 1] | ((s1) ? s1[2 * i + 1] : 0) : 0;
+      d[i] = pair_or(lo) | (pair_or(hi) << (PIXWORD_BITS / 2));
+    }
+  }
+}
+
+/* levels 1..PIX_PYR from p->bits */
+static void pyr_build(pix *p, tpool_t *tp) {
+  pyr_arg_t a;
+  a.p = p;
+  for (a.l = 1; a.l <= PIX_PYR; a.l++)
+    tpool_for(tp, pyr_rows(p, a.l), pyr_level_rows, &a);
+}
+
+/* set the blocks of pixel x,y as black, see put() */
+static void pyr_set(pix *p, int x, int y) {
+  int l;
+  for (l = 1; l <= PIX_PYR; l++)
+    pyr_row(p, l, y >> l)[(x >> l) / PIXWORD_BITS]
+      |= (pixword_t)1 << ((x >> l) % PIXWORD_BITS);
+}
+
+/* first bit of w in x..x1 which is set, x1+1 if none */
+static int word_next(const pixword_t *w, int x, int x1) {
+  pixword_t v;
+  int i, i1 = x1 / PIXWORD_BITS;
+  if (x > x1) return x1 + 1;
+  i = x / PIXWORD_BITS;
+  v = w[i] & (ALL1 << (x % PIXWORD_BITS));
+  while (!v) {
+    if (++i > i1) return x1 + 1;
+    v = w[i];
+  }
+  x = i * PIXWORD_BITS + WORD_CTZ(v);
+  return (x > x1) ? x1 + 1 : x;
+}
+
+/* 1 if no block of level l in x0..x1, y0..y1 may be black (x0,y0 inside
+ *  the image, x1 and y1 are cut at the border) */
+int pix_pyr_empty(pix *p, int l, int x0, int x1, int y0, int y1) {
+  int y;
+  if (x1 >= p->x) x1 = p->x - 1;
+  if (y1 >= p->y) y1 = p->y - 1;
+  for (y = y0 >> l; y <= y1 >> l; y++)
+    if (word_next(pyr_row(p, l, y), x0 >> l, x1 >> l) <= x1 >> l) return 0;
+  return 1;
+}
+
+/* first black pixel of row y in x..x1, x1+1 if there is none,
+ *  white 8x8 blocks are skipped by the top level, same as
+ *  pix_bits_next(p, x, x1, y, 1) */
+int pix_black_next(pix *p, int x, int x1, int y) {
+  const pixword_t *w = pyr_row(p, PIX_PYR, y >> PIX_PYR);
+  int xe, b;
+  while (x <= x1) {
+    b = word_next(w, x >> PIX_PYR, x1 >> PIX_PYR);
+    if (b > x1 >> PIX_PYR) break;
+    if (x < (b << PIX_PYR)) x = b << PIX_PYR;
+    xe = x | ((1 << PIX_PYR) - 1); /* end of the block */
+    if (xe > x1) xe = x1;
+    b = pix_bits_next(p, x, xe, y, 1);
+    if (b <= xe) return b;
+    x = xe + 1;
+  }
+  return x1 + 1;
+}
+
+/* typical glyph height in pixels for --norm, 0 if unknown: the median
+ *  height of the 8-connected black blocks of level l, which are 2..64
+ *  blocks high (no dust, dots, rules or pictures), at most nmax of them
+ *  from the top of the page, words of a line give the height of the
+ *  line as well, at l=2 the result is a multiple of 4 */
+int pix_pyr_height(pix *p, int l, int nmax) {
+  const pixword_t *w;
+  unsigned char *seen;
+  int *stack, hist[65], wx, wy, ws, x, y, i, n, ns, y0, y1, nc = 0, h = 0;
+
+  if (!p->bits || l < 1 || l > PIX_PYR) return 0;
+  wx = (p->x + (1 << l) - 1) >> l; wy = pyr_rows(p, l);
+  ws = pyr_stride(p, l); w = pyr_row(p, l, 0);
+  seen = (unsigned char *)calloc((size_t)wx * wy, 1);
+  stack = (int *)malloc((size_t)wx * wy * sizeof(int));
+  if (!seen || !stack) { free(seen); free(stack); return 0; }
+  for (i = 0; i <= 64; i++) hist[i] = 0;
+#define PYR_BIT(xx,yy) ((w[(size_t)(yy) * ws + (xx) / PIXWORD_BITS] \
+                         >> ((xx) % PIXWORD_BITS)) & 1)
+  for (y = 0; y < wy && nc < nmax; y++)
+    for (x = word_next(w + (size_t)y * ws, 0, wx - 1); x < wx && nc < nmax;
+         x = word_next(w + (size_t)y * ws, x + 1, wx - 1)) {
+      if (seen[(size_t)y * wx + x]) continue;
+      seen[(size_t)y * wx + x] = 1;
+      stack[0] = y * wx + x; ns = 1; y0 = y1 = y;
+      while (ns) { /* flood fill, every block is pushed once */
+        int k = stack[--ns], bx = k % wx, by = k / wx, dx, dy;
+        if (by < y0) y0 = by;
+        if (by > y1) y1 = by;
+        for (dy = -1; dy <= 1; dy++)
+          for (dx = -1; dx <= 1; dx++) {
+            int xx = bx + dx, yy = by + dy;
+            if (xx < 0 || yy < 0 || xx >= wx || yy >= wy) continue;
+            if (seen[(size_t)yy * wx + xx] || !PYR_BIT(xx, yy)) continue;
+            seen[(size_t)yy * wx + xx] = 1;
+            stack[ns++] = yy * wx + xx;
+          }
+      }
+      if (y1 - y0 + 1 < 2 || y1 - y0 + 1 > 64) continue;
+      hist[y1 - y0 + 1]++; nc++;
+    }
+#undef PYR_BIT
+  free(seen); free(stack);
+  for (n = 0, i = 2; i <= 64; i++) {
+    n += hist[i];
+    if (2 * n >= nc) { h = i; break; }
+  }
+  return (nc) ? h << l : 0;
+}
+
+/* ------------------ precomputed 3x3 filter, v0.53 --------------------
+ * If n_run>0 getpixel() corrects pixels by the filt3 filters. Instead of
+ * walking the filter tree on every call, p->fbits holds one bit per pixel
+ * (same layout as p->bits), 1 = a filter matches and the pixel flips.
+ * The bits are computed word by word: the 3x3 neighbours of 64 pixels
+ * are the rows above, at and below shifted by one bit, every filter is
+ * an AND of 9 such words (or their complement), all filters are ORed.
+ * Black is pixel>>7==0 here (not cs), outside the image is black, as in
+ * pixel_filter_by_tree(). The plane is built at the first filtered
+ * getpixel() of an image with p->bits (the page, not box copies).
+ */
+
+/* black word i of row y (pixel<128), outside the image is black */
+static pixword_t fbits_black_word(pix *p, int y, int i) {
+  const unsigned char *s;
+  pixword_t v = 0;
+  int x, n;
+  if (y < 0 || y >= p->y || i < 0 || i >= p->bstride) return ALL1;
+  s = p->p + (size_t)y * p->x + i * PIXWORD_BITS;
+  n = p->x - i * PIXWORD_BITS;
+  if (n > PIXWORD_BITS) n = PIXWORD_BITS;
+  else if (n < PIXWORD_BITS) v = ALL1 << n; /* behind the right border */
+  for (x = 0; x < n; x++)
+    if (!(s[x] >> 7)) v |= (pixword_t)1 << x;
+  return v;
+}
+
+/* flip bits of one word, r[row][0..2] = black words i-1, i, i+1 */
+static pixword_t fbits_word(pixword_t r[3][3]) {
+  pixword_t nb[9], m, flip = 0;
+  int j, k;
+  for (j = 0; j < 3; j++) { /* neighbours x-1, x, x+1 of every bit */
+    nb[3*j+0] = (r[j][1] << 1) | (r[j][0] >> (PIXWORD_BITS - 1));
+    nb[3*j+1] =  r[j][1];
+    nb[3*j+2] = (r[j][1] >> 1) | (r[j][2] << (PIXWORD_BITS - 1));
+  }
+  for (j = 0; j < Nfilt3; j++) {
+    m = ALL1; /* 2=ignore_pixel, 0=white_background, 1=black_pixel */
+    for (k = 0; k < 9 && m; k++)
+      if (filt3[j][k] == 1) m &= nb[k]; else
+      if (filt3[j][k] == 0) m &= ~nb[k];
+    flip |= m;
+  }
+  return flip;
+}
+
+/* (re)compute the flip words i0..i1 of row y from the image bytes */
+static void fbits_update(pix *p, int y, int i0, int i1) {
+  pixword_t r[3][3];
+  int i, j;
+  if (y < 0 || y >= p->y) return;
+  if (i0 < 0) i0 = 0;
+  if (i1 >= p->bstride) i1 = p->bstride - 1;
+  for (i = i0; i <= i1; i++) {
+    for (j = 0; j < 3; j++) {
+      r[j][0] = fbits_black_word(p, y - 1 + j, i - 1);
+      r[j][1] = fbits_black_word(p, y - 1 + j, i    );
+      r[j][2] = fbits_black_word(p, y - 1 + j, i + 1);
+    }
+    p->fbits[(size_t)y * p->bstride + i] = fbits_word(r);
+  }
+}
+
+/* build p->fbits for the whole image, return 0 or -1 (no memory) */
+int pix_fbits_init(pix *p) {
+  pixword_t *row[3], *buf, r[3][3], *t;
+  int i, j, y, n;
+
+  pix_fbits_free(p);
+  if (!p->bits) return -1; /* bstride is set by pix_bits_init() */
+  p->fbits = (pixword_t *)malloc((size_t)p->bstride * p->y * sizeof(pixword_t));
+  n = p->bstride + 2; /* black rows with one word outside on each side */
+  buf = (pixword_t *)malloc(3 * n * sizeof(pixword_t));
+  if (!p->fbits || !buf) {
+    if (buf) free(buf);
+    pix_fbits_free(p);
+    return -1;
+  }
+  for (j = 0; j < 3; j++) {
+    row[j] = buf + j * n;
+    for (i = 0; i < n; i++) row[j][i] = fbits_black_word(p, j - 1, i - 1);
+  }
+  for (y = 0; y < p->y; y++) {
+    if (y) { /* shift the rows up, load row y+1 */
+      t = row[0]; row[0] = row[1]; row[1] = row[2]; row[2] = t;
+      for (i = 0; i < n; i++) row[2][i] = fbits_black_word(p, y + 1, i - 1);
+    }
+    for (i = 0; i < p->bstride; i++) {
+      for (j = 0; j < 3; j++) {
+        r[j][0] = row[j][i]; r[j][1] = row[j][i+1]; r[j][2] = row[j][i+2];
+      }
+      p->fbits[(size_t)y * p->bstride + i] = fbits_word(r);
+    }
+  }
+  free(buf);
+  return 0;
+}
+
+void pix_fbits_free(pix *p) {
+  if (p->fbits) free(p->fbits);
+  p->fbits = NULL;
+}
+
+/* ------------------ summed-area table, v0.53 -------------------------
+ * p->sat[y*(p->x+1)+x] is the number of black pixels (p->bits) left of
+ * column x and above row y, so the black pixels of any rectangle are
+ * counted by 4 lookups (get_bw, count_black). The entries are 16 bit
+ * and wrap around, the difference of the 4 lookups is exact for
+ * rectangles up to PIX_SAT_MAX pixels, bigger ones are counted on
+ * p->bits. put() only lowers p->saty, the first row which is not up to
+ * date. Rectangles above saty can still be counted, pix_sat_update()
+ * recomputes the rest.
+ */
+
+/* pass 1 of pix_sat_init: black pixels left of x in row y, rows i0..i1-1 */
+static void sat_rows(void *arg, int i0, int i1, int id) {
+  pix *p = (pix *)arg;
+  pixsat_t *s1;
+  unsigned n;
+  int x, y;
+  for (y = i0; y < i1; y++) {
+    s1 = p->sat + (size_t)(y + 1) * (p->x + 1);
+    s1[0] = 0;
+    for (n = 0, x = 0; x < p->x; x++) {
+      n += PIX_BIT(p, x, y);
+      s1[x + 1] = (pixsat_t)n;
+    }
+  }
+}
+
+/* pass 2: add the rows above, columns i0..i1-1 (of p->x+1) */
+static void sat_cols(void *arg, int i0, int i1, int id) {
+  pix *p = (pix *)arg;
+  pixsat_t *s0, *s1;
+  int x, y;
+  for (y = 1; y < p->y; y++) {
+    s0 = p->sat + (size_t)y * (p->x + 1);
+    s1 = s0 + p->x + 1;
+    for (x = i0; x < i1; x++) s1[x] += s0[x];
+  }
+}
+
+/* build p->sat from p->bits, return 0 or -1 (no memory),
+ *  rows and then columns on the threads of tp (NULL = 1) */
+int pix_sat_init(pix *p, tpool_t *tp) {
+  pix_sat_free(p);
+  if (!p->bits) return -1;
+  p->sat = (pixsat_t *)malloc((size_t)(p->x + 1) * (p->y + 1)
+                              * sizeof(pixsat_t));
+  if (!p->sat) return -1;
+  memset(p->sat, 0, (p->x + 1) * sizeof(pixsat_t)); /* row 0 */
+  tpool_for(tp, p->y, sat_rows, p);
+  tpool_for(tp, p->x + 1, sat_cols, p);
+  p->saty = p->y;
+  return 0;
+}
+
+/* recompute the rows from p->saty to the bottom */
+int pix_sat_update(pix *p) {
+  pixsat_t *s0, *s1;
+  unsigned n;
+  int x, y;
+  if (!p->sat) return -1;
+  for (y = p->saty; y < p->y; y++) {
+    s0 = p->sat + (size_t)y * (p->x + 1);
+    s1 = s0 + p->x + 1;
+    s1[0] = 0;
+    for (n = 0, x = 0; x < p->x; x++) {
+      n += PIX_BIT(p, x, y);
+      s1[x + 1] = (pixsat_t)(s0[x + 1] + n);
+    }
+  }
+  p->saty = p->y;
+  return 0;
+}
+
+void pix_sat_free(pix *p) {
+  if (p->sat) free(p->sat);
+  p->sat = NULL;
+}
+
+/* black pixels in x0..x1, y0..y1 (inside the image, y1 < p->saty,
+ *  at most PIX_SAT_MAX pixels) */
+int pix_sat_count(pix *p, int x0, int x1, int y0, int y1) {
+  const pixsat_t *a = p->sat + (size_t)y0 * (p->x + 1),
+                 *b = p->sat + (size_t)(y1 + 1) * (p->x + 1);
+  return (pixsat_t)(b[x1 + 1] - b[x0] - a[x1 + 1] + a[x0]);
 }
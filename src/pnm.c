@@ -25,12 +25,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
     v0.41  fix integer and heap overflow, change color output
     v0.46  fix blank spaces problem in filenames
     v0.52  2019-04 add handling of pam-format
+    v0.53  2026-10 file state moved from statics to pnm_stream_t
  */
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <ctype.h>
 #ifdef HAVE_UNISTD_H
 /* #include <unistd.h> */
 #endif
@@ -47,35 +49,21 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #endif
 
 #include "pnm.h"
+#include "tpool.h"
 #ifdef HAVE_PAM_H
 # include <pam.h>
 # include <sys/types.h>
 # include <sys/stat.h>
 # include <fcntl.h>
-#else
-# include <ctype.h>
 #endif
 
 #define EE()         fprintf(stderr,"\nERROR "__FILE__" L%d: ",__LINE__)
 #define E0(x0)       {EE();fprintf(stderr,x0 "\n");      }
+#define E1(x0,x1)    {EE();fprintf(stderr,x0 "\n",x1);   }
 #define F0(x0)       {EE();fprintf(stderr,x0 "\n");      exit(1);}
 #define F1(x0,x1)    {EE();fprintf(stderr,x0 "\n",x1);   exit(1);}
 #define F2(x0,x1,x2) {EE();fprintf(stderr,x0 "\n",x1,x2);exit(1);}
 
-/*
- * Weights to use for the different colours when converting a ppm
- * to greyscale.  These weights should sum to 1.0
- * 
- * The below values have been chosen to reflect the fact that paper
- * goes a reddish-yellow as it ages.
- *
- * v0.41: for better performance, we use integer instead of double
- *        this integer value divided by 1024 (2^10) gives the factor 
- */
-#define PPM_RED_WEIGHT   511  /* .499 */
-#define PPM_GREEN_WEIGHT 396  /* .387 */
-#define PPM_BLUE_WEIGHT  117  /* .114 */
-
 /*
     feel free to expand this list of usable converting programs
     Note 1: the last field must be NULL.
@@ -130,32 +118,31 @@ char *xlist[]={
   NULL
 };
 
-/* return a pointer to command converting file to pnm or NULL */
+/* return a pointer to command converting file to pnm or NULL
+ * v0.53: case insensitive, .JPG = .jpg, suffix must be at the end */
 char *testsuffix(char *name){
-  int i; char *rr;
+  int i, j, n, k;
 
+  n = strlen(name);
   for(i = 0; xlist[i] != NULL; i += 2 ) {
-    // ToDo: new version = no case sensitivity, .JPG = .jpg
-    //  xlen=length(xlist[i]);
-    //  rlen=length(rr);
-    //  if (xlen>rlen && strncasecmp(rr+rlen-xlen,xlist[i])==0) ...
-    // old version = case sensitivity!
-    if((rr=strstr(name, xlist[i])) != NULL)
-      if(strlen(rr)==strlen(xlist[i])) /* handle *.eps.pbm correct */
-        return xlist[i+1];
+    k = strlen(xlist[i]);
+    if (k > n) continue;
+    for (j = 0; j < k; j++) /* handle *.eps.pbm correct */
+      if (tolower((unsigned char)name[n-k+j]) != xlist[i][j]) break;
+    if (j == k) return xlist[i+1];
   }
   return NULL;
 }
 
 
-char read_char(FILE *f1){ // filter #-comments transparently
+/* nEOF: counter of the stream, was static before v0.53 */
+char read_char(FILE *f1, int *nEOF){ // filter #-comments transparently
   char c;                 // JS19 add vvv and output comments to stderr?
   int  m;
-  static int nEOF=0;
-  if (nEOF > 99) exit(1); /* JS1904 */
+  if (*nEOF > 99) exit(1); /* JS1904 */
   for(m=0;;){
     c=fgetc(f1);
-    if( feof(f1)   ) { E0("read feof"); m=0; nEOF++; } /* 2019-04 JS m=0 */
+    if( feof(f1)   ) { E0("read feof"); m=0; (*nEOF)++; } /* 2019-04 JS m=0 */
     if( ferror(f1) ) F0("read ferror");   /* exit */
     if( c == '#'  )  { m = 1; continue; } /* start comment */
     if( m ==  0   )  return c;            /* no comment, return */
@@ -163,6 +150,181 @@ char read_char(FILE *f1){ // filter #-comments transparently
   } // endless loop
 } // read_char
 
+/* initialize the state of a closed stream */
+void pnm_stream_init(pnm_stream_t *st) {
+  st->f1 = NULL;
+  st->pip = NULL;
+  st->c1 = 0;
+  st->nEOF = 0;
+  st->threads = 1;
+}
+
+/* close a stream left open after a multi-image, stdin is not closed */
+void pnm_stream_close(pnm_stream_t *st) {
+  if (st->f1 && st->f1 != stdin) {
+    if (!st->pip) fclose(st->f1);
+#ifdef HAVE_POPEN
+    else          pclose(st->f1);
+#endif
+  }
+  st->f1 = NULL;
+}
+
+/* read the first image of a file, the file is always closed after it
+ * (load_db, jconv), multi-image callers use readpgm_stream, v0.53 */
+int readpgm(char *name, pix *p, int vvv) {
+  pnm_stream_t st;
+  int rc;
+  pnm_stream_init(&st);
+  rc = readpgm_stream(&st, name, p, vvv);
+  pnm_stream_close(&st);
+  return rc;
+}
+
+
+/* tables to convert samples of maxval (1..65535) to 8bit gray, v0.53
+ *  gray = scale[wr[r]+wg[g]+wb[b]] or scale[v], the same values as the
+ *  three multiply+shift and the division by maxval per pixel before */
+typedef struct gray_lut_s {
+  unsigned maxval;
+  unsigned *wr, *wg, *wb; /* weighted r,g,b samples (maxval+1), or NULL */
+  unsigned char *scale;   /* 255*s/maxval for s=0..maxval+2 */
+} gray_lut_t;
+
+#define GRAY_LUT_1(t,v)       ((t)->scale[v])
+#define GRAY_LUT_RGB(t,r,g,b) ((t)->scale[(t)->wr[r]+(t)->wg[g]+(t)->wb[b]])
+
+/* return 0 on success, -1 if out of memory */
+static int gray_lut_init(gray_lut_t *t, unsigned maxval, int rgb) {
+  unsigned v;
+  t->maxval = maxval;
+  t->wr = t->wg = t->wb = NULL;
+  t->scale = (unsigned char *)malloc(maxval+3);
+  if (rgb) t->wr = (unsigned *)malloc(3*(maxval+1)*sizeof(unsigned));
+  if (!t->scale || (rgb && !t->wr)) {
+    free(t->scale); free(t->wr); t->scale=NULL; t->wr=NULL; return -1; }
+  /* rounded weights sum up to maxval+1 at most */
+  for (v=0; v<maxval+3; v++) t->scale[v] = 255*v/maxval;
+  if (rgb) {
+    t->wg = t->wr + maxval+1;
+    t->wb = t->wg + maxval+1;
+    for (v=0; v<=maxval; v++) {
+      t->wr[v] = (PPM_RED_WEIGHT   * v + 511)>>10;
+      t->wg[v] = (PPM_GREEN_WEIGHT * v + 511)>>10;
+      t->wb[v] = (PPM_BLUE_WEIGHT  * v + 511)>>10;
+    }
+  }
+  return 0;
+}
+
+static void gray_lut_free(gray_lut_t *t) {
+  free(t->scale); t->scale=NULL;
+  free(t->wr); t->wr = t->wg = t->wb = NULL;
+}
+
+/* rows of raw samples to gray, for tpool_for */
+typedef struct raw_conv_s {
+  unsigned char *buf;   /* rows of samples, NULL = 8bit samples in pic */
+  unsigned char *pic;
+  int nx, depth, bps;
+  unsigned maxval;
+  gray_lut_t *lut;
+} raw_conv_t;
+
+/* convert rows i0..i1-1 of buf to pic */
+static void raw_rows(void *arg, int i0, int i1, int id) {
+  raw_conv_t *c = (raw_conv_t *)arg;
+  unsigned char *s, *d;
+  unsigned maxval = c->maxval;
+  int x, y, nx = c->nx, bps = c->bps, n = c->depth * c->bps;
+  /* values above maxval are clipped, the tables end there */
+#define RAW_SAMPLE(k) ((bps==1) ? s[k] : (s[2*(k)]<<8)+s[2*(k)+1])
+#define RAW_CLIP(v)   (((unsigned)(v)>maxval) ? maxval : (unsigned)(v))
+  for (y = i0; y < i1; y++) {
+    d = c->pic + (size_t)y * nx;
+    if (!c->buf) { /* samples are in pic already */
+      for (x = 0; x < nx; x++) d[x] = GRAY_LUT_1(c->lut, RAW_CLIP(d[x]));
+      continue;
+    }
+    s = c->buf + (size_t)y * n * nx;
+    if (c->depth==1)
+      for (x=0;x<nx;x++,s+=n)
+        d[x]=GRAY_LUT_1(c->lut, RAW_CLIP(RAW_SAMPLE(0)));
+    else
+      for (x=0;x<nx;x++,s+=n)
+        d[x]=GRAY_LUT_RGB(c->lut, RAW_CLIP(RAW_SAMPLE(0)),
+                                  RAW_CLIP(RAW_SAMPLE(1)),
+                                  RAW_CLIP(RAW_SAMPLE(2)));
+  }
+#undef RAW_SAMPLE
+#undef RAW_CLIP
+}
+
+#define RAW_ROWS 64 /* rows per fread, if converted on threads */
+
+/* raw samples of 1 or 2 bytes (MSB first), 1 (P5) or 3 (P6, P7 RGB) per
+ *  pixel, v0.53
+ *  whole rows by fread instead of one fread per pixel, the pixels
+ *  are copied to the malloc'ed pic anyway (the engine changes and
+ *  frees it), so mmap would not save the copy, pipes and stdin work too
+ *  with threads>1 RAW_ROWS rows are read and converted on the threads */
+static void read_raw(FILE *f1, unsigned char *pic, int nx, int ny,
+                     int depth, int bps, unsigned maxval, int threads) {
+  gray_lut_t lut;
+  raw_conv_t c;
+  tpool_t *tp;
+  int y, m, k, n=depth*bps, rows=1;
+  if (depth==1 && bps==1) {
+    if (ny!=(int)fread(pic,nx,ny,f1)) {
+      fprintf(stderr," ERROR reading byte %d*%d*%d\n", 1, 1, nx*ny);
+      exit(1); }
+    if (maxval==255) return;
+  }
+  if (maxval < 1) maxval = 1;
+  if (gray_lut_init(&lut, maxval, depth==3)) F0("memory failed");
+  tp = tpool_new(threads); /* NULL = 1 thread */
+  c.buf = NULL; c.pic = pic; c.nx = nx; c.depth = depth; c.bps = bps;
+  c.maxval = maxval; c.lut = &lut;
+  if (depth==1 && bps==1) { /* samples are in pic already */
+    tpool_for(tp, ny, raw_rows, &c);
+    tpool_free(tp); gray_lut_free(&lut); return;
+  }
+  if (tp) rows = RAW_ROWS;
+  c.buf=(unsigned char *)malloc((size_t)n*nx*rows);
+  if (!c.buf && rows > 1) { /* try one row */
+    rows = 1; c.buf=(unsigned char *)malloc(n*nx); }
+  if (!c.buf) F0("memory failed");
+  for (y=0;y<ny;y+=m) {
+    m = (ny-y < rows) ? ny-y : rows;
+    k = (int)fread(c.buf,n,(size_t)nx*m,f1);
+    if (k!=nx*m) {
+      fprintf(stderr," ERROR reading byte %d*%d*%d\n", depth, bps,
+        (y+k/nx)*nx);
+      exit(1); }
+    c.pic = pic + (size_t)y*nx;
+    tpool_for(tp, m, raw_rows, &c);
+  }
+  free(c.buf);
+  tpool_free(tp);
+  gray_lut_free(&lut);
+}
+
+/* raw PBM, 8 pixels per byte by a table of 8 byte words, v0.53 */
+static void read_pbm_raw(FILE *f1, unsigned char *pic, int nx, int ny) {
+  unsigned char lut[256][8], *row, *d;
+  int x, y, b, bpl=(nx+7)>>3;
+  for (b=0;b<256;b++)
+    for (x=0;x<8;x++) lut[b][x]=((b<<x)&128)?0:255; /* 1=black */
+  row=(unsigned char *)malloc(bpl);
+  if (!row) F0("memory failed");
+  for (y=0;y<ny;y++) {
+    if (1!=(int)fread(row,bpl,1,f1)) F0("read");
+    d=pic+y*nx;
+    for (x=0;x+8<=nx;x+=8) memcpy(d+x,lut[row[x>>3]],8);
+    if (x<nx) memcpy(d+x,lut[row[x>>3]],nx-x);
+  }
+  free(row);
+}
 
 /*
    for simplicity only PAM of netpbm is used, the older formats
@@ -170,32 +332,30 @@ char read_char(FILE *f1){ // filter #-comments transparently
    v0.43: return 1 if multiple file (hold it open), 0 otherwise
  */
 #ifdef HAVE_PAM_H
-int readpgm(char *name, pix * p, int vvv) {
-  static FILE *fp=NULL;
-  static char *pip; 
+int readpgm_stream(pnm_stream_t *st, char *name, pix * p, int vvv) {
+  FILE *fp=st->f1;
   char magic1, magic2;
-  int i, j, sample, minv = 0, maxv = 0, eofP=0;
+  int i, j, minv = 0, maxv = 0, eofP=0;
   struct pam inpam;
   tuple *tuplerow;
 
   assert(p);
 
   if (!fp) { // fp!=0 for multi-pnm and idx>0
+    st->pip = NULL;
     /* open file; test if conversion is needed. */
     if (name[0] == '-' && name[1] == '\0') { /* - means /dev/stdin */
       fp = stdin;
       SET_BINARY (fileno(fp)); /* Windows-OS needs it for correct work */
     }
     else {
-      pip = testsuffix(name);
-      if (!pip) {
-        fp = fopen(name, "rb");
-        if (!fp)
-          F1("opening file %s", name);
-      }
-      else { /* ToDo: test bad names containing ;|"$() utf8 etc., safety */ 
-        char *buf = (char *)malloc((strlen(pip)+strlen(name)+4));
-        sprintf(buf, "%s \"%s\"", pip, name); /* allow spaces in filename */
+      /* png, jpeg, gz are decoded in process, pnm is opened, v0.53 */
+      i = readimg(st, name, p, vvv);
+      if (i < 1) return i; /* decoded (0) or error (-1), no exit() */
+      fp = st->f1;
+      if (!fp) { /* ToDo: test bad names containing ;|"$() utf8 etc., safety */ 
+        char *buf = (char *)malloc((strlen(st->pip)+strlen(name)+4));
+        sprintf(buf, "%s \"%s\"", st->pip, name); /* allow spaces in filename */
         if (vvv) {
           fprintf(stderr, "# popen( %s )\n", buf);
         }
@@ -213,11 +373,12 @@ int readpgm(char *name, pix * p, int vvv) {
 #else
         F0("sorry, compile with HAVE_POPEN to use pipes");
 #endif
-        if (!fp)
-          F1("opening pipe %s", buf);
+        if (!fp) {
+          E1("opening pipe %s", buf); free(buf); return -1; }
         free(buf);
       }
     }
+    st->f1 = fp;
   }
 
   /* netpbm 0.10.36 tries to write a comment to nonzero char** comment_p */
@@ -252,37 +413,57 @@ int readpgm(char *name, pix * p, int vvv) {
     F0("Error integer overflow");
   if ( !(p->p = (unsigned char *)malloc(p->x*p->y)) )
     F1("Error at malloc: p->p: %d bytes", p->x*p->y);
-  tuplerow = pnm_allocpamrow(&inpam);
-  for ( i=0; i < inpam.height; i++ ) {
-    pnm_readpamrow(&inpam, tuplerow);   /* exit on error */
-    for ( j = 0; j < inpam.width; j++ ) {
+  /* fast path for raw 8/16bit and raw PBM, v0.53 */
+  if (inpam.bytes_per_sample <= 2
+   && (inpam.format == RPGM_FORMAT || inpam.format == RPPM_FORMAT
+    || (inpam.format == PAM_FORMAT && (inpam.depth == 1 || inpam.depth == 3))))
+    read_raw(fp, p->p, p->x, p->y, inpam.depth, inpam.bytes_per_sample,
+             inpam.maxval, st->threads);
+  else if (inpam.format == RPBM_FORMAT)
+    read_pbm_raw(fp, p->p, p->x, p->y);
+  else { /* plain formats, PAM with alpha, v0.53: table lookups */
+    gray_lut_t lut;
+    unsigned char *d;
+    sample mv = inpam.maxval;
+#define PAM_CLIP(v) (((v)>mv) ? mv : (v))
+    if (gray_lut_init(&lut, inpam.maxval, inpam.depth>=3))
+      F0("Error at malloc: gray_lut");
+    tuplerow = pnm_allocpamrow(&inpam);
+    for ( i=0; i < inpam.height; i++ ) {
+      pnm_readpamrow(&inpam, tuplerow);   /* exit on error */
+      d = p->p + i*inpam.width;
       if (inpam.depth>=3)
-        /* tuplerow is unsigned long (see pam.h sample) */
-        /* we expect 8bit or 16bit integers,
-           no overflow up to 32-10-2=20 bits */
-        sample
-          = ((PPM_RED_WEIGHT   * tuplerow[j][0] + 511)>>10)
-          + ((PPM_GREEN_WEIGHT * tuplerow[j][1] + 511)>>10)
-          + ((PPM_BLUE_WEIGHT  * tuplerow[j][2] + 511)>>10);
+        for ( j = 0; j < inpam.width; j++ )
+          d[j] = GRAY_LUT_RGB(&lut, PAM_CLIP(tuplerow[j][0]),
+                                    PAM_CLIP(tuplerow[j][1]),
+                                    PAM_CLIP(tuplerow[j][2]));
       else
-        sample = tuplerow[j][0];
-      sample = 255 * sample / inpam.maxval; /* normalize to 8 bit */
-      p->p[i*inpam.width+j] = sample;
-      if (maxv<sample) maxv=sample;
-      if (minv>sample) minv=sample;
+        for ( j = 0; j < inpam.width; j++ )
+          d[j] = GRAY_LUT_1(&lut, PAM_CLIP(tuplerow[j][0]));
     }
+#undef PAM_CLIP
+    pnm_freepamrow(tuplerow);
+    gray_lut_free(&lut);
   }
-  pnm_freepamrow(tuplerow);
+  if (vvv)
+    for (i = 0; i < p->x * p->y; i++) {
+      if (maxv < p->p[i]) maxv = p->p[i];
+      if (minv > p->p[i]) minv = p->p[i];
+    }
   pnm_nextimage(fp,&eofP);
   if (vvv)
     fprintf(stderr,"# readpam: min=%d max=%d eof=%d\n", minv, maxv, eofP);
   p->bpp = 1;
+  p->bits = NULL;
+  p->fbits = NULL;
+  p->sat = NULL;
+  p->marks = NULL;
   if (eofP) {
-    if (!pip) fclose(fp);
+    if (!st->pip) fclose(fp);
 #ifdef HAVE_POPEN
-    else      pclose(fp);	/* close pipe (v0.43) */
+    else          pclose(fp);	/* close pipe (v0.43) */
 #endif
-    fp=NULL; return 0; 
+    st->f1=NULL; return 0; 
   }
   return 1; /* multiple image = concatenated pnm */
 }
@@ -293,11 +474,11 @@ int readpgm(char *name, pix * p, int vvv) {
    which is not so powerful but needs no dependencies from other libs
    bps: bytes per sample, values=0...((256^bps)-1)
  */
-static int fread_num(char *buf, int bps, FILE *f1) { /* read sample */
+static int fread_num(char *buf, int bps, FILE *f1, int *nEOF) { /* read sample */
   int mode, j2, j3; char c1;
   for (j2=0;j2<bps;j2++) buf[j2]=0; // initialize value to zero
   for(mode=0;!feof(f1);){ // mod=0: skip leading spaces, 1: scan digits
-    c1=read_char(f1);     // filter out #-comments inclusive 1st \n
+    c1=read_char(f1,nEOF); // filter out #-comments inclusive 1st \n
     if (isspace(c1)) { if (mode==0) continue; else break; }
     mode=1; // digits scan mode
     if( !isdigit(c1) ) F0("unexpected char");
@@ -313,6 +494,7 @@ static int fread_num(char *buf, int bps, FILE *f1) { /* read sample */
 /*
  * read image file, used to read the OCR-image and database images,
  * image file can be PBM/PGM/PPM in RAW or TEXT
+ *   st:   state of the open file, init by pnm_stream_init (input/output)
  *   name: filename of image (input)
  *   p:    pointer where to store the loaded image (input)
  *   vvv:  verbose mode (input)
@@ -324,30 +506,29 @@ P1
 000001 0 1 0 0 1 1 
 P16 2 000001 010011 # also valid
  */
-int readpgm( char *name, pix *p, int vvv){
-  static char c1, c2;           /* magic bytes, file type */
-  static char *pip;             // static to survive multiple calls
+int readpgm_stream(pnm_stream_t *st, char *name, pix *p, int vvv){
+  char c1, c2;                  /* magic bytes, file type */
   int  number=0, nx=0,ny=0,nc=0, mod=0,
        i, j; // nc=num_color, mod=read_modus
-  static FILE *f1=NULL;         // trigger read new file or multi image file
+  FILE *f1=st->f1;              // trigger read new file or multi image file
   unsigned char *pic;
   char buf[512];
-  int lx, ly, dx;
   int bps=1; /* bps: bytes per sample, values=0...((256^bps)-1) */
   int depth=1; /* number of planes or channels, gray=1 RGB=3 JS1904 */
   char pam_token[8+1], tupletype[9+1];  /* PAM format: P7\n[# comments\n] */ 
 
   if (!f1) {  /* first of multiple image, on MultipleImageFiles c1 was read */
-    pip=NULL;
+    st->pip=NULL;
     if (name[0]=='-' && name[1]==0) {
       f1=stdin;  /* is this correct ??? */
       SET_BINARY (fileno(f1)); // Windows needs it for correct work
     } else {
-      pip=testsuffix(name);
-      if (!pip) {
-        f1=fopen(name,"rb"); if (!f1) F1("opening file %s",name);
-      } else {  // sprintf(buf,"%s \"%s\"",pip,name); /* snprintf simu */
-        for(i=0;i<sizeof(buf)-4 && pip[i];i++) buf[i]=pip[i];
+      /* png, jpeg, gz are decoded in process, pnm is opened, v0.53 */
+      i=readimg(st,name,p,vvv);
+      if (i<1) return i; /* decoded (0) or error (-1) */
+      f1=st->f1;
+      if (!f1) {  // sprintf(buf,"%s \"%s\"",pip,name); /* snprintf simu */
+        for(i=0;i<sizeof(buf)-4 && st->pip[i];i++) buf[i]=st->pip[i];
         buf[i++]=' '; buf[i++]='"';
         for(j=0;i<sizeof(buf)-3 && name[j];i++,j++) buf[i]=name[j];
         buf[i++]='"'; buf[i++]=0;
@@ -363,11 +544,13 @@ int readpgm( char *name, pix *p, int vvv){
 #else
         F0("only PNM files supported (compiled without HAVE_POPEN)");
 #endif
-        if (!f1) F1("opening pipe %s",buf);
+        if (!f1) { E1("opening pipe %s",buf); return -1; }
       } /* file/pipe */
     } /* stdin or file/pipe */
+    st->f1=f1;
     c1=fgetc(f1); if (feof(f1)) { E0("unexpected EOF"); return -1; }
   } /* if closed, open file and read 1st char, if open c1 was read  */
+  else c1=st->c1;
   c2=fgetc(f1);   if (feof(f1)) { E0("unexpected EOF"); return -1; }
   // check the first two bytes of the PNM file 
   //         PBM   PGM   PPM  PAM
@@ -378,7 +561,7 @@ int readpgm( char *name, pix *p, int vvv){
                    " position %ld", fileno(f1), ftell(f1));
     fprintf(stderr,"\nread-PNM-error: bad magic bytes, expect 0x50 0x3[1-7]"
                    " but got 0x%02x 0x%02x", 255&c1, 255&c2);
-    if (f1) fclose(f1); f1=NULL; return(-1);
+    if (f1) fclose(f1); st->f1=NULL; return(-1);
   }
   /* use pnmtoplainpnm to convert from regular PBM to Plain PBM = ASCII */
   pam_token[0]=0; tupletype[0]=0; /* ini P7 string buffers */
@@ -389,7 +572,7 @@ int readpgm( char *name, pix *p, int vvv){
         ||   (c2=='7');)                        /* PAM header strings */
   {						// mode: 0,2,4=[ \t\r\n] 
   						//   1=nx 3=ny 5=nc 8-13=#rem
-    c1=read_char(f1); // filter out #-comments inclusive 1st \n
+    c1=read_char(f1,&st->nEOF); // filter out #-comments inclusive 1st \n
     // en.wikipedia.org/wiki/Netpbm_format, 2019-04-06 add comments '#'
     //  isspace = [\ \f\n\r\t\v]
 // if (vvv) fprintf(stderr,"#DBG c1=%c mod=%d numb=%d i=%d\n",c1,mod,number,i);
@@ -452,10 +635,13 @@ int readpgm( char *name, pix *p, int vvv){
   if ( (nx*ny)!=((1.*nx)*ny) || nx<=0 || ny<=0) F0("integer overflow");
   pic=(unsigned char *)malloc( nx*ny );
   if(pic==NULL)F0("memory failed");			// no memory
-  for (i=0;i<nx*ny;i++) pic[i]=255; // init to white if reading fails 
+  memset(pic,255,nx*ny); // init to white if reading fails 
   /* this is a slow but short routine for P1 to P6 formats */
   // we want to normalize brightness to 0..255
   // JS1904 simplified PGM/PPM/PAM code
+  if ((c2=='5' || c2=='6' || c2=='7') && bps<=2 && (depth==1 || depth==3))
+    read_raw(f1, pic, nx, ny, depth, bps, nc, st->threads); /* v0.53 */
+  else
   if (c2=='2' || c2=='3' || (c2>='5' && c2<='7')) { // PGM/PPM/PAM-RAW/ASC
     for (i=0;i<nx*ny;i++) {  // read single pixels (slow IO)
       if (c2>='5' && c2<='7') {
@@ -463,7 +649,7 @@ int readpgm( char *name, pix *p, int vvv){
         if (depth*bps!=(int)fread(buf,1,depth*bps,f1)){  // PPM-RAW
          fprintf(stderr," ERROR reading byte %d*%d*%d\n", depth, bps, i);
          exit(1); /* break;? */ } } // for i
-      else for (j=0;j<depth;j++) fread_num(buf+j*bps, bps, f1); // PPM-PLAIN
+      else for (j=0;j<depth;j++) fread_num(buf+j*bps, bps, f1, &st->nEOF); // PPM-PLAIN
       if (depth<3) pic[i]=buf[0]; /* JS1903 PPM+PAM */
       else pic[i]
           = ((PPM_RED_WEIGHT   * (unsigned char)buf[  bps-1] + 511)>>10)
@@ -474,27 +660,23 @@ int readpgm( char *name, pix *p, int vvv){
   }
   if( c2=='1' )  // PBM-PLAIN
     for(mod=j=i=0,nc=255;i<nx*ny && !feof(f1);){ // PBM-ASCII 0001100
-    c1=read_char(f1);
+    c1=read_char(f1,&st->nEOF);
     if( isdigit(c1) ) { pic[i]=((c1=='0')?255:0); i++; }
     else if( !isspace(c1) )F0("unexpected char");
   }
   if( c2=='4' ){ // PBM-RAW
-    dx=(nx+7)&~7;				// dx
-    if(ny!=(int)fread(pic,dx>>3,ny,f1))F0("read");	// read all bytes
-    for(ly=ny-1;ly>=0;ly--)
-    for(lx=nx-1;lx>=0;lx--)
-    pic[lx+ly*nx]=( (128 & (pic[(lx+ly*dx)>>3]<<(lx & 7))) ? 0 : 255 );
+    read_pbm_raw(f1, pic, nx, ny);
     nc=255;
   }
-  {
+  if (vvv) {
     int minc=255, maxc=0;
     for (i=0;i<nx*ny;i++) {
       if (pic[i]>maxc) maxc=pic[i];
       if (pic[i]<minc) minc=pic[i];
     }
-    if (vvv) fprintf(stderr," min=%d max=%d", minc, maxc);
+    fprintf(stderr," min=%d max=%d", minc, maxc);
   }
-  p->p=pic;  p->x=nx;  p->y=ny; p->bpp=1;
+  p->p=pic;  p->x=nx;  p->y=ny; p->bpp=1; p->bits=NULL; p->fbits=NULL; p->sat=NULL; p->marks=NULL;
   if (vvv) fprintf(stderr,"\n");  
   c1=0; c1=fgetc(f1); /* needed to trigger feof() */
   while ((!feof(f1)) && (c1==' ' || c1=='\n' || c1=='\r' || c1=='\t'))
@@ -505,19 +687,92 @@ int readpgm( char *name, pix *p, int vvv){
     if (vvv && (!feof(f1)) && c1!='P' )
        fprintf(stderr,"# PNM unexpected char 0x%02x\n",(int)c1);
     if(name[0]!='-' || name[1]!=0){ /* do not close stdin */
-      if(!pip) fclose(f1);
+      if(!st->pip) fclose(f1);
 #ifdef HAVE_POPEN
-      else     pclose(f1);	/* close pipe (Jul00) */
+      else         pclose(f1);	/* close pipe (Jul00) */
 #endif
     } // stdin
-    f1=NULL;  /* set file is closed flag */
+    st->f1=NULL;  /* set file is closed flag */
     return 0;
   }
   if (!feof(f1) && c1=='P' && vvv) fprintf(stderr,"# PNM multi-image\n"); 
+  st->c1=c1;  /* read ahead, used by the next call */
   return 1; /* multiple image = concatenated pnm's */
 }
 #endif /* HAVE_PAM_H */
 
+/* decimal number of a pnm header, skipping spaces and #-comments,
+ *  the single space after the last number is read too, -1 on error */
+static int pnm_hdr_num(FILE *f1) {
+  int c, n=0, digits=0;
+  for (;;) {
+    c=fgetc(f1);
+    if (c=='#') { while (c!=EOF && c!='\n') c=fgetc(f1); continue; }
+    if (c==EOF) return -1;
+    if (isspace(c)) { if (digits) return n; continue; }
+    if (!isdigit(c) || n > 0x7fffffff/10 - 9) return -1;
+    n=n*10+c-'0'; digits++;
+  }
+}
+
+/* open a raw pnm file (P4 P5 P6) for reading in parts of rows, v0.53
+ *  return 0 if r is open, 1 if it is no raw pnm (st is set for
+ *  readpgm_stream then, stdin is not rewound), -1 on error */
+int pnm_rows_open(pnm_rows_t *r, pnm_stream_t *st, char *name, int vvv) {
+  int c1, c2;
+  r->f1=NULL; r->yread=0;
+  if (name[0]=='-' && name[1]==0) {
+    r->f1=stdin;
+    SET_BINARY (fileno(stdin));
+  } else { /* other formats go to readpgm_stream (magic bytes) */
+    r->f1=fopen(name,"rb");
+    if (!r->f1) { E1("opening file %s",name); return -1; }
+  }
+  c1=fgetc(r->f1);
+  c2=fgetc(r->f1);
+  if (c1!='P' || c2<'4' || c2>'6') {
+    if (r->f1!=stdin) { fclose(r->f1); r->f1=NULL; return 1; }
+    if (c1==EOF || c2==EOF) { E0("unexpected EOF"); return -1; }
+    ungetc(c2, stdin); /* readpgm_stream continues with c1 */
+    pnm_stream_init(st);
+    st->f1=stdin; st->c1=c1;
+    r->f1=NULL;
+    return 1;
+  }
+  r->type=c2;
+  r->x=pnm_hdr_num(r->f1);
+  r->y=pnm_hdr_num(r->f1);
+  r->maxval=(c2=='4') ? 1 : pnm_hdr_num(r->f1);
+  if (r->x<1 || r->y<1 || r->maxval<1 || r->maxval>65535
+   || (1.*r->x)*r->y*3 > 2147483647.) {
+    E0("bad pnm header");
+    if (r->f1!=stdin) fclose(r->f1);
+    r->f1=NULL; return -1;
+  }
+  r->depth=(c2=='6') ? 3 : 1;
+  r->bps=(r->maxval>255) ? 2 : 1;
+  if (vvv)
+    fprintf(stderr,"# PNM P%c h*w=%d*%d c=%d read by rows\n",
+      c2, r->y, r->x, r->maxval);
+  return 0;
+}
+
+/* read the next n rows (or less at the end) to pic, return rows read */
+int pnm_rows_read(pnm_rows_t *r, unsigned char *pic, int n) {
+  if (n > r->y - r->yread) n = r->y - r->yread;
+  if (n <= 0) return 0;
+  if (r->type=='4') read_pbm_raw(r->f1, pic, r->x, n);
+  else read_raw(r->f1, pic, r->x, n, r->depth, r->bps, r->maxval, 1);
+  r->yread += n;
+  return n;
+}
+
+/* close the file of pnm_rows_open, stdin is not closed */
+void pnm_rows_close(pnm_rows_t *r) {
+  if (r->f1 && r->f1!=stdin) fclose(r->f1);
+  r->f1=NULL;
+}
+
 int writepgm(char *nam,pix *p){// P5 raw-pgm
   FILE *f1;int a,x,y;
   f1=fopen(nam,"wb");if(!f1)F0("open");		// open-error
@@ -12,17 +12,83 @@
 #define GOCR_PNM_H 1
 
 #include "config.h"
+#include <stdio.h>
+
+struct job_s;
+
+/*
+ * Weights to use for the different colours when converting a ppm
+ * to greyscale.  These weights should sum to 1.0
+ * 
+ * The below values have been chosen to reflect the fact that paper
+ * goes a reddish-yellow as it ages.
+ *
+ * v0.53: shared by pnm.c and readimg.c
+ * v0.41: for better performance, we use integer instead of double
+ *        this integer value divided by 1024 (2^10) gives the factor 
+ */
+#define PPM_RED_WEIGHT   511  /* .499 */
+#define PPM_GREEN_WEIGHT 396  /* .387 */
+#define PPM_BLUE_WEIGHT  117  /* .114 */
+
+/* word of the packed black plane (pix.bits), v0.53 */
+typedef unsigned long pixword_t;
+#define PIXWORD_BITS ((int)(8*sizeof(pixword_t)))
+/* entry of the summed-area table (pix.sat), counts modulo 2^16, v0.53 */
+typedef unsigned short pixsat_t;
 
 struct pixmap {
    unsigned char *p;	/* pointer of image buffer (pixmap) */
    int x;		/* xsize */
    int y;		/* ysize */
    int bpp;		/* bytes per pixel:  1=gray 3=rgb */
+   struct job_s *job;	/* owning job (cfg, n_run for getpixel), v0.53 */
+   pixword_t *bits;	/* 1 bit per pixel, 1=black (<bcs), or NULL,
+			   followed by 2x,4x,8x reduced planes */
+   int bstride;		/* words per row of bits */
+   int bcs;		/* threshold of bits */
+   pixword_t *fbits;	/* 3x3 filter flips (getpixel, n_run>0), or NULL */
+   pixsat_t *sat;	/* summed-area table of bits, (x+1)*(y+1), or NULL */
+   int saty;		/* image rows 0..saty-1 are up to date in sat */
+   unsigned char *marks; /* scan marks (3 bit) + epoch, or NULL, v0.53 */
+   unsigned char mepoch; /* epoch of valid marks, see pix_marks_init() */
  };
 typedef struct pixmap pix;
 
-/* return 1 on multiple images (holding file open), 0 else */
+/* state of an open (multi-image) input file, replaces statics v0.53 */
+typedef struct pnm_stream_s {
+   FILE *f1;		/* open file or pipe, NULL if closed */
+   char *pip;		/* conversion command, if f1 is a pipe */
+   char c1;		/* 1st magic byte of the next image (read ahead) */
+   int nEOF;		/* unexpected EOFs, stop on endless loops */
+   int threads;		/* threads for the conversion to gray (--threads) */
+} pnm_stream_t;
+
+void pnm_stream_init(pnm_stream_t *st);
+void pnm_stream_close(pnm_stream_t *st);
+
+/* return 1 on multiple images (holding st open), 0 else, -1 on error */
+int readpgm_stream(pnm_stream_t *st, char *name, pix *p, int vvv);
+/* read 1st image only, return 1 if further images were ignored */
 int readpgm(char *name, pix *p, int vvv);
+/* raw pnm (P4 P5 P6) read in parts of rows, gocr --band, v0.53 */
+typedef struct pnm_rows_s {
+   FILE *f1;		/* open file or stdin, NULL if closed */
+   int x, y;		/* size of the image */
+   int type;		/* '4', '5' or '6' */
+   int depth, bps, maxval;
+   int yread;		/* rows read */
+} pnm_rows_t;
+int  pnm_rows_open(pnm_rows_t *r, pnm_stream_t *st, char *name, int vvv);
+int  pnm_rows_read(pnm_rows_t *r, unsigned char *pic, int n);
+void pnm_rows_close(pnm_rows_t *r);
+
+/* return the command converting file name to pnm (suffix) or NULL */
+char *testsuffix(char *name);
+/* open a file for readpgm_stream, decode png, jpeg, gz in process (readimg.c)
+ * return 0 if decoded to p, 1 if st->f1 is pnm data or st->pip must be
+ * opened, -1 on error, v0.53 */
+int readimg(pnm_stream_t *st, char *name, pix *p, int vvv);
 
 /* write pgm-map to pnm-file */
 int writepgm(char *nam, pix *p);
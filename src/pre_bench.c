@@ -0,0 +1,167 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2026  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ benchmark for the preprocessing on 1..n threads (tpool.c), times of
+ the conversion to gray (read), otsu_thresholding, local_thresholding
+ (sauvola), packed plane (bits) and summed-area table (sat) of one
+ page, the results must be the same for all thread counts
+ (not build by default)
+
+ usage: make pre_bench
+        pdftoppm -r 600 x.pdf page     # color ppm, read converts rgb
+        ./pre_bench page-1.ppm [threads [repeat]]
+
+ the best time of repeat runs is printed, wall clock time (not cpu)
+ */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#endif
+#include "pgm2asc.h"
+#include "otsu.h"
+#include "tpool.h"
+
+#define NSTEP 5
+static const char *step_name[NSTEP] = { "read", "otsu", "local", "bits",
+                                        "sat" };
+
+static double now_ms(void) {
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval t;
+  gettimeofday(&t, NULL);
+  return t.tv_sec * 1e3 + t.tv_usec * 1e-3;
+#else
+  return 0;
+#endif
+}
+
+/* results of one thread count, compared against 1 thread */
+typedef struct res_s {
+  unsigned char *gray, *otsu, *local;
+  pixword_t *bits;
+  pixsat_t *sat;
+} res_t;
+
+static void res_free(res_t *r) {
+  free(r->gray); free(r->otsu); free(r->local); free(r->bits); free(r->sat);
+  memset(r, 0, sizeof(*r));
+}
+
+/* one run of all steps on nt threads, ms[] gets the times,
+ *  returns 0 and the size x*y or -1 on error */
+static int run(char *name, int nt, double *ms, res_t *r, int *x, int *y) {
+  pnm_stream_t st;
+  pix p;
+  tpool_t *tp;
+  size_t n;
+  double t0;
+
+  memset(&p, 0, sizeof(p));
+  pnm_stream_init(&st);
+  st.threads = nt;
+  t0 = now_ms();
+  if (readpgm_stream(&st, name, &p, 0) < 0) return -1;
+  ms[0] = now_ms() - t0;
+  pnm_stream_close(&st);
+  n = (size_t)p.x * p.y;
+  tp = tpool_new(nt); /* as pgm2asc(), one pool for the steps */
+  r->gray = p.p;
+  r->otsu = (unsigned char *)malloc(n);
+  r->local = (unsigned char *)malloc(n);
+  if (!r->otsu || !r->local) { tpool_free(tp); return -1; }
+  memcpy(r->otsu, p.p, n);
+  memcpy(r->local, p.p, n);
+
+  t0 = now_ms();
+  otsu_thresholding(r->otsu, p.x, p.y, 0, 0, p.x, p.y, 0, 0, tp);
+  ms[1] = now_ms() - t0;
+  t0 = now_ms();
+  local_thresholding(r->local, p.x, p.y, 0, 0, p.x, p.y, 1, 0, 0, 0, tp);
+  ms[2] = now_ms() - t0;
+
+  p.p = r->otsu;
+  t0 = now_ms();
+  if (pix_bits_init(&p, 160, tp)) { tpool_free(tp); return -1; }
+  ms[3] = now_ms() - t0;
+  t0 = now_ms();
+  if (pix_sat_init(&p, tp)) { tpool_free(tp); pix_bits_free(&p); return -1; }
+  ms[4] = now_ms() - t0;
+  tpool_free(tp);
+
+  /* keep the planes, pix_bits_free() would free them */
+  r->bits = p.bits; p.bits = NULL;
+  r->sat = p.sat; p.sat = NULL;
+  *x = p.x; *y = p.y;
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  res_t r1, r;
+  double ms[NSTEP], best[NSTEP], sum, sum1 = 0;
+  int nt, maxt = 4, rep = 3, i, j, x = 0, y = 0, same, err = 0;
+  size_t n, nb;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s page.pnm [threads [repeat]]\n", argv[0]);
+    return 1;
+  }
+  if (argc > 2) maxt = atoi(argv[2]);
+  if (argc > 3) rep = atoi(argv[3]);
+  if (maxt < 1) maxt = 1;
+  if (rep < 1) rep = 1;
+  memset(&r1, 0, sizeof(r1));
+  memset(&r, 0, sizeof(r));
+
+  printf("# threads");
+  for (j = 0; j < NSTEP; j++) printf(" %8s", step_name[j]);
+  printf("    total speedup result\n");
+  for (nt = 1; nt <= maxt; nt++) {
+    for (j = 0; j < NSTEP; j++) best[j] = 1e30;
+    for (i = 0; i < rep; i++) {
+      res_free(&r);
+      if (run(argv[1], nt, ms, &r, &x, &y) < 0) { fprintf(stderr, "ERROR %s\n", argv[1]); return 1; }
+      for (j = 0; j < NSTEP; j++) if (ms[j] < best[j]) best[j] = ms[j];
+    }
+    n = (size_t)x * y;
+    nb = (size_t)((x + PIXWORD_BITS - 1) / PIXWORD_BITS) * y;
+    if (nt == 1) { r1 = r; memset(&r, 0, sizeof(r)); same = 1; }
+    else same = !memcmp(r.gray, r1.gray, n)
+             && !memcmp(r.otsu, r1.otsu, n)
+             && !memcmp(r.local, r1.local, n)
+             && !memcmp(r.bits, r1.bits, nb * sizeof(pixword_t))
+             && !memcmp(r.sat, r1.sat,
+                        (size_t)(x + 1) * (y + 1) * sizeof(pixsat_t));
+    if (!same) err++;
+    for (sum = 0, j = 0; j < NSTEP; j++) sum += best[j];
+    if (nt == 1) sum1 = sum;
+    printf("  %7d", nt);
+    for (j = 0; j < NSTEP; j++) printf(" %8.1f", best[j]);
+    printf(" %8.1f %7.2f %s\n", sum, (sum > 0) ? sum1 / sum : 0.,
+           (same) ? "same" : "DIFFERS");
+  }
+  printf("# %s %dx%d, ms (best of %d)\n", argv[1], x, y, rep);
+  res_free(&r);
+  res_free(&r1);
+  return (err) ? 1 : 0;
+}
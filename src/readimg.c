@@ -0,0 +1,283 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2019  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for EMAIL-address
+
+ in-process decoding of input files, v0.53
+   png (libpng), jpeg (libjpeg) and gzip (zlib) files are decoded without
+   fork+exec of pngtopnm, djpeg or gzip and without the pipe copy,
+   the file type is taken from the magic bytes, the suffix is only used
+   for files of unknown type (as before)
+   formats without library (configure --without-png etc.) go to
+   the external programs of xlist (pnm.c), pnm data to the pnm reader
+
+   ToDo: tiff (libtiff), multi-image gif
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_PNG_H
+#include <png.h>  /* before setjmp.h, libpng-1.2 complains else */
+#endif
+#ifdef HAVE_JPEGLIB_H
+#include <setjmp.h>
+#include <jpeglib.h>
+#endif
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#include "pnm.h"
+
+#define EE()         fprintf(stderr,"\nERROR "__FILE__" L%d: ",__LINE__)
+#define E0(x0)       {EE();fprintf(stderr,x0 "\n");      }
+#define E1(x0,x1)    {EE();fprintf(stderr,x0 "\n",x1);   }
+
+/* file types, known by the 1st bytes */
+#define IMG_UNKNOWN 0
+#define IMG_PNG     1
+#define IMG_JPEG    2
+#define IMG_GZIP    3
+#define IMG_OTHER   4  /* no decoder here, use the converter of suffix */
+
+static struct {
+  int type, len;
+  const char *magic;
+  char *suffix;  /* suffix of xlist (pnm.c), for the converter */
+} mlist[] = {
+  { IMG_PNG,   8, "\x89PNG\r\n\x1a\n", ".png" },
+  { IMG_JPEG,  3, "\xff\xd8\xff",      ".jpg" },
+  { IMG_GZIP,  2, "\x1f\x8b",          ".pnm.gz" },
+  { IMG_OTHER, 3, "BZh",               ".pnm.bz2" },
+  { IMG_OTHER, 4, "GIF8",              ".gif" },
+  { IMG_OTHER, 2, "BM",                ".bmp" },
+  { IMG_OTHER, 4, "II*\0",             ".tiff" },
+  { IMG_OTHER, 4, "MM\0*",             ".tiff" },
+  { IMG_OTHER, 4, "%PDF",              ".pdf" },
+  { IMG_OTHER, 4, "%!PS",              ".ps" },
+  { IMG_OTHER, 4, "#FIG",              ".fig" },
+  { IMG_UNKNOWN, 0, NULL, NULL }
+};
+
+/* ppm to gray as in pnm.c */
+#define RGB2GRAY(r,g,b) ( ((PPM_RED_WEIGHT   * (r) + 511)>>10) \
+                        + ((PPM_GREEN_WEIGHT * (g) + 511)>>10) \
+                        + ((PPM_BLUE_WEIGHT  * (b) + 511)>>10) )
+
+/* set p to the decoded gray image pic */
+static void set_pix(pix *p, unsigned char *pic, int x, int y) {
+  p->p = pic;
+  p->x = x;
+  p->y = y;
+  p->bpp = 1;
+  p->bits = NULL;
+  p->fbits = NULL;
+  p->sat = NULL;
+  p->marks = NULL;
+}
+
+/* same limit as the pnm reader, x*y must fit into an int */
+static int bad_size(unsigned long x, unsigned long y) {
+  return (x < 1 || y < 1 || (1.*x)*y*3 > 2147483647.);
+}
+
+#ifdef HAVE_PNG_H
+/* palette, 16bit and alpha are reduced by libpng, rgb by PPM_*_WEIGHT */
+static int read_png(FILE *f1, pix *p, int vvv) {
+  png_structp png;
+  png_infop info;
+  png_uint_32 x, y;
+  int depth, ctype, nc, i;
+  unsigned char * volatile pic = NULL;
+  png_bytep * volatile rows = NULL;
+  size_t bpl;
+
+  png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (!png) { E0("png_create_read_struct"); return -1; }
+  info = png_create_info_struct(png);
+  if (!info) { png_destroy_read_struct(&png, NULL, NULL);
+    E0("png_create_info_struct"); return -1; }
+  if (setjmp(png_jmpbuf(png))) { /* libpng has printed the reason */
+    png_destroy_read_struct(&png, &info, NULL);
+    free(rows); free(pic);
+    E0("decoding png"); return -1;
+  }
+  png_init_io(png, f1);
+  png_read_info(png, info);
+  png_get_IHDR(png, info, &x, &y, &depth, &ctype, NULL, NULL, NULL);
+  if (bad_size(x, y)) {
+    png_destroy_read_struct(&png, &info, NULL);
+    E0("bad png size"); return -1; }
+  if (ctype == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+  if (ctype == PNG_COLOR_TYPE_GRAY && depth < 8)
+    png_set_expand_gray_1_2_4_to_8(png);
+  if (depth == 16) png_set_strip_16(png);
+  if (ctype & PNG_COLOR_MASK_ALPHA) png_set_strip_alpha(png);
+  png_set_interlace_handling(png);
+  png_read_update_info(png, info);
+  nc = png_get_channels(png, info); /* 1=gray 3=rgb */
+  bpl = png_get_rowbytes(png, info);
+  if (vvv)
+    fprintf(stderr, "# readimg: png h*w=%lu*%lu depth=%d colortype=%d\n",
+      (unsigned long)y, (unsigned long)x, depth, ctype);
+  pic  = (unsigned char *)malloc(bpl * y);
+  rows = (png_bytep *)malloc(y * sizeof(png_bytep));
+  if (!pic || !rows) {
+    png_destroy_read_struct(&png, &info, NULL);
+    free(rows); free(pic);
+    E1("Error at malloc: %lu bytes", (unsigned long)(bpl * y)); return -1; }
+  for (i = 0; i < (int)y; i++) rows[i] = pic + i * bpl;
+  png_read_image(png, rows);
+  png_read_end(png, NULL);
+  png_destroy_read_struct(&png, &info, NULL);
+  free(rows);
+  if (nc == 3) { /* in place, the gray byte is left of its rgb bytes */
+    for (i = 0; i < (int)(x * y); i++)
+      pic[i] = RGB2GRAY(pic[3*i], pic[3*i+1], pic[3*i+2]);
+  } else if (nc != 1) {
+    free(pic); E1("unexpected png channels %d", nc); return -1; }
+  set_pix(p, pic, x, y);
+  return 0;
+}
+#endif
+
+#ifdef HAVE_JPEGLIB_H
+/* libjpeg calls exit() on errors by default, we return -1 instead */
+struct jpeg_err_s {
+  struct jpeg_error_mgr pub;
+  jmp_buf jb;
+};
+
+static void jpeg_err_exit(j_common_ptr ci) {
+  struct jpeg_err_s *err = (struct jpeg_err_s *)ci->err;
+  (*ci->err->output_message)(ci);
+  longjmp(err->jb, 1);
+}
+
+/* gray output of libjpeg, same as djpeg -gray */
+static int read_jpeg(FILE *f1, pix *p, int vvv) {
+  struct jpeg_decompress_struct ci;
+  struct jpeg_err_s err;
+  unsigned char * volatile pic = NULL;
+  JSAMPROW row;
+
+  ci.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = jpeg_err_exit;
+  if (setjmp(err.jb)) {
+    jpeg_destroy_decompress(&ci);
+    free(pic);
+    E0("decoding jpeg"); return -1;
+  }
+  jpeg_create_decompress(&ci);
+  jpeg_stdio_src(&ci, f1);
+  jpeg_read_header(&ci, TRUE);
+  ci.out_color_space = JCS_GRAYSCALE;
+  jpeg_start_decompress(&ci);
+  if (vvv)
+    fprintf(stderr, "# readimg: jpeg h*w=%u*%u components=%d\n",
+      (unsigned)ci.output_height, (unsigned)ci.output_width,
+      ci.num_components);
+  if (bad_size(ci.output_width, ci.output_height)) {
+    jpeg_destroy_decompress(&ci);
+    E0("bad jpeg size"); return -1; }
+  pic = (unsigned char *)malloc(ci.output_width * ci.output_height);
+  if (!pic) {
+    jpeg_destroy_decompress(&ci);
+    E1("Error at malloc: %lu bytes",
+      (unsigned long)ci.output_width * ci.output_height); return -1; }
+  while (ci.output_scanline < ci.output_height) {
+    row = pic + ci.output_scanline * ci.output_width;
+    jpeg_read_scanlines(&ci, &row, 1);
+  }
+  jpeg_finish_decompress(&ci);
+  set_pix(p, pic, ci.output_width, ci.output_height);
+  jpeg_destroy_decompress(&ci);
+  return 0;
+}
+#endif
+
+#ifdef HAVE_ZLIB_H
+/* decompress to a temporary file, which goes to the pnm reader
+ *  (handles multi-image files as the pipe of gzip -cd did before) */
+static FILE *gunzip_tmp(char *name, int vvv) {
+  gzFile gz;
+  FILE *f2;
+  char buf[16384];
+  int n;
+
+  gz = gzopen(name, "rb");
+  if (!gz) { E1("opening file %s", name); return NULL; }
+  f2 = tmpfile();
+  if (!f2) { gzclose(gz); E0("tmpfile failed"); return NULL; }
+  while ((n = gzread(gz, buf, sizeof(buf))) > 0)
+    if ((int)fwrite(buf, 1, n, f2) != n) { n = -1; break; }
+  gzclose(gz);
+  if (n < 0) { fclose(f2); E1("decompressing %s", name); return NULL; }
+  if (vvv) fprintf(stderr, "# readimg: gzip %ld bytes\n", ftell(f2));
+  rewind(f2);
+  return f2;
+}
+#endif
+
+int readimg(pnm_stream_t *st, char *name, pix *p, int vvv) {
+  FILE *f1;
+  unsigned char m[8];
+  int i, n, rc;
+
+  st->f1 = NULL;
+  st->pip = NULL;
+  f1 = fopen(name, "rb");
+  if (!f1) { E1("opening file %s", name); return -1; }
+  n = fread(m, 1, sizeof(m), f1);
+  rewind(f1);
+  if (n >= 2 && m[0] == 'P' && m[1] >= '1' && m[1] <= '7') { /* pnm, pam */
+    st->f1 = f1;
+    return 1;
+  }
+  for (i = 0; mlist[i].type != IMG_UNKNOWN; i++)
+    if (n >= mlist[i].len && memcmp(m, mlist[i].magic, mlist[i].len) == 0)
+      break;
+  rc = 2; /* not decoded */
+  switch (mlist[i].type) {
+#ifdef HAVE_PNG_H
+    case IMG_PNG:  rc = read_png(f1, p, vvv);  break;
+#endif
+#ifdef HAVE_JPEGLIB_H
+    case IMG_JPEG: rc = read_jpeg(f1, p, vvv); break;
+#endif
+#ifdef HAVE_ZLIB_H
+    case IMG_GZIP:
+      fclose(f1);
+      st->f1 = gunzip_tmp(name, vvv);
+      return (st->f1) ? 1 : -1;
+#endif
+    default: break;
+  }
+  if (rc != 2) { fclose(f1); return rc; }
+  /* external converter, the magic bytes win over the suffix */
+  if (mlist[i].suffix) st->pip = testsuffix(mlist[i].suffix);
+  if (!st->pip) st->pip = testsuffix(name);
+  if (!st->pip) { /* the pnm reader will complain about the magic bytes */
+    st->f1 = f1;
+    return 1;
+  }
+  fclose(f1);
+  return 1;
+}
@@ -28,7 +28,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 /* measure mean thickness as an criteria for big chars */
 int mean_thickness( struct box *box2 ){
-  int mt=0, i, y, dx=box2->x1-box2->x0+1, dy, cs=OCR_JOB->cfg.cs;
+  int mt=0, i, y, dx=box2->x1-box2->x0+1, dy, cs=box2->p->job->cfg.cs;
   for (y=box2->y0+1; y<box2->y1; y++) {
     i=loop(box2->p,box2->x0+0,y,dx,cs,0,RI);
     i=loop(box2->p,box2->x0+i,y,dx,cs,1,RI);
@@ -306,8 +306,8 @@ int box_covered( struct box *box1, struct box *box2){
  *   should be renamed to remove_pictures and border boxes
  */
 int remove_pictures( job_t *job){
-  struct box *box4,*box2;
-  int j=0, j2=0, num_del=0;
+  struct box *box4,*box2, **nb=NULL; /* nb = boxes near box2 */
+  int j=0, j2=0, num_del=0, i, n, nnb=0;
 
   if (job->cfg.verbose)
     fprintf(stderr, "# "__FILE__" L%d: remove pictures\n# ...",
@@ -324,6 +324,7 @@ int remove_pictures( job_t *job){
     fprintf(stderr," status: pictures= %d  other= %d  nC= %d\n# ...",
             j, j2, job->res.numC);
 
+  box_grid_build(&job->tmp.boxgrid, job);
   /* remove table frames */
   if (job->res.numC > 8)
   for_each_data(&(job->res.boxlist)) {
@@ -333,11 +334,13 @@ int remove_pictures( job_t *job){
      && box2->x1-box2->x0+1>box2->p->x/2  /* big table? */
      && box2->y1-box2->y0+1>box2->p->y/2 ){ j=0;
       /* count boxes nested with the picture */
-      for_each_data(&(job->res.boxlist)) {
-        box4 = (struct box *)list_get_current(&(job->res.boxlist));
+      n = box_grid_query(&job->tmp.boxgrid, box2->x0-1, box2->y0-1,
+                         box2->x1+1, box2->y1+1, &nb, &nnb);
+      for (i=0; i<n; i++) {
+        box4 = nb[i];
         if( box4 != box2 )  /* not count itself */
         if (box_nested(box4,box2)) j++;  /* box4 in box2 */
-      } end_for_each(&(job->res.boxlist));
+      }
       if( j>8 ){ /* remove box if more than 8 chars are within box */
         list_del(&(job->res.boxlist), box2); /* does not work proper ?! */
         free_box(box2); num_del++;
@@ -399,8 +402,10 @@ int remove_pictures( job_t *job){
         j=0; box4=NULL;
         /* find boxes nested with the picture and remove */
         /* its for pictures build by compounds */
-        for_each_data(&(job->res.boxlist)) {
-          box4 = (struct box *)list_get_current(&(job->res.boxlist));
+        n = box_grid_query(&job->tmp.boxgrid, box2->x0-1, box2->y0-1,
+                           box2->x1+1, box2->y1+1, &nb, &nnb);
+        for (i=0; i<n; i++) {
+          box4 = nb[i];
           if(  box4!=box2   /* not destroy self */
            && (box4->num_ac==0)  /* dont remove barcodes etc. */ 
            && (/* box4->c==UNKNOWN || */
@@ -424,10 +429,11 @@ int remove_pictures( job_t *job){
             if( box4->x1>box2->x1 ) box2->x1=box4->x1;
             if( box4->y0<box2->y0 ) box2->y0=box4->y0;
             if( box4->y1>box2->y1 ) box2->y1=box4->y1;
+            box_grid_update(box2);
             j=1;   /* mark box4 as valid   */
             break; /* and leave inner loop */
           }
-        } end_for_each(&(job->res.boxlist));
+        }
         if (j!=0 && box4!=NULL) { /* check for valid box4 */
           /* ToDo: melt */
           list_del(&(job->res.boxlist), box4); /* does not work proper ?! */
@@ -439,6 +445,8 @@ int remove_pictures( job_t *job){
     } end_for_each(&(job->res.boxlist)); 
   }
 
+  box_grid_free(&job->tmp.boxgrid);
+  if (nb) free(nb);
   if (job->cfg.verbose)
     fprintf(stderr, " deleted= %d nested pictures\n# ...", num_del);
 
@@ -473,7 +481,6 @@ int remove_pictures( job_t *job){
 int remove_melted_serifs( job_t *job, pix *pp ){
   int x,y,j1,j2,j3,j4,i2,i3,i,ii,ni,cs,x0,x1,xa,xb,y0,y1,vvv;
   struct box *box2, *box3;
-  // job_t *job=OCR_JOB;
   progress_counter_t *pc = NULL;
 
   vvv=job->cfg.verbose; cs=job->cfg.cs; i=0; ii=0; ni=0;
@@ -546,7 +553,7 @@ int remove_melted_serifs( job_t *job, pix *pp ){
 	if( get_bw(j2   ,j2   ,y0,(y0+y1)/2,pp,cs,1) == 0
 	 && get_bw(j2+xb,j2+xb,(y0+y1)/2,i3,pp,cs,1) == 0 )
 	{ /* divide */
-	  box3=malloc_box(box2);
+	  box3=box_pool_get(&job->tmp.boxpool,box2);
 	  box3->x1=j2-1;
 	  box2->x0=j2+1; x1=box2->x1;
 	  cut_box(box2); /* cut vectors outside the box, see box.c */
@@ -617,7 +624,7 @@ int remove_melted_serifs( job_t *job, pix *pp ){
 	if( get_bw(j2   ,j2   ,(y0+y1)/2,y1,pp,cs,1) == 0
 	 && get_bw(j2+xb,j2+xb,y0,(y0+y1)/2,pp,cs,1) == 0 )
 	{ /* divide */
-	  box3=malloc_box(box2);
+	  box3=box_pool_get(&job->tmp.boxpool,box2);
 	  box3->x1=j2-1;
 	  box2->x0=j2; x1=box2->x1;
 	  cut_box(box2); /* cut vectors outside the box */
@@ -642,7 +649,6 @@ int remove_melted_serifs( job_t *job, pix *pp ){
     - dust around the border
  */
 int remove_rest_of_dust( job_t *job ) {
-  //  job_t *job=OCR_JOB;
   int i1, i2, vvv = job->cfg.verbose, x0, x1, y0, y1, cnt=0;
   struct box *box2, *box4;
   progress_counter_t *pc = NULL;
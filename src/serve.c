@@ -0,0 +1,273 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2010  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ server mode (gocr --serve), v0.53
+   the database (-m 2) and the filter tables of getpixel() are loaded
+   once and used for every request, instead of once per gocr call
+
+   gocr [options] --serve         frames on stdin, results on stdout
+   gocr [options] --serve=path    listen on unix socket path,
+                                  one process (fork) per connection
+
+ request:  "pnm <len> [options]\n" + <len> bytes of a pnm image
+           "gray <width> <height> [options]\n" + width*height gray bytes
+           "quit\n"  closes the connection
+ options:  -l -s -d -a -n -m -f -C -u as on the command line,
+           valid for this request only
+ answer:   "ok <len>\n" + <len> bytes text (the output of gocr)
+           "err <len>\n" + <len> bytes error message
+
+ ToDo: threads instead of fork, the dblist is not read-only yet
+       malformed pnm data still exit() in pnm.c (stdin mode stops)
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if defined(HAVE_SYS_SOCKET_H) && defined(HAVE_SYS_UN_H) && defined(HAVE_FORK)
+#define SERVE_SOCKET 1
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "pnm.h"
+#include "pgm2asc.h"
+#include "gocr.h"
+
+#define HDRLEN 1024 /* max. length of a request line */
+
+/* growing byte buffer, used for image data and answers */
+typedef struct {
+  char *p;
+  int len, max;
+} buf_t;
+
+static int buf_grow(buf_t *b, int len) {
+  char *p;
+  if (len <= b->max) return 0;
+  p = (char *)realloc(b->p, len);
+  if (!p) return -1;
+  b->p = p; b->max = len;
+  return 0;
+}
+
+static int buf_cat(buf_t *b, const char *s) {
+  int n = strlen(s);
+  if (buf_grow(b, b->len + n + 1)) return -1;
+  memcpy(b->p + b->len, s, n + 1);
+  b->len += n;
+  return 0;
+}
+
+static void answer(FILE *out, const char *tag, const char *s, int len) {
+  fprintf(out, "%s %d\n", tag, len);
+  if (len) fwrite(s, 1, len, out);
+  fflush(out);
+}
+
+/* set options of a request line, returns NULL or an error message */
+static const char *set_options(job_t *job, char *s) {
+  char *opt, *val;
+  for (;;) {
+    opt = strtok(s, " \t\r\n"); s = NULL;
+    if (!opt) return NULL;
+    if (opt[0] != '-' || opt[1] == 0 || opt[2] != 0)
+      return "bad option";
+    val = strtok(NULL, " \t\r\n");
+    if (!val) return "missing option value";
+    switch (opt[1]) {
+    case 'l': job->cfg.cs           = atoi(val); break;
+    case 's': job->cfg.spc          = atoi(val); break;
+    case 'd': job->cfg.dust_size    = atoi(val); break;
+    case 'a': job->cfg.certainty    = atoi(val); break;
+    case 'n': job->cfg.only_numbers = atoi(val); break;
+    /* interactive mode would read from our input, v0.53 */
+    case 'm': job->cfg.mode         = atoi(val) & ~128; break;
+    case 'f':
+      if (strcmp(val, "ISO8859_1") == 0) job->cfg.out_format=ISO8859_1; else
+      if (strcmp(val, "TeX")       == 0) job->cfg.out_format=TeX; else
+      if (strcmp(val, "HTML")      == 0) job->cfg.out_format=HTML; else
+      if (strcmp(val, "XML")       == 0) job->cfg.out_format=XML; else
+      if (strcmp(val, "SGML")      == 0) job->cfg.out_format=SGML; else
+      if (strcmp(val, "UTF8")      == 0) job->cfg.out_format=UTF8; else
+      if (strcmp(val, "ASCII")     == 0) job->cfg.out_format=ASCII; else
+        return "unknown format";
+      break;
+    /* strings point into the request line, which lives until the answer */
+    case 'C': job->cfg.cfilter      = val; break;
+    case 'u': job->cfg.unrec_marker = val; break;
+    default: return "unknown option";
+    }
+  }
+}
+
+/* read a pnm image from the len bytes of img to job->src.p
+ *  the reader wants a FILE, so the image goes through a temporary file */
+static const char *read_pnm(job_t *job, buf_t *img) {
+  pnm_stream_t st;
+  FILE *f1;
+  int rc;
+  f1 = tmpfile();
+  if (!f1) return "tmpfile failed";
+  if ((int)fwrite(img->p, 1, img->len, f1) != img->len) {
+    fclose(f1); return "tmpfile failed"; }
+  rewind(f1);
+  pnm_stream_init(&st);
+  st.threads = job->cfg.threads;
+  st.f1 = f1;           /* continue an open stream, 1st byte read ahead */
+  st.c1 = fgetc(f1);
+  /* name "-" tells the reader not to close f1 */
+  rc = readpgm_stream(&st, "-", &job->src.p, job->cfg.verbose);
+  fclose(f1);
+  return (rc < 0) ? "bad pnm image" : NULL;
+}
+
+/* handle one request, returns 0 if the next request can follow */
+static int serve_request(job_t *job, FILE *in, FILE *out,
+                         buf_t *img, buf_t *txt) {
+  char hdr[HDRLEN], *s, *kind;
+  const char *err = NULL, *line;
+  long w = 0, h = 0, len = 0;
+  int i;
+
+  if (!fgets(hdr, HDRLEN, in)) return 1; /* EOF */
+  kind = strtok(hdr, " \t\r\n");
+  if (!kind) return 0;  /* skip empty lines */
+  if (strcmp(kind, "quit") == 0) return 1;
+
+  /* the size is needed to find the next request, so errors are fatal */
+  if (strcmp(kind, "gray") == 0) {
+    s = strtok(NULL, " \t\r\n"); if (s) w = atol(s);
+    s = strtok(NULL, " \t\r\n"); if (s) h = atol(s);
+    if (w > 0 && h > 0 && w * h / h == w && w * h < 0x7fffffffL) len = w * h;
+  } else if (strcmp(kind, "pnm") == 0) {
+    s = strtok(NULL, " \t\r\n"); if (s) len = atol(s);
+    if (len >= 0x7fffffffL) len = 0;
+  } else err = "unknown request";
+  if (!err && len <= 0) err = "bad image size";
+  if (!err && buf_grow(img, (int)len)) err = "out of memory";
+  if (!err && (long)fread(img->p, 1, len, in) != len) err = "short image";
+  if (err) { answer(out, "err", err, strlen(err)); return 1; }
+  img->len = (int)len;
+
+  job_init_image(job);
+  err = set_options(job, NULL);
+  if (!err) {
+    if (kind[0] == 'g') { /* take the buffer, job_free_image frees it */
+      job->src.p.p = (unsigned char *)img->p;
+      job->src.p.x = w; job->src.p.y = h; job->src.p.bpp = 1;
+      img->p = NULL; img->len = img->max = 0;
+    } else err = read_pnm(job, img);
+  }
+  if (!err) {
+    pgm2asc(job);
+    txt->len = 0;
+    for (i = 0; (line = getTextLine(&job->res.linelist, i)) != NULL; i++) {
+      if (buf_cat(txt, line)
+       || (job->cfg.out_format == HTML && buf_cat(txt, "<br />"))
+       || (job->cfg.out_format != XML  && buf_cat(txt, "\n"))) {
+        err = "out of memory"; break;
+      }
+    }
+    free_textlines(&job->res.linelist);
+  }
+  if (err) answer(out, "err", err, strlen(err));
+  else     answer(out, "ok", txt->p, txt->len);
+  job_free_image(job);
+  return 0;
+}
+
+/* serve requests of one connection, options are reset for every request */
+static void serve_stream(job_t *job, FILE *in, FILE *out) {
+  job_t job0;     /* only job0.cfg is used, the options of the command line */
+  buf_t img = { NULL, 0, 0 }, txt = { NULL, 0, 0 };
+  job0.cfg = job->cfg;
+  for (;;) {
+    job->cfg = job0.cfg;
+    if (serve_request(job, in, out, &img, &txt)) break;
+  }
+  job->cfg = job0.cfg;
+  free(img.p);
+  free(txt.p);
+}
+
+#ifdef SERVE_SOCKET
+static int serve_socket(job_t *job, const char *path) {
+  struct sockaddr_un addr;
+  int fd, cfd;
+  pid_t pid;
+  FILE *in, *out;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "ERROR serve: socket path too long\n"); return -1; }
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) { perror("serve: socket"); return -1; }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path); /* remove an old socket */
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+   || listen(fd, 64) < 0) {
+    perror("serve: bind"); close(fd); return -1; }
+  signal(SIGCHLD, SIG_IGN); /* children are reaped by the system */
+  if (job->cfg.verbose) fprintf(stderr, "# serve on %s\n", path);
+  for (;;) {
+    cfd = accept(fd, NULL, NULL);
+    if (cfd < 0) {
+      if (errno == EINTR) continue;
+      perror("serve: accept"); break;
+    }
+    pid = fork(); /* the child gets a copy of the loaded db */
+    if (pid > 0) { close(cfd); continue; }
+    if (pid == 0) close(fd);  /* child, pid<0: serve it ourself */
+    in  = fdopen(cfd, "rb");
+    out = fdopen(dup(cfd), "wb");
+    if (in && out) serve_stream(job, in, out);
+    if (in)  fclose(in);
+    if (out) fclose(out);
+    if (pid == 0) _exit(0);
+  }
+  close(fd);
+  return -1;
+}
+#endif
+
+/* main loop of gocr --serve[=path], path==NULL means stdin/stdout */
+int serve(job_t *job, const char *path) {
+  job->cfg.mode &= ~128;  /* no interactive mode, stdin is our input */
+  pixel_filter_init(job); /* build once, not per request or connection */
+  if (!path) {
+    serve_stream(job, stdin, stdout);
+    return 0;
+  }
+#ifdef SERVE_SOCKET
+  return serve_socket(job, path);
+#else
+  fprintf(stderr, "ERROR: compiled without unix sockets, use --serve\n");
+  return -1;
+#endif
+}
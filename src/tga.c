@@ -79,7 +79,7 @@ void readtga(char *name,pix *p,int mode){	 // see pcx.format.txt
   }
   else assert(0);		// wrong mode
   fclose(f1);
-  p->p=pic;  p->x=nx;  p->y=ny; p->bpp=1+2*mode;
+  p->p=pic;  p->x=nx;  p->y=ny; p->bpp=1+2*mode; p->bits=NULL; p->fbits=NULL; p->sat=NULL; p->marks=NULL;
   fprintf(stderr," mode=%d\n",mode);
 }
 
@@ -0,0 +1,158 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2026  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+
+ thread pool for the preprocessing kernels, v0.53
+   the pixel kernels of an image (conversion, otsu, thresholding,
+   packed plane, summed-area table) are maps over rows or histograms,
+   tpool_for() cuts the rows into one part per thread, the kernels
+   keep one histogram per part and merge them at the end, so the
+   result does not depend on the number of threads
+
+   the pool lives as long as the image (job->tmp.pool), the workers
+   sleep between the kernels, the thread count is --threads=n
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "tpool.h"
+
+struct tpool_s {
+  int n;                 /* threads including the caller */
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t mutex;
+  pthread_cond_t go;     /* new generation or quit */
+  pthread_cond_t done;   /* busy == 0 */
+  int gen;               /* generation of the current tpool_for() */
+  int busy;              /* parts not finished */
+  int quit;
+  tpool_fn fn;
+  void *arg;
+  int items;
+  struct tpool_w_s *w;
+#endif
+};
+
+#ifdef HAVE_PTHREAD_H
+typedef struct tpool_w_s {
+  pthread_t tid;
+  tpool_t *tp;
+  int id;
+} tpool_w_t;
+
+static void tpool_part(tpool_t *tp, int id) {
+  int i0 = (int)((double)tp->items * id / tp->n),
+      i1 = (int)((double)tp->items * (id + 1) / tp->n);
+  if (i1 > i0) tp->fn(tp->arg, i0, i1, id);
+}
+
+static void *tpool_worker(void *arg) {
+  tpool_w_t *w = (tpool_w_t *)arg;
+  tpool_t *tp = w->tp;
+  int gen = 0;
+
+  for (;;) {
+    pthread_mutex_lock(&tp->mutex);
+    while (tp->gen == gen && !tp->quit)
+      pthread_cond_wait(&tp->go, &tp->mutex);
+    if (tp->quit) { pthread_mutex_unlock(&tp->mutex); break; }
+    gen = tp->gen;
+    pthread_mutex_unlock(&tp->mutex);
+    tpool_part(tp, w->id);
+    pthread_mutex_lock(&tp->mutex);
+    if (--tp->busy == 0) pthread_cond_signal(&tp->done);
+    pthread_mutex_unlock(&tp->mutex);
+  }
+  return NULL;
+}
+#endif
+
+tpool_t *tpool_new(int n) {
+#ifdef HAVE_PTHREAD_H
+  tpool_t *tp;
+  int i;
+
+  if (n < 2) return NULL;
+  tp = (tpool_t *)calloc(1, sizeof(tpool_t));
+  if (!tp) return NULL;
+  tp->w = (tpool_w_t *)calloc(n, sizeof(tpool_w_t));
+  if (!tp->w) { free(tp); return NULL; }
+  pthread_mutex_init(&tp->mutex, NULL);
+  pthread_cond_init(&tp->go, NULL);
+  pthread_cond_init(&tp->done, NULL);
+  for (i = 1; i < n; i++) { /* worker 0 is the caller of tpool_for() */
+    tp->w[i].tp = tp;
+    tp->w[i].id = i;
+    if (pthread_create(&tp->w[i].tid, NULL, tpool_worker, &tp->w[i])) break;
+  }
+  tp->n = i; /* less threads if pthread_create failed */
+  if (tp->n < 2) { tpool_free(tp); return NULL; }
+  return tp;
+#else
+  return NULL;
+#endif
+}
+
+void tpool_free(tpool_t *tp) {
+#ifdef HAVE_PTHREAD_H
+  int i;
+  if (!tp) return;
+  pthread_mutex_lock(&tp->mutex);
+  tp->quit = 1;
+  pthread_cond_broadcast(&tp->go);
+  pthread_mutex_unlock(&tp->mutex);
+  for (i = 1; i < tp->n; i++) pthread_join(tp->w[i].tid, NULL);
+  pthread_cond_destroy(&tp->done);
+  pthread_cond_destroy(&tp->go);
+  pthread_mutex_destroy(&tp->mutex);
+  free(tp->w);
+  free(tp);
+#endif
+}
+
+int tpool_size(tpool_t *tp) {
+  return (tp) ? tp->n : 1;
+}
+
+void tpool_for(tpool_t *tp, int n, tpool_fn fn, void *arg) {
+  if (n <= 0) return;
+#ifdef HAVE_PTHREAD_H
+  if (tp) {
+    pthread_mutex_lock(&tp->mutex);
+    tp->fn = fn;
+    tp->arg = arg;
+    tp->items = n;
+    tp->busy = tp->n - 1;
+    tp->gen++;
+    pthread_cond_broadcast(&tp->go);
+    pthread_mutex_unlock(&tp->mutex);
+    tpool_part(tp, 0);
+    pthread_mutex_lock(&tp->mutex);
+    while (tp->busy > 0) pthread_cond_wait(&tp->done, &tp->mutex);
+    pthread_mutex_unlock(&tp->mutex);
+    return;
+  }
+#endif
+  fn(arg, 0, n, 0);
+}
@@ -0,0 +1,40 @@
+/*
+This is a Optical-Character-Recognition program
+Copyright (C) 2000-2026  Joerg Schulenburg
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ see README for email address
+ */
+
+#ifndef GOCR_TPOOL_H
+#define GOCR_TPOOL_H
+
+/* thread pool of the preprocessing kernels (parallel for), v0.53 */
+typedef struct tpool_s tpool_t;
+
+/* fn(arg, i0, i1, id) does the items i0..i1-1, part id of tpool_size() */
+typedef void (*tpool_fn)(void *arg, int i0, int i1, int id);
+
+/* pool of n threads (the caller is one of them), NULL for n<2, if
+ *  there is no pthread or no memory, NULL is a valid pool of 1 thread */
+tpool_t *tpool_new(int n);
+void tpool_free(tpool_t *tp);
+int  tpool_size(tpool_t *tp);
+/* split 0..n-1 into tpool_size() parts and wait until all are done,
+ *  part 0 runs on the calling thread, parts are contiguous and ordered */
+void tpool_for(tpool_t *tp, int n, tpool_fn fn, void *arg);
+
+#endif
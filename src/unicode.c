@@ -404,16 +404,13 @@ wchar_t compose(wchar_t main, wchar_t modifier) {
 
 #define UNDEFINED			"~"
 
-/* Arguments: character in Unicode format, type of format to convert to.
+/* Arguments: character in Unicode format, type of format to convert to,
+    buf of DECODE_BUFLEN bytes for UTF8 sequences and undefined codes.
    Returns: a string containing the Unicode character converted to the chosen
-    format. This string is statically allocated and should not be freed.
+    format, stored in buf or a string constant. Reentrant (v0.53).
    ToDo: better using tables?
  */
-const char *decode(wchar_t c, FORMAT type) {
-  /* static char d;  --- js: big bug (missing \0) if &d returned */
-  /*FIXME jb static*/ static char bbuf[8*32]; /* space for 8 buffers, rotating */
-  /*FIXME jb static*/ static char *buf=bbuf;  /* used for UTF8 sequences and undefined codes */
-  buf+=32; if(buf>=bbuf+8*32) buf=bbuf;
+const char *decode_r(wchar_t c, FORMAT type, char *buf) {
   buf[0]=buf[1]=buf[2]=0;
   switch (type) {
     case ISO8859_1:
@@ -1322,3 +1319,15 @@ const char *decode(wchar_t c, FORMAT type) {
       return (const char *)UNDEFINED;
   }
 }
+
+/* same as decode_r(), but the string is statically allocated
+ * and should not be freed, 8 rotating buffers allow up to 8 calls
+ * within one printf, not thread safe, the engine uses decode_r()
+ */
+const char *decode(wchar_t c, FORMAT type) {
+  /* static char d;  --- js: big bug (missing \0) if &d returned */
+  /*FIXME jb static*/ static char bbuf[8*DECODE_BUFLEN]; /* 8 buffers, rotating */
+  /*FIXME jb static*/ static char *buf=bbuf;
+  buf+=DECODE_BUFLEN; if(buf>=bbuf+8*DECODE_BUFLEN) buf=bbuf;
+  return decode_r(c, type, buf);
+}
@@ -52,7 +52,9 @@ typedef enum format FORMAT;
  * Prototypes
  */
 wchar_t compose(wchar_t main, wchar_t modifier);
-const char *decode(wchar_t c, FORMAT type);
+#define DECODE_BUFLEN 32  /* size of buf for decode_r() */
+const char *decode_r(wchar_t c, FORMAT type, char *buf); /* reentrant */
+const char *decode(wchar_t c, FORMAT type); /* static buffers, frontends */
 
 /*
  * Unicode codes moved to unicode_defs.h avoiding macro name conflicts